@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+
+/**
+* An allocator (malloc_func, calloc_func, free_func) through which all library allocations are made,
+* i.e., by board_make, board_copy, alst_make, alst_append growth, and move_make (when moves are not qwords).
+* The functions follow the contracts of malloc, calloc and free, and must be thread safe if the library is
+* used from several threads.
+*/
+typedef struct {
+    void *(*malloc_func)(size_t size);
+    void *(*calloc_func)(size_t n, size_t size);
+    void (*free_func)(void *ptr);
+} alloc_t;
+
+/**
+* Library allocation counters, summed over all threads.
+*/
+typedef struct {
+    uint64_t allocs;  // allocations made
+    uint64_t frees;  // non-NULL frees made
+    uint64_t bytes;  // bytes requested over all allocations
+} alloc_stats_t;
+
+/**
+* Makes the library allocate through (allocator), or through the C library if (allocator) is NULL.
+* Must not be called while the library holds any allocation made through the previous allocator.
+*/
+void alloc_set(const alloc_t *allocator);
+
+/**
+* Copies the library allocation counters into (dest).
+*/
+void alloc_stats(alloc_stats_t *dest);
+
+/**
+* Zeroes the library allocation counters.
+*/
+void alloc_reset_stats(void);
+
+/**
+* Forbids library allocations on the calling thread iff (forbid) is nonzero. A forbidden allocation reports
+* the offending request and exits, which makes it an assertion that a code path does not allocate.
+*/
+void alloc_forbid(int forbid);
+
+/**
+* Library allocation entry points, following the contracts of malloc, calloc and free.
+*/
+void *alloc_malloc(size_t size);
+void *alloc_calloc(size_t n, size_t size);
+void alloc_free(void *ptr);
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "defs.h"
+#include "board.h"
+#include "move.h"
+
+/**
+* Compact binary game archives, written and read as streams through large buffers.
+* An archive is the magic "CLGA" and a version (ARCHIVE_VERSION, uint32), followed by games, all integers
+* little-endian. Each game is:
+*   uint8 result (RESULT_*, see include/defs.h), uint8 start (0 for the starting position, 1 if a position
+*   follows), uint16 number of plies,
+*   if start is 1: uint32 ranks [8] and uint32 flags of the board_t of the starting position,
+*   a byte per ply: the rank of the move among the legal moves of the board, ordered by origin, destination and
+*   promotion piece.
+* Moves are ranked in an order of their own rather than that of the move generator, so archives stay readable
+* when move generation changes; reading them back replays the games, generating the legal moves of every board.
+* Being byte aligned and made mostly of small ranks, archives compress well with general purpose compressors.
+*/
+
+#define ARCHIVE_VERSION 1
+#define ARCHIVE_BUFFER (1 << 20)
+#define ARCHIVE_PLIES_MAX 65535
+
+typedef struct {
+    FILE *file;
+    uint8_t *buf;
+    size_t len;  // bytes in (buf)
+    size_t cap;  // bytes (buf) holds, for reading
+    size_t pos;  // next byte of (buf) to read
+    int writing;  // nonzero if the archive is being written
+    int error;
+    // the game read last
+    move_t *moves;
+    board_t *boards;
+    size_t movescap;
+} archive_t;
+
+/**
+* A game of an archive: its (len) moves, the (len + 1) boards before and after each of them, from the starting
+* position (boards[0]) to the last, and its result. (moves) and (boards) are owned by the archive, and valid until
+* the next game is read.
+*/
+typedef struct {
+    const move_t *moves;
+    const board_t *boards;
+    size_t len;
+    int result;
+} archive_game_t;
+
+/**
+* Creates the archive at (path), to write games to. Returns NULL if the file cannot be written.
+*/
+archive_t *archive_create(const char *path);
+
+/**
+* Opens the archive at (path), to read games from. Returns NULL if the file cannot be read, or is not an archive
+* of this version.
+*/
+archive_t *archive_open(const char *path);
+
+/**
+* Writes the game of the (len) legal moves played from the board (NULL for the starting position) with the result
+* (result), buffered. Games longer than ARCHIVE_PLIES_MAX plies are cut. Returns 0 on success, nonzero if the file
+* cannot be written, or if a move is not legal or ranks beyond 255 (only on boards with more pieces than games
+* have), in which case the game is not written.
+*/
+int archive_write(archive_t *archive, const board_t *start, const move_t *moves, size_t len, int result);
+
+/**
+* Reads the next game of the archive into (dest). Returns 1 if a game was read, 0 at the end of the archive, and -1
+* if the rest of the archive is not a game, e.g., it is cut short, or starts from a board that is not valid
+* (board_is_valid).
+*/
+int archive_read(archive_t *archive, archive_game_t *dest);
+
+/**
+* Closes the archive, writing what remains of its buffer if it is being written, and frees it. Returns 0 on
+* success, nonzero if the archive could not be written.
+*/
+int archive_close(archive_t *archive);
+
+/**
+* Returns the rank of (move) among the (len) legal moves (moves) in archive order, or -1 if it is not one of them.
+*/
+int archive_encode(const move_t *moves, size_t len, move_t move);
+
+/**
+* Returns the move of rank (rank) in archive order among the (len) legal moves (moves), or 0 if there is none.
+*/
+move_t archive_decode(const move_t *moves, size_t len, int rank);
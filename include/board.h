@@ -4,12 +4,22 @@
 #include "move.h"
 #include "arraylist.h"
 
+// capacity, in moves, of the buffer taken by board_get_moves_buf: a bound on the pseudo-legal moves of any board
+// board_make takes, whatever its pieces. A square is reached by at most one piece along each of the 8 lines through
+// it (the nearest), and 8 knights; on the last rank, each of the 3 pawn moves to it is 4 promotions.
+#define BOARD_MOVES_MAX (64 * (8 + 8) + 8 * 3 * 3)
+
 /**
-* A board with 8 ranks (ranks) and various flags (flags). See docs for details.
+* A board with 8 ranks (ranks), various flags (flags), the Zobrist hash of the position (hash), and the midgame
+* score (mg), endgame score (eg) and game phase (phase) of its pieces (see eval.h). See docs for details.
 */
 typedef struct {
     uint32_t ranks[8];
     uint32_t flags;
+    uint64_t hash;
+    int16_t mg;
+    int16_t eg;
+    int16_t phase;
 } board_t;
 
 /**
@@ -37,11 +47,25 @@ void board_apply_move(board_t *board, const move_t move);
 void board_apply_move(board_t *board, const move_t *move);
 #endif
 
+/**
+* Returns the Zobrist hash of the board's pieces, castling rights, en passant square and player, computed from scratch.
+* Boards made by board_make, and updated by board_apply_move, keep it in (hash); this is only needed for boards
+* assembled by hand.
+*/
+uint64_t board_hash(const board_t *board);
+
 /**
 * Returns an arraylist of all valid moves for the board.
 */
 alst_t *board_get_moves(const board_t *board);
 
+/**
+* Writes all valid moves for the board to (dest), and returns the number of moves written.
+* (dest) must have room for BOARD_MOVES_MAX moves, which is also used as scratch space.
+* Unlike board_get_moves, performs no allocations; moves are stored by value in either move_t mode.
+*/
+size_t board_get_moves_buf(const board_t *board, move_t *dest);
+
 /**
 * Returns 0 iff the current player is not under checkmate.
 */
@@ -57,6 +81,23 @@ int board_is_mate(const board_t *board);
 */
 int board_is_stalemate(const board_t *board);
 
+/**
+* Returns 0 iff the current player is not in check.
+*/
+int board_in_check(const board_t *board);
+
+/**
+* Returns the number of pieces on the board, kings included.
+*/
+int board_count_pieces(const board_t *board);
+
+/**
+* Returns nonzero iff every position of the board holds a piece or NOPC, each player has exactly one king, at the
+* position of its king in the flags, and the en passant position is on the board or NOPOS. Only these boards may
+* be hashed, or have their moves generated; boards read from files are checked with it.
+*/
+int board_is_valid(const board_t *board);
+
 /**
 * Returns the Forsyth-Edwards Notation (FEN) for the board, excluding the halfmove clock and the fullmove
 * number.
@@ -79,3 +120,20 @@ char *board_to_tui(const board_t *board);
 * en passant takes on the position are not considered.
 */
 int _board_hit(const board_t *board, const int rk, const int offs, const int white);
+
+/**
+* Stores the pseudo-legal moves of the current player in (dest), i.e., all moves but for those leaving the king
+* hit, and returns their number; stores the position of the king in (kingpos). (dest) must have room for
+* BOARD_MOVES_MAX moves. Castling moves are only generated where legal.
+*/
+size_t _board_get_pseudo_moves_buf(const board_t *board, move_t *dest, pos_t *kingpos);
+
+/**
+* Returns nonzero iff the pseudo-legal move of the current player, whose king is at (kingpos), does not leave the
+* king hit.
+*/
+#ifdef CHESSLIB_QWORD_MOVE
+int _board_is_legal(const board_t *board, const move_t move, const pos_t kingpos);
+#else
+int _board_is_legal(const board_t *board, const move_t *move, const pos_t kingpos);
+#endif
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "defs.h"
+#include "board.h"
+#include "move.h"
+#include "mapfile.h"
+
+/**
+* Polyglot opening books (.bin): a file of 16 byte big-endian entries sorted by key, each holding the Polyglot
+* Zobrist key of a position (8 bytes), a move (2 bytes), a weight (2 bytes) and a learn value (4 bytes, unused).
+* Books are memory mapped read-only, so opening one costs nothing up front and the pages of a book are shared by
+* all processes using it; positions are looked up by binary search.
+*
+* Polyglot keys are made from a fixed table of 781 random numbers (BOOK_RANDOMS) published with Polyglot, built
+* into the library; book_load_randoms and book_set_randoms override it, e.g., for books keyed with another table.
+* Books can also be probed by key with book_probe_key, i.e., with keys computed elsewhere.
+*/
+
+// size of the Polyglot random table: 12 pieces on 64 positions, 4 castling rights, 8 en passant files, the player
+#define BOOK_RANDOMS 781
+
+// most candidate moves returned for a position
+#define BOOK_MOVES_MAX 64
+
+typedef struct {
+    const uint8_t *entries;  // (len) 16 byte entries
+    size_t len;
+    mapfile_t file;  // the mapping of (entries)
+} book_t;
+
+/**
+* A candidate move from a book, with its (weight), relative to the weights of the other candidates.
+*/
+typedef struct {
+    move_t move;
+    uint16_t weight;
+} book_move_t;
+
+/**
+* Overrides the random table with one loaded from a file of BOOK_RANDOMS 64 bit big-endian integers, in the
+* order of the Random64 array of the Polyglot sources. Returns 0 on success, nonzero if the file cannot be read
+* or is not BOOK_RANDOMS * 8 bytes long, in which case the table is unchanged.
+*/
+int book_load_randoms(const char *path);
+
+/**
+* Overrides the random table with (randoms), in the order of the Random64 array of the Polyglot sources, or
+* restores the Polyglot table if (randoms) is NULL.
+*/
+void book_set_randoms(const uint64_t randoms[BOOK_RANDOMS]);
+
+/**
+* Returns the Polyglot key of the board.
+* The en passant file is only hashed if a pawn of the player to move stands next to the pawn that can be
+* taken en passant, as Polyglot does.
+*/
+uint64_t book_key(const board_t *board);
+
+/**
+* Returns a book opened from a Polyglot .bin file, or NULL if it cannot be opened or is not a whole number of
+* entries long.
+*/
+book_t *book_open(const char *path);
+
+/**
+* Closes a book.
+*/
+void book_close(book_t *book);
+
+/**
+* Writes up to (max) candidate moves for the board to (dest), in book order (by descending weight in books made
+* by Polyglot), and returns the number written. Book moves that are not legal on the board, i.e., from key
+* collisions, are skipped. Returns 0 if the position is not in the book.
+*/
+size_t book_probe(const book_t *book, const board_t *board, book_move_t *dest, size_t max);
+
+/**
+* Writes up to (max) raw entries for the key to (moves) and (weights), and returns the number written.
+* Moves are in Polyglot encoding: to file (bits 0-2), to row (3-5), from file (6-8), from row (9-11), and
+* promoted piece (12-14; 1 to 4 for knight to queen), with castling encoded as the king taking its own rook.
+*/
+size_t book_probe_key(const book_t *book, uint64_t key, uint16_t *moves, uint16_t *weights, size_t max);
+
+/**
+* Returns a move chosen at random among (len) candidates with probability proportional to their weights, given
+* a uniformly distributed (rnd); 0 if there are no candidates or all weights are zero.
+*/
+move_t book_pick(const book_move_t *moves, size_t len, uint64_t rnd);
@@ -24,6 +24,12 @@ typedef uint8_t pc_t;
 #define BKING 11
 #define NOPC 12
 
+// results of games
+#define RESULT_DRAW 0
+#define RESULT_WHITE_WINS 1
+#define RESULT_BLACK_WINS 2
+#define RESULT_UNFINISHED 3
+
 // castling info
 #define WKCASTLE 0b0001
 #define WQCASTLE 0b0010
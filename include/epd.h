@@ -0,0 +1,75 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "defs.h"
+#include "board.h"
+
+/**
+* Loading of positions in bulk from EPD (Extended Position Description) or FEN files, one position per line.
+* Files are memory mapped and cut into chunks (EPD_CHUNK bytes) of the lines starting in them, which a pool of
+* threads parses in two passes: the first counts the positions, operations and bytes of operands of each chunk,
+* and the second parses every chunk straight into its place in arrays allocated once, so positions keep the
+* order of the file. FEN fields are read in place, without copying or tokenizing lines.
+* A line holds the first four fields of a FEN, then either the move counters of a FEN, read as the EPD operations
+* hmvc and fmvn, or EPD operations: an opcode followed by operands, and a semicolon (e.g., "bm Nf3;", "D1 20;").
+* Blank lines and lines starting with '#' are skipped, as are lines that are not positions, which are counted.
+*/
+
+// bytes of a file per task of the thread pool
+#define EPD_CHUNK (1 << 20)
+
+/**
+* An EPD operation: its opcode (name), and its operands (value), as written but with surrounding white space, and
+* the quotes of a single string operand, removed (e.g., "Nf3 e4" for "bm Nf3 e4;").
+*/
+typedef struct {
+    const char *name;
+    const char *value;
+} epd_op_t;
+
+/**
+* The (len) positions of a file (boards), and the (nops) operations of all of them (ops), of which the operations
+* of position i are ops[opsidx[i]] to ops[opsidx[i + 1] - 1]. (errors) is the number of lines that are not
+* positions. Operations point into (strs).
+*/
+typedef struct {
+    board_t *boards;
+    size_t len;
+    epd_op_t *ops;
+    size_t *opsidx;
+    size_t nops;
+    char *strs;
+    size_t errors;
+} epd_t;
+
+/**
+* Loads the positions of the file at (path) on (threads) threads (0 for the number of online cores). Returns NULL if
+* the file cannot be read.
+*/
+epd_t *epd_load(const char *path, int threads);
+
+/**
+* Loads the positions of the (len) characters of (text), as epd_load.
+*/
+epd_t *epd_load_buf(const char *text, size_t len, int threads);
+
+/**
+* Frees loaded positions and all associated data.
+*/
+void epd_free(epd_t *epd);
+
+/**
+* Returns the operands of the operation (name) of position (i), or NULL if it has none.
+*/
+const char *epd_op(const epd_t *epd, size_t i, const char *name);
+
+/**
+* Reads the first four fields of a FEN at the start of the (len) characters of (text) into (dest), as board_make
+* would. Returns the number of characters read, or 0 if they are not a position with a king of each player, in
+* which the player not to move is not in check, no pawn stands on the first or last rank, castling rights have
+* their king and rook on their initial positions, and an en passant position is behind a pawn that just moved two
+* ranks (the sixth rank with white to move, the third with black).
+*/
+size_t epd_parse(const char *text, size_t len, board_t *dest);
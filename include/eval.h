@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "defs.h"
+#include "board.h"
+
+/**
+* Static evaluation from material and piece-square tables, tapered between a midgame and an endgame score by
+* the game phase. Boards carry the midgame score (mg), endgame score (eg) and phase (phase) of their pieces,
+* computed by board_make and updated incrementally by board_apply_move, so evaluating a board does not scan it.
+* Scores are in centipawns, from white's point of view in the board, and from the player to move's in eval_board.
+*/
+
+// phase of the starting material; boards with more (i.e., after promotions) count as this
+#define EVAL_PHASE_MAX 24
+
+// scores, including material, and phase weights by piece (WPAWN to BKING, and NOPC, all 0) and position; black
+// scores are negative
+extern int16_t eval_mg[NOPC + 1][64];
+extern int16_t eval_eg[NOPC + 1][64];
+extern const int8_t eval_phase[NOPC + 1];
+
+/**
+* Sets the midgame score, endgame score and phase of the board, computed from scratch.
+* Boards made by board_make, and updated by board_apply_move, keep them; this is only needed for boards
+* assembled by hand.
+*/
+void eval_reset(board_t *board);
+
+/**
+* Returns the static evaluation of the board in centipawns, from the point of view of the player to move.
+*/
+static inline int eval_board(const board_t *board) {
+    const int phase = board->phase < EVAL_PHASE_MAX ? board->phase : EVAL_PHASE_MAX;
+    const int score = (board->mg * phase + board->eg * (EVAL_PHASE_MAX - phase)) / EVAL_PHASE_MAX;
+    return FLAGS_WPLAYER(board->flags) ? score : -score;
+}
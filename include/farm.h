@@ -0,0 +1,95 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "defs.h"
+#include "board.h"
+#include "move.h"
+
+/**
+* Self-play game farming: plays games from a starting position on a pool of threads, and streams them to a file.
+* Each thread plays one game at a time, copy-making boards on its stack, and writes each finished game as one
+* line: its result, the reason it ended, and its moves in UCI notation (e.g., "1-0 mate e2e4 e7e5 ...").
+* Moves are chosen uniformly at random (FARM_RANDOM), at random with probabilities weighted by the static
+* evaluation after the move (FARM_WEIGHTED, a softmax at a temperature in centipawns), or by a search
+* (FARM_SEARCH, see include/search.h); the first (openingplies) plies of every game are random in all policies,
+* so that searched games differ.
+* Games end by checkmate, stalemate, insufficient material (as board_is_stalemate), threefold repetition, the
+* fifty-move rule, or unfinished at the ply limit (maxplies). Repetitions and the halfmove clock are tracked
+* from the start of each game.
+* Game i is played from a random state seeded by (seed) and i alone, so a farm is reproducible up to the order
+* of its lines, whatever its number of threads.
+* With (pgn) set, games are written in PGN instead (see include/pgn.h): game i is round i + 1, and the reason it
+* ended is a comment before its result.
+* With (train) set, the positions of the games are also written as training records to the file at that path (see
+* include/train.h), with the scores of the searches of FARM_SEARCH.
+*/
+
+// move policies
+#define FARM_RANDOM 0
+#define FARM_WEIGHTED 1
+#define FARM_SEARCH 2
+
+// reasons a game ended
+#define FARM_MATE 0
+#define FARM_STALEMATE 1
+#define FARM_MATERIAL 2
+#define FARM_REPETITION 3
+#define FARM_FIFTY 4
+#define FARM_PLIES 5
+#define FARM_NREASONS 6
+
+// default ply limit, default temperature of FARM_WEIGHTED, and default depth of FARM_SEARCH
+#define FARM_MAX_PLIES 500
+#define FARM_TEMPERATURE 100
+#define FARM_DEPTH 4
+
+/**
+* Configuration of a farm: (games) games played on (threads) threads (0 for the number of online cores) from
+* (fen) (NULL for the starting position) with the move policy (policy), of at most (maxplies) plies (0 for
+* FARM_MAX_PLIES), the first (openingplies) of them random. (temperature) is that of FARM_WEIGHTED in
+* centipawns (0 for FARM_TEMPERATURE); (depth) and (nodes) limit the searches of FARM_SEARCH (both 0 for a
+* depth of FARM_DEPTH), with a transposition table of (ttmb) megabytes per thread (0 for none), cleared between
+* games. Games are written in PGN if (pgn) is nonzero, and their positions as training records to the file at
+* (train) if not NULL.
+*/
+typedef struct {
+    uint64_t games;
+    int threads;
+    const char *fen;
+    int policy;
+    int maxplies;
+    int openingplies;
+    int temperature;
+    int depth;
+    uint64_t nodes;
+    size_t ttmb;
+    uint64_t seed;
+    int pgn;
+    const char *train;
+} farm_config_t;
+
+/**
+* Statistics of a farm: the number of (games) and (plies) played, and of games by result (results) and by the
+* reason they ended (reasons).
+*/
+typedef struct {
+    uint64_t games;
+    uint64_t plies;
+    uint64_t results[4];
+    uint64_t reasons[FARM_NREASONS];
+} farm_stats_t;
+
+/**
+* Plays the games of (config), writing them to the file at (path) as they finish, and stores statistics in
+* (stats) if not NULL. Returns 0 on success, nonzero if (config->fen) is not a valid position (see epd_parse)
+* or a file cannot be written.
+*/
+int farm_run(const farm_config_t *config, const char *path, farm_stats_t *stats);
+
+/**
+* Returns the notation of a result ("1/2-1/2", "1-0", "0-1" or "*"), and of the reason a game ended.
+*/
+const char *farm_result_str(int result);
+const char *farm_reason_str(int reason);
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+* Files read whole into memory, and texts read in chunks on a pool of threads.
+* On unix, files are memory mapped read-only, so that their pages are read on demand and shared with the page
+* cache; elsewhere they are read into an allocation.
+* A pool runs a worker function on several threads, which take the chunks of a text in turn with
+* mapfile_pool_next until none are left.
+*/
+
+// access patterns of a mapped file, advised to the kernel
+#define MAPFILE_NORMAL 0
+#define MAPFILE_SEQUENTIAL 1
+#define MAPFILE_RANDOM 2
+
+/**
+* The (len) bytes of a file at (mem), NULL if the file is empty.
+*/
+typedef struct {
+    const char *mem;
+    size_t len;
+} mapfile_t;
+
+/**
+* The (nchunks) chunks of a pool, and the next one not yet taken.
+*/
+typedef struct {
+    size_t nchunks;
+    uint64_t next;
+} mapfile_pool_t;
+
+/**
+* Maps the file at (path) into (file), read with the access pattern (advice). Returns 0 on success, nonzero if the
+* file cannot be read, in which case (file) is unchanged.
+*/
+int mapfile_open(const char *path, int advice, mapfile_t *file);
+
+/**
+* Unmaps (file), which was opened with mapfile_open.
+*/
+void mapfile_close(mapfile_t *file);
+
+/**
+* Runs (worker)(arg) on (threads) threads (0 for the number of online cores), at most one per chunk of (pool)
+* and at least one, and returns once they all have. The chunks are taken anew from the first.
+*/
+void mapfile_pool_run(mapfile_pool_t *pool, int threads, void *(*worker)(void *), void *arg);
+
+/**
+* Takes the next chunk of (pool), from any thread. Returns (pool->nchunks) once all have been taken.
+*/
+static inline size_t mapfile_pool_next(mapfile_pool_t *pool) {
+    const uint64_t chunk = __atomic_fetch_add(&pool->next, 1, __ATOMIC_RELAXED);
+    return chunk < pool->nchunks ? chunk : pool->nchunks;
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "defs.h"
+#include "board.h"
+#include "move.h"
+
+/**
+* Monte Carlo tree search with PUCT selection, for playing and training with neural networks.
+* Leaves are not evaluated by the search: they are collected into batches, and each batch is evaluated by one
+* call of a user supplied callback (mcts_eval_t), e.g., running a network on all of its boards at once.
+* While a batch is collected, the paths to its leaves carry virtual losses, which steer selection to other leaves.
+* Nodes are kept in an arena of (maxnodes) nodes allocated by mcts_make, so searching allocates nothing; a search
+* stops early once the arena is full. mcts_advance keeps the subtree of the move played for the next search.
+* Checkmates, stalemates and draws by insufficient material are scored by the search itself; the fifty-move rule
+* and repetitions are not tracked.
+*/
+
+// defaults of zeroed configuration fields
+#define MCTS_CPUCT 1.5f
+#define MCTS_BATCH 256
+#define MCTS_NODES (1 << 20)
+
+// most leaves in a batch
+#define MCTS_BATCH_MAX 4096
+
+/**
+* Configuration of a search: the exploration constant (cpuct), the first play urgency (fpu), by which the value
+* of an unvisited move is below that of its parent, the number of leaves per evaluation call (batch), and the
+* number of nodes of the arena (maxnodes), at least 1 + BOARD_MOVES_MAX. Zeroed fields other than (fpu) take their
+* defaults.
+*/
+typedef struct {
+    float cpuct;
+    float fpu;
+    int batch;
+    size_t maxnodes;
+} mcts_config_t;
+
+/**
+* A node for the position after (move) from its (parent), with (nchildren) children from index (children).
+* (value) is the sum of the values of the (visits) playouts through it, for the player who made (move);
+* (vloss) is the number of playouts through it pending evaluation, each counted as a loss.
+*/
+typedef struct {
+    move_t move;
+    uint32_t parent;
+    uint32_t children;
+    uint16_t nchildren;
+    uint8_t state;
+    float prior;
+    uint32_t visits;
+    uint32_t vloss;
+    float value;
+} mcts_node_t;
+
+/**
+* Evaluates the (n) boards (boards) of a batch: for board i, writes its value in [-1, 1] for the player to move to
+* values[i], and the prior probabilities of its legal moves, moves[offsets[i]] to moves[offsets[i + 1] - 1], to the
+* same entries of (priors). Priors need not be normalized. (ctx) is passed through from mcts_search.
+*/
+typedef void (*mcts_eval_t)(void *ctx, size_t n, const board_t *boards, const move_t *moves, const uint32_t *offsets,
+                            float *priors, float *values);
+
+/**
+* A search tree of (len) nodes in (nodes), of which node 0 is the root, for the board (root).
+*/
+typedef struct {
+    mcts_config_t config;
+    board_t root;
+    mcts_node_t *nodes;
+    size_t len;
+    mcts_node_t *spare;  // arena into which mcts_advance compacts the subtree kept
+    board_t *boards;  // batch buffers
+    move_t *moves;
+    uint32_t *offsets;
+    float *priors;
+    float *values;
+    uint32_t *leaves;
+} mcts_t;
+
+/**
+* Returns a search tree for the board, configured by (config), or by defaults if NULL.
+*/
+mcts_t *mcts_make(const board_t *board, const mcts_config_t *config);
+
+/**
+* Frees a search tree.
+*/
+void mcts_free(mcts_t *tree);
+
+/**
+* Clears the tree, and sets its root to the board.
+*/
+void mcts_reset(mcts_t *tree, const board_t *board);
+
+/**
+* Runs (playouts) playouts from the root, calling (eval) with (ctx) for each batch of leaves, and returns the
+* number run: fewer if the arena is full, 0 if the root has no legal moves.
+* Performs no allocations.
+*/
+uint64_t mcts_search(mcts_t *tree, uint64_t playouts, mcts_eval_t eval, void *ctx);
+
+/**
+* Plays (move), a legal move of the root, keeping its subtree as the tree. Returns 0 if the subtree was kept,
+* nonzero if (move) was not in the tree, which is then cleared.
+*/
+int mcts_advance(mcts_t *tree, move_t move);
+
+/**
+* Writes the moves of the root to (moves) and their visits to (visits), and returns their number; both must have
+* room for BOARD_MOVES_MAX entries. Returns 0 until the root is expanded by a search.
+*/
+size_t mcts_policy(const mcts_t *tree, move_t *moves, uint32_t *visits);
+
+/**
+* Returns the most visited move of the root, 0 if there is none.
+*/
+move_t mcts_best(const mcts_t *tree);
+
+/**
+* Returns the mean value of the playouts from the root, in [-1, 1] for the player to move at the root.
+*/
+float mcts_value(const mcts_t *tree);
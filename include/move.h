@@ -1,6 +1,7 @@
 #pragma once
 
 #include <stdint.h>
+#include <stddef.h>
 
 #include "defs.h"
 
@@ -143,3 +144,13 @@ char *move_algnot(const move_t move);
 #else
 char *move_algnot(const move_t *move);
 #endif
+
+/**
+* Writes the UCI notation of the move (e.g., e2e4, e7e8q) to (buf), which must have room for 6 characters, and
+* returns its length, not counting its terminating null character.
+*/
+#ifdef CHESSLIB_QWORD_MOVE
+size_t move_uci(const move_t move, char *buf);
+#else
+size_t move_uci(const move_t *move, char *buf);
+#endif
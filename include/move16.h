@@ -0,0 +1,110 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "defs.h"
+#include "move.h"
+#include "board.h"
+
+/**
+* Compact 16 bit moves, for storing moves in bulk: transposition table entries, killer and countermove tables,
+* move lists and game histories. A move16_t packs the origin (bits 0-5), the destination (bits 6-11), the promotion
+* piece (bits 12-13: knight, bishop, rook or queen) and the kind of the move (bits 14-15: MOVE16_NORMAL,
+* MOVE16_PROMO, MOVE16_EP or MOVE16_CASTLE), and is 0 for no move, as move_t.
+* Packing a move_t needs nothing but the move; unpacking takes the board the move is played on, which holds the
+* pieces moved and taken.
+*/
+
+typedef uint16_t move16_t;
+
+// kinds of moves
+#define MOVE16_NORMAL 0
+#define MOVE16_PROMO 1
+#define MOVE16_EP 2
+#define MOVE16_CASTLE 3
+
+#define MV16FROMPOS(move) ((pos_t) ((move) & 0x3f))
+#define MV16TOPOS(move)   ((pos_t) (((move) >> 6) & 0x3f))
+#define MV16PROMO(move)   ((pc_t) (WKNIGHT + (((move) >> 12) & 0x3)))  // the white piece promoted to
+#define MV16KIND(move)    ((int) ((move) >> 14))
+#define MV16MAKE(frompos, topos, promo, kind) \
+    ((move16_t) ((frompos) | ((topos) << 6) | (((promo) - WKNIGHT) << 12) | ((kind) << 14)))
+
+/**
+* A game history: the starting position (start), the board after the (len) moves played from it (board), and the
+* moves, packed. Unpacking and taking back moves replays the game from (start).
+*/
+typedef struct {
+    board_t start;
+    board_t board;
+    move16_t *moves;
+    size_t len;
+    size_t cap;
+} move16_hist_t;
+
+/**
+* Returns the move packed.
+*/
+static inline move16_t move16_make(move_t move) {
+    const pos_t frompos = MVFROMPOS(move), topos = MVTOPOS(move);
+    if (MVTOPC(move) != MVFROMPC(move)) {
+        return MV16MAKE(frompos, topos, MVTOPC(move) % BPAWN, MOVE16_PROMO);
+    }
+    if (MVKILLPC(move) != NOPC && MVKILLPOS(move) != topos) {
+        return MV16MAKE(frompos, topos, WKNIGHT, MOVE16_EP);
+    }
+    if (MVFROMPC(move) % BPAWN == WKING && (frompos - topos == 2 || topos - frompos == 2)) {
+        return MV16MAKE(frompos, topos, WKNIGHT, MOVE16_CASTLE);
+    }
+    return MV16MAKE(frompos, topos, WKNIGHT, MOVE16_NORMAL);
+}
+
+/**
+* Returns the move (move) unpacked on the board, or 0 if it cannot be a move of the player to move: if it moves
+* no piece of theirs, takes one, or does not fit its kind (e.g., promotes a piece other than a pawn). The move is
+* not checked for legality.
+*/
+move_t move16_to_move(const board_t *board, move16_t move);
+
+/**
+* Packs the (len) moves (moves) into (dest), which holds at least (len) moves.
+*/
+void move16_pack(const move_t *moves, size_t len, move16_t *dest);
+
+/**
+* Unpacks the (len) moves (moves) played in turn from the board into (dest), which holds at least (len) moves.
+* Returns the number of moves unpacked, less than (len) if one cannot be a move (see move16_to_move).
+*/
+size_t move16_unpack(const board_t *board, const move16_t *moves, size_t len, move_t *dest);
+
+/**
+* Writes the legal moves of the board, packed, into (dest), which holds at least BOARD_MOVES_MAX moves, and returns
+* their number.
+*/
+size_t move16_get_moves_buf(const board_t *board, move16_t *dest);
+
+/**
+* Returns an empty game history from the board.
+*/
+move16_hist_t *move16_hist_make(const board_t *start);
+
+/**
+* Frees a game history and all associated data.
+*/
+void move16_hist_free(move16_hist_t *hist);
+
+/**
+* Plays the legal move (move) on the board of the history, and appends it.
+*/
+void move16_hist_push(move16_hist_t *hist, move_t move);
+
+/**
+* Takes back the last move of the history, and returns it, or 0 if there is none.
+*/
+move_t move16_hist_pop(move16_hist_t *hist);
+
+/**
+* Unpacks the moves of the history into (dest), which holds at least hist->len moves, and returns their number.
+*/
+size_t move16_hist_moves(const move16_hist_t *hist, move_t *dest);
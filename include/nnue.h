@@ -0,0 +1,93 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "defs.h"
+#include "board.h"
+#include "move.h"
+
+/**
+* Evaluation by a small quantised neural network (NNUE), with an incrementally updated first layer.
+* The network has 768 binary inputs, one per piece (WPAWN to BKING) and position, and three layers:
+*   - a feature transformer (int16) from the inputs to (hidden) neurons, kept for both players' points of view in
+*     an accumulator: white's sees the board as it is, and black's with colors swapped and ranks mirrored,
+*   - a hidden layer (int8) from the clipped accumulators of the player to move and of the opponent, concatenated,
+*     to (l2) neurons,
+*   - an output layer (int8) from the clipped hidden neurons to the score.
+* As a move changes at most four inputs, accumulators are updated from the accumulator of the board the move is
+* made on, rather than summed over all pieces: this mirrors board_apply_move, which copy-makes boards, so a search
+* keeps one accumulator per ply next to its board, and never needs to undo an update.
+* The hidden and output layers are evaluated by AVX2 kernels where the processor has them, chosen at run time,
+* and otherwise by scalar code computing the same result.
+*
+* Networks are loaded from files, all integers little-endian:
+*   "CLNN", uint32 version (NNUE_VERSION), uint32 hidden, uint32 l2,
+*   int16 feature weights [768][hidden], int16 feature biases [hidden],
+*   int8 hidden weights [l2][2 * hidden], int32 hidden biases [l2],
+*   int8 output weights [l2], int32 output bias.
+* Input 64 * pc + pos is piece pc on position pos. Accumulator values are clipped to [0, NNUE_QA]; hidden neurons
+* are shifted right by NNUE_SHIFT and clipped to [0, NNUE_QA]; the output divided by NNUE_SCALE is the score in
+* centipawns, for the player to move.
+*/
+
+#define NNUE_VERSION 1
+#define NNUE_INPUTS 768
+#define NNUE_HIDDEN_MAX 512  // hidden must be a multiple of 32 up to this
+#define NNUE_L2_MAX 32
+#define NNUE_QA 127
+#define NNUE_SHIFT 6
+#define NNUE_SCALE 16
+
+typedef struct {
+    int hidden;
+    int l2;
+    int16_t *ft_weights;  // [NNUE_INPUTS][hidden]
+    int16_t *ft_biases;  // [hidden]
+    int8_t *l1_weights;  // [l2][2 * hidden]
+    int32_t l1_biases[NNUE_L2_MAX];
+    int8_t out_weights[NNUE_L2_MAX];
+    int32_t out_bias;
+} nnue_t;
+
+/**
+* The first layer of a network for a board, from the points of view of white (v[0]) and black (v[1]).
+* Only the first (hidden) values of each are used.
+*/
+typedef struct {
+    int16_t v[2][NNUE_HIDDEN_MAX];
+} __attribute__((aligned(32))) nnue_acc_t;
+
+/**
+* Loads a network from the file at (path). Returns NULL if the file cannot be read, or is not a network of a
+* supported version and size.
+*/
+nnue_t *nnue_load(const char *path);
+
+/**
+* Frees a network.
+*/
+void nnue_free(nnue_t *net);
+
+/**
+* Enables the AVX2 kernels iff (enable) is nonzero, for all networks, and returns nonzero if they are in use,
+* i.e., 0 if disabled or if the processor lacks AVX2. They are enabled by default.
+*/
+int nnue_set_simd(int enable);
+
+/**
+* Computes the accumulator (dest) of the board from scratch.
+*/
+void nnue_refresh(const nnue_t *net, const board_t *board, nnue_acc_t *dest);
+
+/**
+* Computes the accumulator (dest) of the board made by applying (move) to a board whose accumulator is (src).
+* (dest) may be (src), to update it in place.
+*/
+void nnue_update(const nnue_t *net, const nnue_acc_t *src, nnue_acc_t *dest, move_t move);
+
+/**
+* Returns the evaluation of the board whose accumulator is (acc) in centipawns, from the point of view of the
+* player to move.
+*/
+int nnue_evaluate(const nnue_t *net, const board_t *board, const nnue_acc_t *acc);
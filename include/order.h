@@ -0,0 +1,69 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "defs.h"
+#include "move.h"
+#include "board.h"
+#include "move16.h"
+
+/**
+* Move ordering for alpha-beta searches: moves are scored and sorted in place so that the moves most likely to
+* cause a cutoff are searched first. An order_t holds what the search learns about quiet moves (moves that
+* neither capture nor promote) as it goes, and belongs to a single search thread:
+* killer moves, the last two quiet moves to cause a cutoff at each ply;
+* history, a score by player, from and to position (a butterfly table) rewarding quiet moves that cause cutoffs and
+* penalizing those searched before them;
+* countermoves, the last quiet move to cause a cutoff in reply to each move, by its piece and to position.
+* Killer moves and countermoves are kept packed (see include/move16.h), so the tables take a quarter of the memory.
+*/
+
+// deepest ply with killer moves
+#define ORDER_MAX_PLY 64
+
+// killer moves per ply
+#define ORDER_KILLERS 2
+
+// bound on history scores
+#define ORDER_HISTORY_MAX 16384
+
+typedef struct {
+    move16_t killers[ORDER_MAX_PLY][ORDER_KILLERS];
+    move16_t counters[NOPC][64];  // by piece moved and to position of the previous move
+    int32_t history[2][64][64];  // by player (0 for white), from position and to position
+} order_t;
+
+/**
+* Clears all killer moves, countermoves and history.
+*/
+void order_clear(order_t *order);
+
+/**
+* Halves all history scores and clears killer moves, i.e., between searches, so that history carries over
+* without outweighing what the next search learns.
+*/
+void order_age(order_t *order);
+
+/**
+* Sorts (len) (moves) at ply (ply) by descending score, in place: (pvmove), then (hashmove), then captures and
+* promotions by most valuable victim, least valuable attacker, then killer moves, then the countermove to (prev),
+* the move that led to the position, then the remaining quiet moves by history.
+* (pvmove), (hashmove) and (prev) may be 0 for none. Quiet moves of equal score keep their order.
+* (len) is at most BOARD_MOVES_MAX.
+*/
+void order_moves(const order_t *order, move_t *moves, size_t len, move_t pvmove, move_t hashmove, int ply, move_t prev);
+
+/**
+* Records a cutoff at ply (ply) and remaining depth (depth) by the quiet move (move), in reply to (prev) (0 for none),
+* after the (ntried) quiet moves in (tried) failed to cause one; (tried) may include (move).
+* Captures and promotions are ignored.
+*/
+void order_update(order_t *order, move_t move, const move_t *tried, size_t ntried, int depth, int ply, move_t prev);
+
+/**
+* Returns 0 iff the move captures or promotes.
+*/
+static inline int order_is_quiet(move_t move) {
+    return MVKILLPC(move) == NOPC && MVTOPC(move) == MVFROMPC(move);
+}
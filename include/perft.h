@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "defs.h"
+#include "board.h"
+
+// deepest perft depth that can be annotated on an epd line (;D1 through ;D<PERFT_MAX_DEPTH>)
+#define PERFT_MAX_DEPTH 16
+
+/**
+* A perft test position parsed from a line of an Extended Position Description (EPD) file,
+* as used by the standard perft suites, i.e.,
+* 'rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - ;D1 20 ;D2 400 ;D3 8902'.
+* (fen) holds the board, player, castling and en passant fields of the position.
+* (counts)[d] is the expected leaf count at depth d, or 0 if the line does not annotate depth d.
+* (maxdepth) is the deepest annotated depth.
+*/
+typedef struct {
+    char fen[100];
+    int maxdepth;
+    uint64_t counts[PERFT_MAX_DEPTH + 1];
+} perft_epd_t;
+
+/**
+* Returns the number of leaf nodes (perft) in the legal move tree of the given depth rooted at the board.
+* Performs no allocations.
+*/
+uint64_t perft_count(const board_t *board, int depth);
+
+/**
+* Parses a perft EPD line into (epd).
+* Returns 0 on success, nonzero if the line has no position or a malformed depth annotation.
+* Trailing halfmove clock and fullmove number fields in the position are accepted and ignored.
+*/
+int perft_epd_parse(const char *line, perft_epd_t *epd);
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "defs.h"
+#include "board.h"
+#include "move.h"
+
+/**
+* Reading of games in Portable Game Notation (PGN), in bulk.
+* Files are memory mapped and cut into chunks (PGN_CHUNK bytes), which a pool of threads takes in turn; each
+* thread reads the games starting in its chunk, so games are found and parsed in parallel, and nothing but the
+* game at hand is held in memory. Games are delimited by their tag sections: a game starts at a tag line
+* (e.g., [Event "..."]) that does not follow another tag line, or at the start of the file.
+* Tag values are unescaped, and the FEN tag, if any, sets the starting position. Moves in Standard Algebraic
+* Notation (SAN) are matched against the pseudo-legal moves of the board, of which only the candidates are checked
+* for legality; move numbers, comments, variations, numeric annotation glyphs and suffix annotations are skipped.
+* Games are passed to a callback as they are read, from all threads at once, and in no particular order: the
+* offset of each game in the file identifies it.
+*
+* Moves are written in SAN by pgn_san, which finds the other pieces that could go to the same position from
+* the board itself, rather than from a list of legal moves, and generates the moves of the opponent, after a
+* check only, until it finds a legal one to tell check from mate. pgn_write_moves writes the movetext of a game.
+*/
+
+// bytes of a file per task of the thread pool, and most tags kept per game (others are skipped)
+#define PGN_CHUNK (1 << 20)
+#define PGN_TAGS_MAX 64
+
+// longest SAN of a move and its terminator (e.g., "exd8=Q+"), and longest SAN with its move number and separator
+#define PGN_SAN_CHARS 8
+#define PGN_MOVE_CHARS 16
+
+typedef struct {
+    const char *name;
+    const char *value;
+} pgn_tag_t;
+
+/**
+* A game read from a file: its (offset) in bytes, its (ntags) tags, its starting position (start), its (len)
+* moves, and its result, from its termination marker, else its Result tag, else RESULT_UNFINISHED.
+* (error) is nonzero if a move or the FEN tag could not be read, in which case (moves) holds the moves before it.
+* Tags and moves are only valid during the callback the game is passed to.
+*/
+typedef struct {
+    size_t offset;
+    const pgn_tag_t *tags;
+    size_t ntags;
+    board_t start;
+    const move_t *moves;
+    size_t len;
+    int result;
+    int error;
+} pgn_game_t;
+
+typedef void (*pgn_callback_t)(void *ctx, const pgn_game_t *game);
+
+/**
+* Statistics of a read: the number of (games), of their (moves), and of games with (errors).
+*/
+typedef struct {
+    uint64_t games;
+    uint64_t moves;
+    uint64_t errors;
+} pgn_stats_t;
+
+/**
+* Reads the games of the file at (path) on (threads) threads (0 for the number of online cores), passing each to
+* (callback) with (ctx), and stores statistics in (stats) if not NULL. Returns 0 on success, nonzero if the file
+* cannot be read.
+*/
+int pgn_read(const char *path, int threads, pgn_callback_t callback, void *ctx, pgn_stats_t *stats);
+
+/**
+* Reads the games of the (len) characters of (text), as pgn_read.
+*/
+void pgn_read_buf(const char *text, size_t len, int threads, pgn_callback_t callback, void *ctx, pgn_stats_t *stats);
+
+/**
+* Returns the legal move of the board written (san) in SAN, of (len) characters, or 0 if there is no such move
+* or more than one. Check and annotation suffixes are ignored; castles may be written with zeros, promotions
+* without '=', and moves with the origin square in full (e.g., "Ng1-f3").
+*/
+move_t pgn_parse_san(const board_t *board, const char *san, size_t len);
+
+/**
+* Returns the value of the tag (name) of the game, or NULL if it has none.
+*/
+const char *pgn_tag(const pgn_game_t *game, const char *name);
+
+/**
+* Writes the SAN of (move), a legal move of the board, into (dest), which holds at least PGN_SAN_CHARS characters,
+* and returns its length.
+*/
+size_t pgn_san(const board_t *board, move_t move, char *dest);
+
+/**
+* Writes the movetext of the (len) legal moves played from the board, with move numbers from 1 (e.g.,
+* "1. e4 e5 2. Nf3", or "1... e5 2. Nf3" with black to move) into (dest), which holds at least
+* len * PGN_MOVE_CHARS + 1 characters, and returns its length.
+*/
+size_t pgn_write_moves(const board_t *board, const move_t *moves, size_t len, char *dest);
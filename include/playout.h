@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "defs.h"
+#include "board.h"
+#include "move.h"
+
+/**
+* Uniformly random playouts, for rollouts in Monte Carlo searches and for sampling positions.
+* Random legal moves are drawn without generating all legal moves: a pseudo-legal move is drawn uniformly, and
+* drawn again without it if it leaves the king hit, so each ply costs a pseudo-legal move generation and, most
+* often, a single legality check. Boards are copy-made on the stack; nothing is allocated.
+* The random state is a single 64 bit word owned by the caller, e.g., one per thread, seeded with any value.
+* Games end by checkmate, stalemate, insufficient material (as board_is_stalemate), the fifty-move rule, or
+* unfinished at a ply limit; repetitions are not detected, as boards do not track their history.
+*/
+
+/**
+* Returns the next random number of the state (rng), which it advances.
+*/
+static inline uint64_t playout_rand(uint64_t *rng) {  // splitmix64
+    uint64_t z = (*rng += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+/**
+* Returns a legal move of the board drawn uniformly at random from (rng), 0 if there are none.
+* If (incheck) is not NULL, stores whether the player to move is in check, when there are no legal moves.
+*/
+move_t playout_move(const board_t *board, uint64_t *rng, int *incheck);
+
+/**
+* Plays random legal moves from the board until the game ends, or for at most (maxplies) plies, and returns the
+* result (RESULT_DRAW to RESULT_UNFINISHED). If (plies) is not NULL, stores the number of plies played.
+* The halfmove clock of the fifty-move rule starts at 0.
+*/
+int playout(const board_t *board, int maxplies, uint64_t *rng, int *plies);
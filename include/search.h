@@ -0,0 +1,113 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "defs.h"
+#include "board.h"
+#include "move.h"
+#include "tt.h"
+#include "eval.h"
+
+// deepest search ply, and the longest principal variation
+#define SEARCH_MAX_PLY 64
+
+// bound on search scores
+#define SEARCH_INF 32000
+
+// score of the side to move mating at the root; being mated in n plies scores -(SEARCH_MATE - n),
+// mating in n plies scores SEARCH_MATE - n
+#define SEARCH_MATE 31000
+
+// scores beyond this bound are mate scores
+#define SEARCH_MATE_BOUND (SEARCH_MATE - SEARCH_MAX_PLY)
+
+// nodes searched by a thread between polls of the clock and of the stop flags
+#define SEARCH_CHECK_NODES 256
+
+/**
+* Limits on a search. A zeroed limit is not applied; if all are zeroed, the search runs to SEARCH_MAX_PLY - 1,
+* or until stopped through (stop).
+* (depth) is the deepest iteration in plies, (nodes) the number of nodes after which the search stops, and
+* (movetime_ms) the number of milliseconds after which the search stops (the hard time limit).
+* (softtime_ms) is the number of milliseconds after which no new iteration is started (the soft time limit);
+* iterations started before it run until they complete or reach the hard limit.
+* search_limits_clock sets both from the state of a game clock.
+* The search returns the result of the deepest completed iteration; the first iteration is always completed.
+* Time and stop flags are polled every SEARCH_CHECK_NODES nodes per thread, the node limit at every node.
+* (tt) is an optional transposition table, which may be kept across searches, NULL for none.
+* (threads) is the number of threads searching the root in parallel (lazy SMP), 0 or 1 for a single thread.
+* Helper threads share the transposition table with the main thread and search staggered depths, so they are
+* only of use with a table. The node limit applies to the nodes of all threads, and holds exactly for them
+* but for the first iteration of every thread.
+* (stop), if not NULL, is polled during the search; setting it nonzero from another thread (see search_signal)
+* stops the search (after the first iteration).
+*/
+typedef struct {
+    int depth;
+    uint64_t nodes;
+    uint64_t movetime_ms;
+    tt_t *tt;
+    int threads;
+    const int *stop;
+    uint64_t softtime_ms;
+} search_limits_t;
+
+/**
+* The result of a search.
+* (best) is the best move found, (score) its score in centipawns from the point of view of the player to move,
+* and (depth) the deepest completed iteration.
+* (pv) holds the (pvlen) moves of the principal variation starting with (best).
+* (nodes) is the number of nodes searched by all threads, and (time_ms) the time the search took in milliseconds.
+*/
+typedef struct {
+    move_t best;
+    int score;
+    int depth;
+    int pvlen;
+    move_t pv[SEARCH_MAX_PLY];
+    uint64_t nodes;
+    uint64_t time_ms;
+} search_result_t;
+
+/**
+* Searches the board with iterative deepening negamax alpha-beta search under (limits), and stores the result.
+* Leaves are resolved by quiescence search (see search_quiesce).
+* With helper threads, the result is that of the deepest iteration completed by any thread.
+* Returns 0 on success, nonzero if the player to move has no legal moves, in which case (result) has no best move,
+* and scores -SEARCH_MATE for checkmate, 0 for stalemate.
+* Performs no allocations.
+*/
+int search(const board_t *board, const search_limits_t *limits, search_result_t *result);
+
+/**
+* Returns the score of the board in centipawns, from the point of view of the player to move, after a quiescence
+* search in the window (alpha, beta): captures and promotions are searched until the position is quiet, with the
+* option of standing pat on the static evaluation; when in check, all moves are searched instead.
+* Captures that cannot raise alpha by a margin (delta pruning) and captures losing material by static exchange
+* evaluation are skipped. Mate and stalemate are detected.
+* If (nodes) is not NULL, stores the number of nodes searched. Performs no allocations.
+*/
+int search_quiesce(const board_t *board, int alpha, int beta, uint64_t *nodes);
+
+/**
+* Returns the static exchange evaluation of a capture or promotion: the material, in centipawns, won by the player
+* making (move) if both players then recapture on its target with their least valuable pieces for as long as
+* it profits them. Pins and checks are not considered.
+*/
+int search_see(const board_t *board, move_t move);
+
+/**
+* Sets the soft and hard time limits of (limits) for a move, given the (time_ms) milliseconds left on the clock of
+* the player to move, the increment (inc_ms) added after each move, the number of moves (movestogo) until the next
+* time control (0 if none), and a safety margin (overhead_ms) for the time spent outside the search, i.e., on
+* communication. The hard limit never exceeds the time left less the margin.
+*/
+void search_limits_clock(search_limits_t *limits, uint64_t time_ms, uint64_t inc_ms, int movestogo,
+                         uint64_t overhead_ms);
+
+/**
+* Sets the stop flag (stop) of a search from another thread.
+*/
+static inline void search_signal(int *stop) {
+    __atomic_store_n(stop, 1, __ATOMIC_RELAXED);
+}
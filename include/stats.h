@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stdint.h>
+
+/**
+* Hot path counters and cycle timers for move generation, kept per thread.
+* Only collected if the library is compiled with CHESSLIB_STATS; otherwise the hooks compile to nothing,
+* and snapshots are always zeroed.
+* Cycles are read from the time stamp counter on x86, and are nanoseconds of monotonic clock elsewhere.
+*/
+typedef struct {
+    uint64_t get_moves;  // board_get_moves and board_get_moves_buf calls
+    uint64_t gen[6];  // piece generator calls, indexed by white piece (WPAWN to WKING) for either player
+    uint64_t pseudo;  // pseudo-legal moves generated
+    uint64_t rejected;  // pseudo-legal moves rejected by the legality filter (leave the king in check)
+    uint64_t hit;  // _board_hit calls
+    uint64_t copy;  // board_copy calls
+    uint64_t apply;  // board_apply_move calls
+    uint64_t gen_cycles;  // cycles spent generating pseudo-legal moves
+    uint64_t filter_cycles;  // cycles spent filtering pseudo-legal moves
+} stats_t;
+
+/**
+* Copies the calling thread's counters into (dest).
+*/
+void stats_snapshot(stats_t *dest);
+
+/**
+* Zeroes the calling thread's counters.
+*/
+void stats_reset(void);
+
+// hooks used by the library internals
+#if defined(CHESSLIB_STATS) && !defined(__cplusplus)
+#include <time.h>
+
+extern _Thread_local stats_t _stats;
+
+static inline uint64_t _stats_cycles(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+#define STATS_INC(field) (++_stats.field)
+#define STATS_ADD(field, n) (_stats.field += (n))
+#define STATS_TIMER(name) const uint64_t name = _stats_cycles()
+#define STATS_ELAPSED(field, name) (_stats.field += _stats_cycles() - (name))
+#else
+#define STATS_INC(field) ((void) 0)
+#define STATS_ADD(field, n) ((void) 0)
+#define STATS_TIMER(name)
+#define STATS_ELAPSED(field, name) ((void) 0)
+#endif
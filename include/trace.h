@@ -0,0 +1,106 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "defs.h"
+#include "board.h"
+
+/**
+* Capture of library calls into a compact binary trace, for replaying real workloads offline (see tools/replay.c).
+* Only recorded if the library is compiled with CHESSLIB_TRACE; otherwise the hooks compile to nothing,
+* and trace_start always fails.
+* A trace can also be captured without changing the client by setting the CHESSLIB_TRACE_FILE environment
+* variable to the trace path before the library is loaded.
+*
+* Only calls made by the client are recorded, calls made by the library to itself are not.
+* Boards allocated by board_make and board_copy are referred to by an id, which is recycled once the board is
+* freed. Calls on any other board (i.e., one held by value by the client) carry id 0, followed by the board itself.
+*
+* Trace format (integers little-endian, so that traces replay on any host and build):
+*   header: TRACE_MAGIC (8 bytes), size of a board (4 bytes, TRACE_BOARD)
+*   record: op (1 byte), board id (4 bytes), then per op:
+*     TRACE_MAKE: fen length (1 byte), fen (without '\0')
+*     TRACE_COPY: source board id (4 bytes)
+*     TRACE_APPLY: move (8 bytes, laid out as a CHESSLIB_QWORD_MOVE move)
+*     others: nothing
+*   For TRACE_MAKE and TRACE_COPY, the record id is that of the new board. Any board id 0 (record or source)
+*   is followed by the board: its ranks (8 x 4 bytes) and flags (4 bytes), from which the hash and evaluation
+*   are recomputed on replay.
+*/
+
+#define TRACE_MAGIC "CHSTRC02"
+#define TRACE_HEADER 12
+#define TRACE_BOARD 36
+
+typedef enum {
+    TRACE_MAKE,  // board_make
+    TRACE_COPY,  // board_copy
+    TRACE_FREE,  // board_free
+    TRACE_APPLY,  // board_apply_move
+    TRACE_GET_MOVES,  // board_get_moves
+    TRACE_GET_MOVES_BUF,  // board_get_moves_buf
+    TRACE_IS_MATE,  // board_is_mate
+    TRACE_IS_STALEMATE,  // board_is_stalemate
+    TRACE_TO_FEN,  // board_to_fen
+    TRACE_NOPS
+} trace_op_t;
+
+/**
+* Starts recording library calls made from any thread into a new trace file at (path).
+* Returns 0 on success, nonzero if a trace is already being recorded, the file cannot be created,
+* or the library is compiled without CHESSLIB_TRACE.
+*/
+int trace_start(const char *path);
+
+/**
+* Stops recording and flushes the trace file. Does nothing if no trace is being recorded.
+*/
+void trace_stop(void);
+
+/**
+* Re-executes the (len) byte trace in (trace), counting executed calls by op into (counts).
+* Boards still allocated at the end of the trace are freed.
+* Returns 0 on success, nonzero if the trace is not of this format (TRACE_MAGIC and TRACE_BOARD), or is
+* malformed, in which case the calls up to the malformed record are executed.
+*/
+int trace_replay(const char *trace, size_t len, uint64_t counts[TRACE_NOPS]);
+
+// hooks used by the library internals
+#if defined(CHESSLIB_TRACE) && !defined(__cplusplus)
+#include <stdatomic.h>
+
+extern atomic_int _trace_on;
+extern _Thread_local int _trace_depth;
+
+void _trace_record(trace_op_t op, const board_t *board, uint64_t arg);
+void _trace_record_make(const board_t *board, const char *fen);
+
+static inline void _trace_leave(const int *nested) {
+    (void) nested;
+    --_trace_depth;
+}
+
+#ifdef CHESSLIB_QWORD_MOVE
+#define _TRACE_MOVE(move) (move)
+#else
+#define _TRACE_MOVE(move) (((uint64_t) (move)->frompos) | ((uint64_t) (move)->topos << 8) \
+    | ((uint64_t) (move)->killpos << 16) | ((uint64_t) (move)->frompc << 24) | ((uint64_t) (move)->topc << 32) \
+    | ((uint64_t) (move)->killpc << 40))
+#endif
+
+#define _TRACING() (!_trace_nested && atomic_load_explicit(&_trace_on, memory_order_relaxed))
+
+// marks a traced call; calls made before leaving the enclosing scope are not recorded
+#define TRACE_SCOPE() const int _trace_nested __attribute__((cleanup(_trace_leave))) = _trace_depth++
+#define TRACE_CALL(op, board) do { if (_TRACING()) _trace_record((op), (board), 0); } while (0)
+#define TRACE_COPY(board, other) do { if (_TRACING()) _trace_record(TRACE_COPY, (board), (uint64_t) (uintptr_t) (other)); } while (0)
+#define TRACE_APPLY(board, move) do { if (_TRACING()) _trace_record(TRACE_APPLY, (board), _TRACE_MOVE(move)); } while (0)
+#define TRACE_MAKE(board, fen) do { if (_TRACING()) _trace_record_make((board), (fen)); } while (0)
+#else
+#define TRACE_SCOPE()
+#define TRACE_CALL(op, board) ((void) 0)
+#define TRACE_COPY(board, other) ((void) 0)
+#define TRACE_APPLY(board, move) ((void) 0)
+#define TRACE_MAKE(board, fen) ((void) 0)
+#endif
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "defs.h"
+#include "board.h"
+#include "move.h"
+#include "move16.h"
+#include "mapfile.h"
+
+/**
+* Training records: positions of games, with what a learner is trained on, in fixed-size binary records that are
+* read in place (e.g., memory mapped as a NumPy structured array) rather than decoded.
+* A file is the magic "CLTR", a version (TRAIN_VERSION, uint32), the size of a record (uint32) and 4 zero bytes,
+* followed by records, all integers little-endian. Each record (train_record_t) is:
+*   uint32 ranks [8] and uint32 flags of the board_t of the position, its pieces as nibbles (see include/board.h),
+*   int16 score of the position in centipawns for the player to move, TRAIN_NO_SCORE if it was not scored,
+*   uint16 move played from the position packed in 16 bits (see include/move16.h), 0 for the last of a game,
+*   uint8 player to move (0 for white, 1 for black), uint8 result of the game (RESULT_*, see include/defs.h),
+*   uint16 ply of the position in its game, and uint32 number of its game.
+* Records are 16 bytes aligned from the start of the file, so that the records of a file of n records are those of
+* a train_record_t [n] at offset TRAIN_HEADER on little-endian hosts.
+*/
+
+#define TRAIN_VERSION 1
+#define TRAIN_HEADER 16
+#define TRAIN_BUFFER (1 << 20)
+#define TRAIN_NO_SCORE INT16_MIN
+
+typedef struct {
+    uint32_t ranks[8];
+    uint32_t flags;
+    int16_t score;
+    move16_t move;
+    uint8_t player;
+    uint8_t result;
+    uint16_t ply;
+    uint32_t game;
+} train_record_t;
+
+typedef struct {
+    FILE *file;
+    uint8_t *buf;
+    size_t len;  // bytes in (buf)
+    int error;
+} train_writer_t;
+
+/**
+* The (len) records of a file read with train_open, mapped (or read) at (records).
+*/
+typedef struct {
+    const train_record_t *records;
+    size_t len;
+    mapfile_t file;  // the mapping of (records)
+} train_file_t;
+
+/**
+* Creates the file of records at (path), to write records to. Returns NULL if the file cannot be written.
+*/
+train_writer_t *train_create(const char *path);
+
+/**
+* Writes the record of the position (board) of ply (ply) of game (game) with the result (result), from which
+* (move) (0 for none) was played, scored (score) (TRAIN_NO_SCORE for none), buffered. Scores are clamped to the
+* range of int16. Returns 0 on success, nonzero if the file cannot be written.
+*/
+int train_write(train_writer_t *writer, const board_t *board, move_t move, int score, int result, uint32_t game,
+                int ply);
+
+/**
+* Writes the records of the (len + 1) positions of the game (game) of the (len) legal moves played from (start)
+* with the result (result), as train_write, with the scores of the positions before each move (scores) (NULL if
+* none were scored). Returns 0 on success, nonzero if the file cannot be written.
+*/
+int train_write_game(train_writer_t *writer, const board_t *start, const move_t *moves, const int *scores,
+                     size_t len, int result, uint32_t game);
+
+/**
+* Closes the file of records, writing what remains of its buffer, and frees the writer. Returns 0 on success,
+* nonzero if the file could not be written.
+*/
+int train_close(train_writer_t *writer);
+
+/**
+* Maps the file of records at (path) read-only. Returns NULL if the file cannot be read, or is not a file of
+* records of this version.
+*/
+train_file_t *train_open(const char *path);
+
+/**
+* Unmaps a file of records, and frees it.
+*/
+void train_free(train_file_t *file);
+
+/**
+* Restores the board of the position of a record into (dest), and the move played from it into (move), 0 if none.
+* Returns 0 on success, and -1 if the record does not hold a valid board (board_is_valid), e.g., if the file is
+* corrupt, in which case (dest) and (move) are undefined.
+*/
+int train_board(const train_record_t *record, board_t *dest, move_t *move);
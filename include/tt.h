@@ -0,0 +1,109 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "defs.h"
+#include "move.h"
+#include "move16.h"
+
+/**
+* A fixed-size transposition table keyed by Zobrist hash (see board_t), safe to share between threads without locks.
+* The table is an array of cache line sized buckets of TT_BUCKET entries. An entry is a pair of 64 bit words,
+* (data) and (key), the XOR of the hash and (data); both are written and read separately without locking,
+* and a torn entry, whose words come from different stores, fails verification against the probed hash,
+* so it reads as a miss rather than as wrong data.
+* Replacement prefers the entry for the same position, then the entry with the lowest depth, less 8 plies
+* for every search (generation) since it was stored.
+*/
+
+#define TT_BUCKET 4
+
+// bounds of stored scores
+#define TT_NONE 0
+#define TT_LOWER 1  // fail high: the score is a lower bound
+#define TT_UPPER 2  // fail low: the score is an upper bound
+#define TT_EXACT 3
+
+// compact move stored in an entry (see include/move16.h), which identifies a legal move in a position
+#define TT_MOVE(move) move16_make(move)
+
+typedef struct {
+    uint64_t key;
+    uint64_t data;
+} tt_entry_t;
+
+typedef struct {
+    tt_entry_t entries[TT_BUCKET];
+} __attribute__((aligned(64))) tt_bucket_t;
+
+/**
+* A transposition table of (mask) + 1 buckets in (bytes) bytes, at search generation (gen).
+* (hugepages) is set if the table is backed by explicit huge pages.
+*/
+typedef struct {
+    tt_bucket_t *buckets;
+    uint64_t mask;
+    size_t bytes;
+    uint8_t gen;
+    int hugepages;
+    void *mem;  // allocation backing the buckets
+    int mapped;  // nonzero if (mem) was mapped rather than allocated
+} tt_t;
+
+/**
+* A probed entry: the compact move (TT_MOVE, 0 if none), score, depth, and bound (TT_LOWER, TT_UPPER, TT_EXACT).
+*/
+typedef struct {
+    move16_t move;
+    int16_t score;
+    uint8_t depth;
+    uint8_t bound;
+} tt_hit_t;
+
+/**
+* Returns a cleared table of the largest power of two number of buckets that fits in (mb) megabytes (at least one).
+* If (hugepages) is set, tries to back the table with explicit huge pages, and otherwise advises the kernel to use
+* transparent huge pages, where supported.
+*/
+tt_t *tt_make(size_t mb, int hugepages);
+
+/**
+* Frees a table and all associated data.
+*/
+void tt_free(tt_t *tt);
+
+/**
+* Clears all entries of the table. Must not be called while the table is in use.
+*/
+void tt_clear(tt_t *tt);
+
+/**
+* Starts a new search generation, aging the entries stored so far. Must not be called while the table is in use.
+*/
+void tt_new_search(tt_t *tt);
+
+/**
+* Looks up the position with the given hash, and stores its entry in (hit).
+* Returns 0 iff the position is not in the table.
+*/
+int tt_probe(const tt_t *tt, uint64_t hash, tt_hit_t *hit);
+
+/**
+* Stores an entry for the position with the given hash.
+* (move) may be 0 if there is no best move, in which case the move already stored for the position is kept.
+* (score) is clamped to 16 bits and (depth) to [0, 255].
+*/
+void tt_store(tt_t *tt, uint64_t hash, move_t move, int score, int depth, int bound);
+
+/**
+* Returns the approximate permille of entries used in the current generation.
+*/
+int tt_hashfull(const tt_t *tt);
+
+/**
+* Hints the processor to start loading the bucket of the given hash into cache, ahead of a probe or store.
+*/
+static inline void tt_prefetch(const tt_t *tt, uint64_t hash) {
+    __builtin_prefetch(&tt->buckets[hash & tt->mask]);
+}
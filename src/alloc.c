@@ -0,0 +1,64 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdatomic.h>
+
+#include "alloc.h"
+
+static alloc_t _alloc = {malloc, calloc, free};
+static atomic_uint_fast64_t _alloc_allocs;
+static atomic_uint_fast64_t _alloc_frees;
+static atomic_uint_fast64_t _alloc_bytes;
+static _Thread_local int _alloc_forbidden;
+
+void alloc_set(const alloc_t *allocator) {
+    if (allocator) {
+        _alloc = *allocator;
+    } else {
+        _alloc.malloc_func = malloc;
+        _alloc.calloc_func = calloc;
+        _alloc.free_func = free;
+    }
+}
+
+void alloc_stats(alloc_stats_t *dest) {
+    dest->allocs = atomic_load_explicit(&_alloc_allocs, memory_order_relaxed);
+    dest->frees = atomic_load_explicit(&_alloc_frees, memory_order_relaxed);
+    dest->bytes = atomic_load_explicit(&_alloc_bytes, memory_order_relaxed);
+}
+
+void alloc_reset_stats(void) {
+    atomic_store_explicit(&_alloc_allocs, 0, memory_order_relaxed);
+    atomic_store_explicit(&_alloc_frees, 0, memory_order_relaxed);
+    atomic_store_explicit(&_alloc_bytes, 0, memory_order_relaxed);
+}
+
+void alloc_forbid(int forbid) {
+    _alloc_forbidden = forbid;
+}
+
+static void _alloc_count(size_t size) {
+    if (_alloc_forbidden) {
+        fprintf(stderr, "allocation of %zu bytes while allocations are forbidden\n", size);
+        exit(EXIT_FAILURE);
+    }
+    atomic_fetch_add_explicit(&_alloc_allocs, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&_alloc_bytes, size, memory_order_relaxed);
+}
+
+void *alloc_malloc(size_t size) {
+    _alloc_count(size);
+    return _alloc.malloc_func(size);
+}
+
+void *alloc_calloc(size_t n, size_t size) {
+    _alloc_count(n * size);
+    return _alloc.calloc_func(n, size);
+}
+
+void alloc_free(void *ptr) {
+    if (!ptr) {
+        return;
+    }
+    atomic_fetch_add_explicit(&_alloc_frees, 1, memory_order_relaxed);
+    _alloc.free_func(ptr);
+}
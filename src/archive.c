@@ -0,0 +1,248 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "archive.h"
+#include "alloc.h"
+#include "eval.h"
+
+#ifndef CHESSLIB_QWORD_MOVE
+#error "archive requires CHESSLIB_QWORD_MOVE"
+#endif
+
+#define ARCHIVE_HEADER 8
+#define ARCHIVE_GAME_HEADER 4
+#define ARCHIVE_POSITION 36
+#define ARCHIVE_GAME_MAX (ARCHIVE_GAME_HEADER + ARCHIVE_POSITION + ARCHIVE_PLIES_MAX)
+
+static board_t _archive_start;
+
+__attribute__((constructor)) static void _archive_init(void) {
+    board_t *start = board_make(STARTING_BOARD);
+    _archive_start = *start;
+    board_free(start);
+}
+
+static void *_archive_alloc(size_t size) {
+    void *ret = alloc_malloc(size);
+    if (!ret) {
+        fprintf(stderr, "malloc error in archive\n");
+        exit(EXIT_FAILURE);
+    }
+    return ret;
+}
+
+static inline void _archive_write32(uint8_t *p, uint32_t v) {
+    p[0] = v & 0xff;
+    p[1] = (v >> 8) & 0xff;
+    p[2] = (v >> 16) & 0xff;
+    p[3] = v >> 24;
+}
+
+static inline uint32_t _archive_read32(const uint8_t *p) {
+    return (uint32_t) p[0] | (uint32_t) p[1] << 8 | (uint32_t) p[2] << 16 | (uint32_t) p[3] << 24;
+}
+
+// the order of moves in archives: by origin, destination, and promotion piece
+static inline uint32_t _archive_key(move_t move) {
+    const uint32_t promo = MVTOPC(move) != MVFROMPC(move) ? MVTOPC(move) % BPAWN : 0;
+    return (uint32_t) MVFROMPOS(move) << 9 | (uint32_t) MVTOPOS(move) << 3 | promo;
+}
+
+int archive_encode(const move_t *moves, size_t len, move_t move) {
+    const uint32_t key = _archive_key(move);
+    int rank = 0, found = 0;
+    for (size_t i = 0; i < len; ++i) {
+        const uint32_t other = _archive_key(moves[i]);
+        rank += other < key;
+        found |= other == key;
+    }
+    return found ? rank : -1;
+}
+
+move_t archive_decode(const move_t *moves, size_t len, int rank) {
+    if (rank < 0 || (size_t) rank >= len) {
+        return 0;
+    }
+    // insertion sort, as moves are generated nearly in order already
+    move_t sorted[BOARD_MOVES_MAX];
+    uint32_t keys[BOARD_MOVES_MAX];
+    for (size_t i = 0; i < len; ++i) {
+        const uint32_t key = _archive_key(moves[i]);
+        size_t j = i;
+        for (; j > 0 && keys[j - 1] > key; --j) {
+            keys[j] = keys[j - 1];
+            sorted[j] = sorted[j - 1];
+        }
+        keys[j] = key;
+        sorted[j] = moves[i];
+    }
+    return sorted[rank];
+}
+
+static archive_t *_archive_make(FILE *file, size_t cap) {
+    archive_t *ret = (archive_t *) alloc_calloc(1, sizeof(archive_t));
+    if (!ret) {
+        fprintf(stderr, "calloc error in archive\n");
+        exit(EXIT_FAILURE);
+    }
+    ret->file = file;
+    ret->buf = (uint8_t *) _archive_alloc(cap);
+    ret->cap = cap;
+    return ret;
+}
+
+archive_t *archive_create(const char *path) {
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        return NULL;
+    }
+    archive_t *ret = _archive_make(file, ARCHIVE_BUFFER + ARCHIVE_GAME_MAX);
+    memcpy(ret->buf, "CLGA", 4);
+    _archive_write32(&ret->buf[4], ARCHIVE_VERSION);
+    ret->len = ARCHIVE_HEADER;
+    ret->writing = 1;
+    return ret;
+}
+
+archive_t *archive_open(const char *path) {
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        return NULL;
+    }
+    uint8_t header[ARCHIVE_HEADER];
+    if (fread(header, 1, ARCHIVE_HEADER, file) != ARCHIVE_HEADER || memcmp(header, "CLGA", 4)
+        || _archive_read32(&header[4]) != ARCHIVE_VERSION) {
+        fclose(file);
+        return NULL;
+    }
+    return _archive_make(file, ARCHIVE_BUFFER + ARCHIVE_GAME_MAX);
+}
+
+static int _archive_flush(archive_t *archive) {
+    if (archive->len && fwrite(archive->buf, 1, archive->len, archive->file) != archive->len) {
+        archive->error = 1;
+    }
+    archive->len = 0;
+    return archive->error;
+}
+
+int archive_write(archive_t *archive, const board_t *start, const move_t *moves, size_t len, int result) {
+    if (len > ARCHIVE_PLIES_MAX) {
+        len = ARCHIVE_PLIES_MAX;
+    }
+    uint8_t *p = &archive->buf[archive->len];
+    *p++ = (uint8_t) result;
+    *p++ = start != NULL;
+    *p++ = len & 0xff;
+    *p++ = len >> 8;
+    board_t board = start ? *start : _archive_start;
+    if (start) {
+        for (int rk = 0; rk < 8; ++rk, p += 4) {
+            _archive_write32(p, start->ranks[rk]);
+        }
+        _archive_write32(p, start->flags);
+        p += 4;
+    }
+    for (size_t i = 0; i < len; ++i) {
+        move_t legal[BOARD_MOVES_MAX];
+        const size_t n = board_get_moves_buf(&board, legal);
+        const int rank = archive_encode(legal, n, moves[i]);
+        if (rank < 0 || rank > UINT8_MAX) {
+            return 1;  // not a game, or not one a byte per ply holds; the buffer is left as it was
+        }
+        *p++ = (uint8_t) rank;
+        board_apply_move(&board, moves[i]);
+    }
+    archive->len = p - archive->buf;
+    return archive->len >= ARCHIVE_BUFFER ? _archive_flush(archive) : archive->error;
+}
+
+// makes at least (n) unread bytes available in the buffer, if the file has them
+static size_t _archive_fill(archive_t *archive, size_t n) {
+    size_t avail = archive->len - archive->pos;
+    if (avail < n) {
+        memmove(archive->buf, &archive->buf[archive->pos], avail);
+        archive->pos = 0;
+        archive->len = avail;
+        archive->len += fread(&archive->buf[avail], 1, archive->cap - avail, archive->file);
+        avail = archive->len;
+    }
+    return avail;
+}
+
+int archive_read(archive_t *archive, archive_game_t *dest) {
+    size_t avail = _archive_fill(archive, ARCHIVE_GAME_HEADER + ARCHIVE_POSITION);
+    if (!avail) {
+        return 0;
+    }
+    if (avail < ARCHIVE_GAME_HEADER) {
+        return -1;
+    }
+    const uint8_t *p = &archive->buf[archive->pos];
+    const int result = p[0], start = p[1];
+    const size_t len = p[2] | (size_t) p[3] << 8;
+    const size_t size = ARCHIVE_GAME_HEADER + (start ? ARCHIVE_POSITION : 0) + len;
+    if (result > 3 || start > 1 || _archive_fill(archive, size) < size) {
+        return -1;
+    }
+    p = &archive->buf[archive->pos] + ARCHIVE_GAME_HEADER;
+
+    if (archive->movescap < len + 1) {
+        alloc_free(archive->moves);
+        alloc_free(archive->boards);
+        archive->movescap = 2 * (len + 1);
+        archive->moves = (move_t *) _archive_alloc(archive->movescap * sizeof(move_t));
+        archive->boards = (board_t *) _archive_alloc(archive->movescap * sizeof(board_t));
+    }
+    board_t *board = &archive->boards[0];
+    if (start) {
+        memset(board, 0, sizeof(board_t));
+        for (int rk = 0; rk < 8; ++rk, p += 4) {
+            board->ranks[rk] = _archive_read32(p);
+        }
+        board->flags = _archive_read32(p);
+        p += 4;
+        if (!board_is_valid(board)) {
+            return -1;
+        }
+        board->hash = board_hash(board);
+        eval_reset(board);
+    } else {
+        *board = _archive_start;
+    }
+    for (size_t i = 0; i < len; ++i, ++board) {
+        move_t legal[BOARD_MOVES_MAX];
+        const size_t n = board_get_moves_buf(board, legal);
+        const move_t move = archive_decode(legal, n, *p++);
+        if (!move) {
+            return -1;
+        }
+        archive->moves[i] = move;
+        board[1] = *board;
+        board_apply_move(&board[1], move);
+    }
+    archive->pos += size;
+    dest->moves = archive->moves;
+    dest->boards = archive->boards;
+    dest->len = len;
+    dest->result = result;
+    return 1;
+}
+
+int archive_close(archive_t *archive) {
+    int ret = 0;
+    if (archive) {
+        if (archive->writing) {
+            ret = _archive_flush(archive);
+        }
+        if (fclose(archive->file)) {
+            ret = 1;
+        }
+        alloc_free(archive->buf);
+        alloc_free(archive->moves);
+        alloc_free(archive->boards);
+        alloc_free(archive);
+    }
+    return ret;
+}
@@ -3,16 +3,17 @@
 #include <string.h>
 
 #include "arraylist.h"
+#include "alloc.h"
 
 alst_t *alst_make(size_t cap) {
-  alst_t *ret = (alst_t *) malloc(sizeof(alst_t));
+  alst_t *ret = (alst_t *) alloc_malloc(sizeof(alst_t));
   if (!ret) {
     fprintf(stderr, "alst_make malloc failure 1\n");
     exit(EXIT_FAILURE);
   }
   ret->len = 0;
   ret->cap = (cap < 10) ? 10 : cap;
-  ret->data = malloc(cap * sizeof(void *));
+  ret->data = alloc_malloc(ret->cap * sizeof(void *));
   if (!(ret->data)) {
     fprintf(stderr, "alst_make malloc failure 2\n");
     exit(EXIT_FAILURE);
@@ -30,8 +31,8 @@ void alst_free(alst_t *list, void (*free_func)(void *)) {
   }
 ALST_FREE_DONE:
   // free the array
-  free(list->data);
-  free(list);
+  alloc_free(list->data);
+  alloc_free(list);
 }
 
 void alst_put(alst_t *list, size_t i, void *val) {
@@ -54,13 +55,13 @@ void alst_append(alst_t *list, void *val) {
   if (list->len == list->cap) {  // expand
     list->cap *= 10;  // factor of 10
     void **old = list->data;
-    list->data = malloc(list->cap * sizeof(void *));
+    list->data = alloc_malloc(list->cap * sizeof(void *));
     if (!(list->data)) {
       fprintf(stderr, "alst_append malloc failure\n");
       exit(EXIT_FAILURE);
     }
     memcpy(list->data, old, list->len * sizeof(void *));
-    free(old);
+    alloc_free(old);
   }
   list->data[list->len++] = val;
 }
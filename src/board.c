@@ -5,9 +5,61 @@
 
 #include "board.h"
 #include "parseutils.h"
+#include "stats.h"
+#include "alloc.h"
+#include "trace.h"
+#include "eval.h"
+
+// Zobrist keys, drawn from a fixed seed so hashes are stable across runs
+static uint64_t _zobrist_pcs[NOPC + 1][64];  // by piece and position, 0 for NOPC
+static uint64_t _zobrist_castle[16];  // by castling rights
+static uint64_t _zobrist_ep[NOPOS + 1];  // by en passant position, 0 for NOPOS
+static uint64_t _zobrist_black;  // black to move
+
+static uint64_t _zobrist_next(uint64_t *state) {  // splitmix64
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+__attribute__((constructor)) static void _zobrist_init(void) {
+    uint64_t state = 0x636865736c6962ULL;
+    for (int pc = 0; pc < 12; ++pc) {
+        for (int pos = 0; pos < 64; ++pos) {
+            _zobrist_pcs[pc][pos] = _zobrist_next(&state);
+        }
+    }
+    for (int i = 0; i < 16; ++i) {
+        _zobrist_castle[i] = _zobrist_next(&state);
+    }
+    for (int pos = 0; pos < NOPOS; ++pos) {
+        _zobrist_ep[pos] = _zobrist_next(&state);
+    }
+    _zobrist_ep[NOPOS] = 0;
+    _zobrist_black = _zobrist_next(&state);
+}
+
+uint64_t board_hash(const board_t *board) {
+    uint64_t hash = 0;
+    for (int rk = 0; rk < 8; ++rk) {
+        uint32_t rank = board->ranks[rk];
+        for (int offs = 0; offs < 8; ++offs) {
+            hash ^= _zobrist_pcs[rank & 0xf][POS2(offs, rk)];  // NOPC hashes to 0, without a branch
+            rank >>= 4;
+        }
+    }
+    hash ^= _zobrist_castle[FLAGS_CASTLE(board->flags)];
+    hash ^= _zobrist_ep[FLAGS_EP(board->flags)];
+    if (FLAGS_BPLAYER(board->flags)) {
+        hash ^= _zobrist_black;
+    }
+    return hash;
+}
 
 board_t *board_make(const char *fen) {
-    board_t *ret = (board_t *) calloc(1, sizeof(board_t));
+    TRACE_SCOPE();
+    board_t *ret = (board_t *) alloc_calloc(1, sizeof(board_t));
     if (!ret) {
         fprintf(stderr, "malloc error in board_make\n");
         exit(EXIT_FAILURE);
@@ -83,23 +135,36 @@ board_t *board_make(const char *fen) {
     // set en passant bits and position from fen ep data
     SETEP(strchr(ep_p, '-') ? NOPOS : POS(ep_p[0], ep_p[1] - '0'), ret->flags);
 
+    ret->hash = board_hash(ret);
+    eval_reset(ret);
+
     // free(fencpy);
+    TRACE_MAKE(ret, fen);
     return ret;
 }
 
 board_t *board_copy(const board_t *other) {
-    board_t *ret = (board_t *) malloc(sizeof(board_t));
+    STATS_INC(copy);
+    TRACE_SCOPE();
+    board_t *ret = (board_t *) alloc_malloc(sizeof(board_t));
     if (!ret) {
         fprintf(stderr, "malloc error in board_copy\n");
         exit(EXIT_FAILURE);
     }
     memcpy(&ret->ranks, &other->ranks, sizeof(int32_t) * 8);  // copy ranks
     ret->flags = other->flags;  // copy flags
+    ret->hash = other->hash;  // copy hash
+    ret->mg = other->mg;  // copy evaluation terms
+    ret->eg = other->eg;
+    ret->phase = other->phase;
+    TRACE_COPY(ret, other);
     return ret;
 }
 
 void board_free(const board_t *other) {
-    free((void *) other);
+    TRACE_SCOPE();
+    TRACE_CALL(TRACE_FREE, other);
+    alloc_free((void *) other);
 }
 
 #ifdef CHESSLIB_QWORD_MOVE
@@ -107,6 +172,10 @@ void board_apply_move(board_t *board, const move_t move) {
 #else
 void board_apply_move(board_t *board, const move_t *move) {
 #endif
+    STATS_INC(apply);
+    TRACE_SCOPE();
+    TRACE_APPLY(board, move);
+    const uint32_t oldflags = board->flags;
     // kill the target piece if the move is a capture
     if (move_is_cap(move)) {
 #ifdef CHESSLIB_QWORD_MOVE
@@ -167,7 +236,8 @@ void board_apply_move(board_t *board, const move_t *move) {
 #endif
 
     // also move the rook if castling
-    switch (move_is_castle(move)) {
+    const int castle = move_is_castle(move);
+    switch (castle) {
         case 0: break;
         case WKCASTLE:
             MOVEPC2('h', 'f', board->ranks[0], board->ranks[0], WROOK); break;
@@ -270,36 +340,126 @@ void board_apply_move(board_t *board, const move_t *move) {
 #endif
 
     // update Zobrist signature
-    // TODO:
+#ifdef CHESSLIB_QWORD_MOVE
+    uint64_t hash = board->hash ^ _zobrist_pcs[MVFROMPC(move)][MVFROMPOS(move)] ^ _zobrist_pcs[MVTOPC(move)][MVTOPOS(move)];
+    if (MVKILLPC(move) != NOPC) {
+        hash ^= _zobrist_pcs[MVKILLPC(move)][MVKILLPOS(move)];
+    }
+#else
+    uint64_t hash = board->hash ^ _zobrist_pcs[move->frompc][move->frompos] ^ _zobrist_pcs[move->topc][move->topos];
+    if (move->killpc != NOPC) {
+        hash ^= _zobrist_pcs[move->killpc][move->killpos];
+    }
+#endif
+    switch (castle) {
+        case 0: break;
+        case WKCASTLE:
+            hash ^= _zobrist_pcs[WROOK][POS('h', 1)] ^ _zobrist_pcs[WROOK][POS('f', 1)]; break;
+        case WQCASTLE:
+            hash ^= _zobrist_pcs[WROOK][POS('a', 1)] ^ _zobrist_pcs[WROOK][POS('d', 1)]; break;
+        case BKCASTLE:
+            hash ^= _zobrist_pcs[BROOK][POS('h', 8)] ^ _zobrist_pcs[BROOK][POS('f', 8)]; break;
+        case BQCASTLE:
+            hash ^= _zobrist_pcs[BROOK][POS('a', 8)] ^ _zobrist_pcs[BROOK][POS('d', 8)]; break;
+    }
+    hash ^= _zobrist_castle[FLAGS_CASTLE(oldflags)] ^ _zobrist_castle[FLAGS_CASTLE(board->flags)];
+    hash ^= _zobrist_ep[FLAGS_EP(oldflags)] ^ _zobrist_ep[FLAGS_EP(board->flags)];
+    hash ^= _zobrist_black;
+    board->hash = hash;
+
+    // update evaluation terms
+#ifdef CHESSLIB_QWORD_MOVE
+    int mg = board->mg - eval_mg[MVFROMPC(move)][MVFROMPOS(move)] + eval_mg[MVTOPC(move)][MVTOPOS(move)];
+    int eg = board->eg - eval_eg[MVFROMPC(move)][MVFROMPOS(move)] + eval_eg[MVTOPC(move)][MVTOPOS(move)];
+    board->phase += eval_phase[MVTOPC(move)] - eval_phase[MVFROMPC(move)];
+    if (MVKILLPC(move) != NOPC) {
+        mg -= eval_mg[MVKILLPC(move)][MVKILLPOS(move)];
+        eg -= eval_eg[MVKILLPC(move)][MVKILLPOS(move)];
+        board->phase -= eval_phase[MVKILLPC(move)];
+    }
+#else
+    int mg = board->mg - eval_mg[move->frompc][move->frompos] + eval_mg[move->topc][move->topos];
+    int eg = board->eg - eval_eg[move->frompc][move->frompos] + eval_eg[move->topc][move->topos];
+    board->phase += eval_phase[move->topc] - eval_phase[move->frompc];
+    if (move->killpc != NOPC) {
+        mg -= eval_mg[move->killpc][move->killpos];
+        eg -= eval_eg[move->killpc][move->killpos];
+        board->phase -= eval_phase[move->killpc];
+    }
+#endif
+    switch (castle) {
+        case 0: break;
+        case WKCASTLE:
+            mg += eval_mg[WROOK][POS('f', 1)] - eval_mg[WROOK][POS('h', 1)];
+            eg += eval_eg[WROOK][POS('f', 1)] - eval_eg[WROOK][POS('h', 1)]; break;
+        case WQCASTLE:
+            mg += eval_mg[WROOK][POS('d', 1)] - eval_mg[WROOK][POS('a', 1)];
+            eg += eval_eg[WROOK][POS('d', 1)] - eval_eg[WROOK][POS('a', 1)]; break;
+        case BKCASTLE:
+            mg += eval_mg[BROOK][POS('f', 8)] - eval_mg[BROOK][POS('h', 8)];
+            eg += eval_eg[BROOK][POS('f', 8)] - eval_eg[BROOK][POS('h', 8)]; break;
+        case BQCASTLE:
+            mg += eval_mg[BROOK][POS('d', 8)] - eval_mg[BROOK][POS('a', 8)];
+            eg += eval_eg[BROOK][POS('d', 8)] - eval_eg[BROOK][POS('a', 8)]; break;
+    }
+    board->mg = mg;
+    board->eg = eg;
 }
 
-int board_is_mate(const board_t *board) {
-    pos_t kingpos = FLAGS_WPLAYER(board->flags) ? FLAGS_WKING(board->flags) : FLAGS_BKING(board->flags);
+int board_in_check(const board_t *board) {
+    const pos_t kingpos = FLAGS_WPLAYER(board->flags) ? FLAGS_WKING(board->flags) : FLAGS_BKING(board->flags);
+    return _board_hit(board, kingpos / 8, kingpos % 8, FLAGS_BPLAYER(board->flags));
+}
 
-    int incheck = _board_hit(board, kingpos / 8, kingpos % 8, FLAGS_BPLAYER(board->flags));
+int board_count_pieces(const board_t *board) {
+    int n = 0;
+    for (int rk = 0; rk < 8; ++rk) {
+        uint32_t rank = board->ranks[rk];
+        for (int offs = 0; offs < 8; ++offs, rank >>= 4) {
+            n += (rank & 0xf) != NOPC;
+        }
+    }
+    return n;
+}
+
+int board_is_valid(const board_t *board) {
+    int wkings = 0, bkings = 0;
+    for (int rk = 0; rk < 8; ++rk) {
+        uint32_t rank = board->ranks[rk];
+        for (int offs = 0; offs < 8; ++offs, rank >>= 4) {
+            const int pc = rank & 0xf;
+            if (pc > NOPC) {
+                return 0;
+            }
+            if (pc == WKING || pc == BKING) {  // only at the position of its king, so at most one per player
+                const uint32_t kingpos = pc == WKING ? FLAGS_WKING(board->flags) : FLAGS_BKING(board->flags);
+                if ((uint32_t) POS2(offs, rk) != kingpos) {
+                    return 0;
+                }
+                wkings += pc == WKING;
+                bkings += pc == BKING;
+            }
+        }
+    }
+    return wkings == 1 && bkings == 1 && FLAGS_EP(board->flags) <= NOPOS;
+}
 
-    if (!incheck) {  // do the easy stuff first
+int board_is_mate(const board_t *board) {
+    TRACE_SCOPE();
+    TRACE_CALL(TRACE_IS_MATE, board);
+    if (!board_in_check(board)) {  // do the easy stuff first
         return 0;
     }
 
-    int ret = 0;
-    alst_t *moves = board_get_moves(board);
-    ret = moves->len == 0;  // in check and no moves -> mate
-#ifdef CHESSLIB_QWORD_MOVE
-    alst_free(moves, NULL);
-#else
-    alst_free(moves, (void (*) (void *)) move_free);
-#endif
-    return ret;
+    move_t moves[BOARD_MOVES_MAX];
+    return board_get_moves_buf(board, moves) == 0;  // in check and no moves -> mate
 }
 
 int board_is_stalemate(const board_t *board) {
-    pos_t kingpos = FLAGS_WPLAYER(board->flags) ? FLAGS_WKING(board->flags) : FLAGS_BKING(board->flags);
-
-    int incheck = _board_hit(board, kingpos / 8, kingpos % 8, FLAGS_BPLAYER(board->flags));
-
+    TRACE_SCOPE();
+    TRACE_CALL(TRACE_IS_STALEMATE, board);
     // not stalemate if king is in check (easy)
-    if (incheck) {
+    if (board_in_check(board)) {
         return 0;
     }
 
@@ -323,6 +483,7 @@ int board_is_stalemate(const board_t *board) {
                 bbishop_pos = POS2(offs, rk);
             }
             ++counts[pc];
+            rank >>= 4;  // next pc in rank
         }
     }
 
@@ -365,19 +526,14 @@ int board_is_stalemate(const board_t *board) {
     }
 
     // 3. not in check, sufficient mating material; stalemate if no moves (hard)
-    int ret = 0;
-    alst_t *moves = board_get_moves(board);
-    ret = moves->len == 0;  // not in check and no moves -> stalemate
-#ifdef CHESSLIB_QWORD_MOVE
-    alst_free(moves, NULL);
-#else
-    alst_free(moves, (void (*) (void *)) move_free);
-#endif
-    return ret;
+    move_t moves[BOARD_MOVES_MAX];
+    return board_get_moves_buf(board, moves) == 0;  // not in check and no moves -> stalemate
 }
 
 // returned buffer is static
 char *board_to_fen(const board_t *board) {
+    TRACE_SCOPE();
+    TRACE_CALL(TRACE_TO_FEN, board);
     // make output buffer
     static char ret[100];
     ret[0] = '\0';
@@ -0,0 +1,431 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "epd.h"
+#include "alloc.h"
+#include "mapfile.h"
+#include "eval.h"
+
+// a chunk: the counts of its lines that may be positions, of their operations and of the bytes of these, then
+// the offsets of its positions, operations and bytes into the arrays, the counts of those read, and the counts of
+// the first pass, which bound the operations and bytes of the second
+typedef struct {
+    size_t boards;
+    size_t ops;
+    size_t strs;
+    size_t capops;
+    size_t capstrs;
+    size_t nboards;
+    size_t nops;
+    size_t errors;
+} _epd_chunk_t;
+
+typedef struct {
+    const char *text;
+    size_t len;
+    mapfile_pool_t pool;  // of the chunks of (text)
+    int pass;  // 0 to count lines, 1 to parse them
+    _epd_chunk_t *chunks;
+    epd_t *epd;
+} _epd_load_t;
+
+// the characters of FEN ranks: pieces, EPD_EMPTY plus the count of empty positions, or EPD_BAD
+#define EPD_EMPTY 16
+#define EPD_BAD 0xff
+static uint8_t _epd_chars[256];
+
+__attribute__((constructor)) static void _epd_init(void) {
+    memset(_epd_chars, EPD_BAD, sizeof _epd_chars);
+    const char *pcs = "PNBRQKpnbrqk";
+    for (int pc = WPAWN; pc < NOPC; ++pc) {
+        _epd_chars[(unsigned char) pcs[pc]] = pc;
+    }
+    for (int n = 1; n <= 8; ++n) {
+        _epd_chars['0' + n] = EPD_EMPTY + n;
+    }
+}
+
+static inline int _epd_pc(const board_t *board, int pos) {
+    return (board->ranks[pos / 8] >> ((pos % 8) << 2)) & 0xf;
+}
+
+// whether the castling rights, en passant position and pawns of a board are those of a position: castling rights
+// need their king and rook on their initial positions, an en passant position the pawn that just moved past it
+// (and nothing on it or behind it), and pawns stand between the second and seventh ranks
+static int _epd_consistent(const board_t *board) {
+    const uint32_t flags = board->flags;
+    if ((FLAGS_WKCASTLE(flags) && (_epd_pc(board, POS('e', 1)) != WKING || _epd_pc(board, POS('h', 1)) != WROOK))
+        || (FLAGS_WQCASTLE(flags) && (_epd_pc(board, POS('e', 1)) != WKING || _epd_pc(board, POS('a', 1)) != WROOK))
+        || (FLAGS_BKCASTLE(flags) && (_epd_pc(board, POS('e', 8)) != BKING || _epd_pc(board, POS('h', 8)) != BROOK))
+        || (FLAGS_BQCASTLE(flags) && (_epd_pc(board, POS('e', 8)) != BKING || _epd_pc(board, POS('a', 8)) != BROOK))) {
+        return 0;
+    }
+    const int ep = FLAGS_EP(flags);
+    if (ep != NOPOS) {
+        const int white = FLAGS_WPLAYER(flags);
+        const int dir = white ? -8 : 8;  // toward the pawn that moved
+        if (ep / 8 != (white ? 5 : 2) || _epd_pc(board, ep) != NOPC || _epd_pc(board, ep - dir) != NOPC
+            || _epd_pc(board, ep + dir) != (white ? BPAWN : WPAWN)) {
+            return 0;
+        }
+    }
+    for (int offs = 0; offs < 8; ++offs) {
+        const int first = _epd_pc(board, POS2(offs, 0));
+        const int last = _epd_pc(board, POS2(offs, 7));
+        if (first == WPAWN || first == BPAWN || last == WPAWN || last == BPAWN) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void *_epd_alloc(size_t size) {
+    void *ret = alloc_malloc(size ? size : 1);
+    if (!ret) {
+        fprintf(stderr, "malloc error in epd\n");
+        exit(EXIT_FAILURE);
+    }
+    return ret;
+}
+
+static inline int _epd_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+// skips white space from (p) to (end)
+static inline const char *_epd_skip(const char *p, const char *end) {
+    while (p < end && _epd_space(*p)) {
+        ++p;
+    }
+    return p;
+}
+
+// reads the pieces, player, castling rights and en passant position from (p) to (end), without the hash and
+// scores; returns the end of the fields, or NULL. Fields are separated by white space, so that they end where
+// _epd_fields finds them. Boards on which the player not to move is in check are not positions, as their kings
+// could be taken, nor are boards of inconsistent castling rights, en passant position or pawns (_epd_consistent).
+static const char *_epd_fen(const char *p, const char *end, board_t *dest) {
+    memset(dest, 0, sizeof(board_t));
+    int wkings = 0, bkings = 0;
+    for (int rk = 7; rk >= 0; --rk) {
+        uint32_t rank = 0;
+        int offs = 0;
+        while (offs < 8 && p < end) {
+            const int pc = _epd_chars[(unsigned char) *p++];
+            if (pc >= NOPC) {
+                const int n = pc - EPD_EMPTY;
+                if (pc == EPD_BAD || offs + n > 8) {
+                    return NULL;
+                }
+                rank |= (uint32_t) (0xccccccccULL >> (32 - 4 * n)) << (offs << 2);  // n NOPC nibbles
+                offs += n;
+                continue;
+            }
+            if (pc == WKING) {
+                SETWKING(POS2(offs, rk), dest->flags);
+                ++wkings;
+            } else if (pc == BKING) {
+                SETBKING(POS2(offs, rk), dest->flags);
+                ++bkings;
+            }
+            rank |= (uint32_t) pc << (offs++ << 2);
+        }
+        if (offs != 8 || (rk && (p >= end || *p++ != '/'))) {
+            return NULL;
+        }
+        dest->ranks[rk] = rank;
+    }
+    if (wkings != 1 || bkings != 1 || p >= end || !_epd_space(*p)) {
+        return NULL;
+    }
+
+    p = _epd_skip(p, end);
+    if (p + 1 >= end || (*p != 'w' && *p != 'b') || !_epd_space(p[1])) {
+        return NULL;
+    }
+    SETPLAYER(*p == 'w' ? WPLAYER : BPLAYER, dest->flags);
+
+    p = _epd_skip(p + 1, end);
+    if (p < end && *p == '-') {
+        if (++p >= end || !_epd_space(*p)) {
+            return NULL;
+        }
+    } else {
+        const char *start = p;
+        for (; p < end && !_epd_space(*p); ++p) {
+            switch (*p) {
+            case 'K': SETCASTLE(WKCASTLE, dest->flags); break;
+            case 'Q': SETCASTLE(WQCASTLE, dest->flags); break;
+            case 'k': SETCASTLE(BKCASTLE, dest->flags); break;
+            case 'q': SETCASTLE(BQCASTLE, dest->flags); break;
+            default: return NULL;
+            }
+        }
+        if (p == start) {
+            return NULL;
+        }
+    }
+
+    p = _epd_skip(p, end);
+    if (p < end && *p == '-') {
+        SETEP(NOPOS, dest->flags);
+        ++p;
+    } else if (p + 1 < end && p[0] >= 'a' && p[0] <= 'h' && (p[1] == '3' || p[1] == '6')) {
+        SETEP(POS(p[0], p[1] - '0'), dest->flags);
+        p += 2;
+    } else {
+        return NULL;
+    }
+    const int white = FLAGS_WPLAYER(dest->flags);
+    const pos_t kingpos = white ? FLAGS_BKING(dest->flags) : FLAGS_WKING(dest->flags);
+    if (!_epd_consistent(dest) || _board_hit(dest, kingpos / 8, kingpos % 8, white)) {
+        return NULL;
+    }
+    return p == end || _epd_space(*p) || *p == ';' ? p : NULL;
+}
+
+size_t epd_parse(const char *text, size_t len, board_t *dest) {
+    const char *end = _epd_fen(text, text + len, dest);
+    if (!end) {
+        return 0;
+    }
+    dest->hash = board_hash(dest);
+    eval_reset(dest);
+    return end - text;
+}
+
+// appends an operation, or only counts it if (ops) is NULL
+static void _epd_add_op(const char *name, size_t namelen, const char *value, size_t valuelen, epd_op_t *ops,
+                        char *strs, size_t *nops, size_t *nstrs) {
+    if (ops) {
+        char *s = &strs[*nstrs];
+        memcpy(s, name, namelen);
+        s[namelen] = '\0';
+        memcpy(&s[namelen + 1], value, valuelen);
+        s[namelen + 1 + valuelen] = '\0';
+        ops[*nops].name = s;
+        ops[*nops].value = &s[namelen + 1];
+    }
+    ++*nops;
+    *nstrs += namelen + valuelen + 2;
+}
+
+// reads the operations from (p) to (end), as _epd_add_op
+static void _epd_ops(const char *p, const char *end, epd_op_t *ops, char *strs, size_t *nops, size_t *nstrs) {
+    p = _epd_skip(p, end);
+    if (p < end && *p >= '0' && *p <= '9') {  // the move counters of a FEN
+        static const char *names[2] = {"hmvc", "fmvn"};
+        for (int i = 0; i < 2 && p < end && *p >= '0' && *p <= '9'; ++i) {
+            const char *start = p;
+            while (p < end && *p >= '0' && *p <= '9') {
+                ++p;
+            }
+            _epd_add_op(names[i], 4, start, p - start, ops, strs, nops, nstrs);
+            p = _epd_skip(p, end);
+        }
+    }
+    while (p < end) {
+        p = _epd_skip(p, end);
+        if (p < end && *p == ';') {
+            ++p;
+            continue;
+        }
+        const char *name = p;
+        while (p < end && !_epd_space(*p) && *p != ';') {
+            ++p;
+        }
+        const size_t namelen = p - name;
+        if (!namelen) {
+            break;
+        }
+        // operands, up to a semicolon out of quotes
+        p = _epd_skip(p, end);
+        const char *value = p;
+        int quoted = 0;
+        while (p < end && (quoted || *p != ';')) {
+            quoted ^= *p++ == '"';
+        }
+        const char *valueend = p;
+        while (valueend > value && _epd_space(valueend[-1])) {
+            --valueend;
+        }
+        if (valueend - value >= 2 && *value == '"' && valueend[-1] == '"'
+            && !memchr(value + 1, '"', valueend - value - 2)) {
+            ++value;
+            --valueend;
+        }
+        _epd_add_op(name, namelen, value, valueend - value, ops, strs, nops, nstrs);
+    }
+}
+
+// the start of the first line starting at or after (p)
+static size_t _epd_line_start(const char *text, size_t len, size_t p) {
+    if (!p) {
+        return 0;
+    }
+    const char *nl = (const char *) memchr(&text[p - 1], '\n', len - (p - 1));
+    return nl ? (size_t) (nl - text) + 1 : len;
+}
+
+// the end of the first four fields from (p) to (end), those of a FEN if the line is a position
+static const char *_epd_fields(const char *p, const char *end) {
+    for (int i = 0; i < 4; ++i) {
+        p = _epd_skip(p, end);
+        while (p < end && !_epd_space(*p) && *p != ';') {
+            ++p;
+        }
+    }
+    return p;
+}
+
+static void _epd_chunk(_epd_load_t *load, size_t chunk) {
+    const char *text = load->text;
+    const size_t end = chunk + 1 < load->pool.nchunks ? (chunk + 1) * EPD_CHUNK : load->len;
+    size_t p = _epd_line_start(text, load->len, chunk * EPD_CHUNK);
+    _epd_chunk_t *c = &load->chunks[chunk];
+    epd_t *epd = load->epd;
+    size_t nboards = 0, nops = 0, nstrs = 0, nerrors = 0;
+    while (p < end) {
+        const char *nl = (const char *) memchr(&text[p], '\n', load->len - p);
+        const size_t lineend = nl ? (size_t) (nl - text) : load->len;
+        const char *line = _epd_skip(&text[p], &text[lineend]);
+        p = lineend + 1;
+        if (line == &text[lineend] || *line == '#') {
+            continue;
+        }
+        if (!load->pass) {
+            // counts every line that may be a position, as parsing them takes longer
+            _epd_ops(_epd_fields(line, &text[lineend]), &text[lineend], NULL, NULL, &nops, &nstrs);
+            ++nboards;
+            continue;
+        }
+        board_t *board = &epd->boards[c->boards + nboards];
+        const char *fenend = _epd_fen(line, &text[lineend], board);
+        if (!fenend) {
+            ++nerrors;
+            continue;
+        }
+        board->hash = board_hash(board);
+        eval_reset(board);
+        size_t n = 0, s = 0;
+        _epd_ops(fenend, &text[lineend], NULL, NULL, &n, &s);
+        if (nops + n > c->capops || nstrs + s > c->capstrs) {  // not as counted; never overruns the arrays
+            ++nerrors;
+            continue;
+        }
+        epd->opsidx[c->boards + nboards] = c->ops + nops;
+        n = c->ops + nops;
+        s = c->strs + nstrs;
+        _epd_ops(fenend, &text[lineend], epd->ops, epd->strs, &n, &s);
+        nops = n - c->ops;
+        nstrs = s - c->strs;
+        ++nboards;
+    }
+    if (load->pass) {
+        c->nboards = nboards;
+        c->nops = nops;
+        c->errors = nerrors;
+    } else {
+        c->boards = nboards;
+        c->ops = nops;
+        c->strs = nstrs;
+    }
+}
+
+static void *_epd_worker(void *arg) {
+    _epd_load_t *load = (_epd_load_t *) arg;
+    for (;;) {
+        const size_t chunk = mapfile_pool_next(&load->pool);
+        if (chunk == load->pool.nchunks) {
+            break;
+        }
+        _epd_chunk(load, chunk);
+    }
+    return NULL;
+}
+
+epd_t *epd_load_buf(const char *text, size_t len, int threads) {
+    _epd_load_t load;
+    memset(&load, 0, sizeof load);
+    load.text = text;
+    load.len = len;
+    load.pool.nchunks = (len + EPD_CHUNK - 1) / EPD_CHUNK;
+    load.chunks = (_epd_chunk_t *) _epd_alloc(load.pool.nchunks * sizeof(_epd_chunk_t));
+    epd_t *ret = (epd_t *) alloc_calloc(1, sizeof(epd_t));
+    if (!ret) {
+        fprintf(stderr, "calloc error in epd\n");
+        exit(EXIT_FAILURE);
+    }
+    load.epd = ret;
+
+    mapfile_pool_run(&load.pool, threads, _epd_worker, &load);
+
+    // the counts of the chunks become their offsets into the arrays
+    size_t nboards = 0, nops = 0, nstrs = 0;
+    for (size_t i = 0; i < load.pool.nchunks; ++i) {
+        _epd_chunk_t *chunk = &load.chunks[i];
+        const _epd_chunk_t counts = *chunk;
+        chunk->boards = nboards;
+        chunk->ops = nops;
+        chunk->strs = nstrs;
+        chunk->capops = counts.ops;
+        chunk->capstrs = counts.strs;
+        nboards += counts.boards;
+        nops += counts.ops;
+        nstrs += counts.strs;
+    }
+    ret->boards = (board_t *) _epd_alloc(nboards * sizeof(board_t));
+    ret->opsidx = (size_t *) _epd_alloc((nboards + 1) * sizeof(size_t));
+    ret->ops = (epd_op_t *) _epd_alloc(nops * sizeof(epd_op_t));
+    ret->strs = (char *) _epd_alloc(nstrs);
+    load.pass = 1;
+    mapfile_pool_run(&load.pool, threads, _epd_worker, &load);
+
+    // the lines that were not positions leave gaps at the ends of their chunks, closed here
+    for (size_t i = 0; i < load.pool.nchunks; ++i) {
+        const _epd_chunk_t *chunk = &load.chunks[i];
+        if (ret->len != chunk->boards || ret->nops != chunk->ops) {
+            memmove(&ret->boards[ret->len], &ret->boards[chunk->boards], chunk->nboards * sizeof(board_t));
+            for (size_t j = 0; j < chunk->nboards; ++j) {
+                ret->opsidx[ret->len + j] = ret->opsidx[chunk->boards + j] - chunk->ops + ret->nops;
+            }
+            memmove(&ret->ops[ret->nops], &ret->ops[chunk->ops], chunk->nops * sizeof(epd_op_t));
+        }
+        ret->len += chunk->nboards;
+        ret->nops += chunk->nops;
+        ret->errors += chunk->errors;
+    }
+    ret->opsidx[ret->len] = ret->nops;
+    alloc_free(load.chunks);
+    return ret;
+}
+
+epd_t *epd_load(const char *path, int threads) {
+    mapfile_t file;
+    if (mapfile_open(path, MAPFILE_SEQUENTIAL, &file)) {  // each chunk is read through once per pass
+        return NULL;
+    }
+    epd_t *ret = epd_load_buf(file.mem, file.len, threads);
+    mapfile_close(&file);
+    return ret;
+}
+
+void epd_free(epd_t *epd) {
+    if (epd) {
+        alloc_free(epd->boards);
+        alloc_free(epd->opsidx);
+        alloc_free(epd->ops);
+        alloc_free(epd->strs);
+        alloc_free(epd);
+    }
+}
+
+const char *epd_op(const epd_t *epd, size_t i, const char *name) {
+    for (size_t j = epd->opsidx[i]; j < epd->opsidx[i + 1]; ++j) {
+        if (!strcmp(epd->ops[j].name, name)) {
+            return epd->ops[j].value;
+        }
+    }
+    return NULL;
+}
@@ -0,0 +1,299 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "farm.h"
+#include "pgn.h"
+#include "train.h"
+#include "alloc.h"
+#include "eval.h"
+#include "search.h"
+#include "tt.h"
+#include "epd.h"
+
+#ifndef CHESSLIB_QWORD_MOVE
+#error "farm requires CHESSLIB_QWORD_MOVE"
+#endif
+
+// longest notation of a move and its separator, and of a result and reason
+#define FARM_MOVE_CHARS 6
+#define FARM_HEAD_CHARS 32
+#define FARM_PGN_HEAD_CHARS 256  // tags, without the position of the FEN tag
+
+typedef struct {
+    const farm_config_t *config;
+    board_t start;
+    size_t fenlen;  // length of the position read from (config->fen)
+    FILE *out;
+    train_writer_t *train;  // NULL if no training records are written
+    uint64_t next;  // next game to play
+    int error;
+    pthread_mutex_t lock;  // guards (out), (train), (error) and (stats)
+    farm_stats_t stats;
+} _farm_t;
+
+static const char *_results[4] = {"1/2-1/2", "1-0", "0-1", "*"};
+static const char *_reasons[FARM_NREASONS] = {"mate", "stalemate", "material", "repetition", "fifty", "plies"};
+
+const char *farm_result_str(int result) {
+    return result >= 0 && result < 4 ? _results[result] : "?";
+}
+
+const char *farm_reason_str(int reason) {
+    return reason >= 0 && reason < FARM_NREASONS ? _reasons[reason] : "?";
+}
+
+static inline uint64_t _farm_rand(uint64_t *state) {  // splitmix64
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// uniform in [0, 1)
+static inline double _farm_uniform(uint64_t *state) {
+    return (_farm_rand(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// writes a game in PGN, with its tags and movetext
+static char *_farm_write_pgn(const _farm_t *farm, uint64_t game, const move_t *moves, int plies, int result,
+                             int reason, char *buf) {
+    buf += sprintf(buf, "[Event \"farm\"]\n[Round \"%llu\"]\n[White \"chesslib\"]\n[Black \"chesslib\"]\n"
+                   "[Result \"%s\"]\n", (unsigned long long) game + 1, _results[result]);
+    if (farm->config->fen) {
+        buf += sprintf(buf, "[FEN \"%.*s\"]\n[SetUp \"1\"]\n", (int) farm->fenlen, farm->config->fen);
+    }
+    *buf++ = '\n';
+    buf += pgn_write_moves(&farm->start, moves, plies, buf);
+    buf += sprintf(buf, "%s{%s} %s\n\n", plies ? " " : "", _reasons[reason], _results[result]);
+    return buf;
+}
+
+// softmax over the static evaluations after the moves, for the player making them
+static move_t _farm_weighted(const board_t *board, const move_t *moves, size_t len, double temperature,
+                             uint64_t *rnd) {
+    int scores[BOARD_MOVES_MAX];
+    int best = -SEARCH_INF;
+    for (size_t i = 0; i < len; ++i) {
+        board_t child = *board;
+        board_apply_move(&child, moves[i]);
+        scores[i] = -eval_board(&child);
+        best = scores[i] > best ? scores[i] : best;
+    }
+    double weights[BOARD_MOVES_MAX];
+    double sum = 0;
+    for (size_t i = 0; i < len; ++i) {
+        weights[i] = exp((scores[i] - best) / temperature);
+        sum += weights[i];
+    }
+    double x = _farm_uniform(rnd) * sum;
+    for (size_t i = 0; i < len; ++i) {
+        x -= weights[i];
+        if (x < 0) {
+            return moves[i];
+        }
+    }
+    return moves[len - 1];
+}
+
+// plays a game into (moves), (scores) of the positions before them and (hashes), and returns its number of
+// plies; stores its result and reason
+static int _farm_play(const _farm_t *farm, uint64_t game, tt_t *tt, move_t *moves, int *scores, uint64_t *hashes,
+                      int *result, int *reason) {
+    const farm_config_t *config = farm->config;
+    const int maxplies = config->maxplies > 0 ? config->maxplies : FARM_MAX_PLIES;
+    const double temperature = config->temperature > 0 ? config->temperature : FARM_TEMPERATURE;
+    uint64_t rnd = config->seed ^ (game * 0xd1342543de82ef95ULL);
+    const int depth = config->depth || config->nodes ? config->depth : FARM_DEPTH;
+    search_limits_t limits = {depth, config->nodes, 0, tt, 1, NULL, 0};
+    if (tt) {
+        tt_clear(tt);
+    }
+
+    board_t board = farm->start;
+    int halfmoves = 0;  // plies since the last capture or pawn move
+    hashes[0] = board.hash;
+    for (int ply = 0;; ++ply) {
+        move_t buf[BOARD_MOVES_MAX];
+        const size_t len = board_get_moves_buf(&board, buf);
+        if (!len) {
+            const int mate = board_in_check(&board);
+            *result = !mate ? RESULT_DRAW : FLAGS_WPLAYER(board.flags) ? RESULT_BLACK_WINS : RESULT_WHITE_WINS;
+            *reason = mate ? FARM_MATE : FARM_STALEMATE;
+            return ply;
+        }
+        *result = RESULT_DRAW;
+        if (board_count_pieces(&board) <= 4 && board_is_stalemate(&board)) {
+            *reason = FARM_MATERIAL;
+            return ply;
+        }
+        if (halfmoves >= 100) {
+            *reason = FARM_FIFTY;
+            return ply;
+        }
+        int repeats = 0;
+        for (int i = ply - 4; i >= ply - halfmoves; i -= 2) {
+            repeats += hashes[i] == board.hash;
+        }
+        if (repeats >= 2) {
+            *reason = FARM_REPETITION;
+            return ply;
+        }
+        if (ply >= maxplies) {
+            *result = RESULT_UNFINISHED;
+            *reason = FARM_PLIES;
+            return ply;
+        }
+
+        move_t move = 0;
+        scores[ply] = TRAIN_NO_SCORE;
+        if (ply < config->openingplies || config->policy == FARM_RANDOM) {
+            move = buf[_farm_rand(&rnd) % len];
+        } else if (config->policy == FARM_WEIGHTED) {
+            move = _farm_weighted(&board, buf, len, temperature, &rnd);
+        } else {
+            search_result_t found;
+            search(&board, &limits, &found);
+            move = found.best;
+            scores[ply] = found.score;
+        }
+        halfmoves = MVKILLPC(move) != NOPC || MVFROMPC(move) == WPAWN || MVFROMPC(move) == BPAWN
+                  ? 0 : halfmoves + 1;
+        board_apply_move(&board, move);
+        moves[ply] = move;
+        hashes[ply + 1] = board.hash;
+    }
+}
+
+static void *_farm_worker(void *arg) {
+    _farm_t *farm = (_farm_t *) arg;
+    const farm_config_t *config = farm->config;
+    const int maxplies = config->maxplies > 0 ? config->maxplies : FARM_MAX_PLIES;
+    move_t *moves = (move_t *) alloc_malloc(maxplies * sizeof(move_t));
+    int *scores = (int *) alloc_malloc(maxplies * sizeof(int));
+    uint64_t *hashes = (uint64_t *) alloc_malloc((maxplies + 1) * sizeof(uint64_t));
+    const size_t linecap = config->pgn
+                           ? FARM_PGN_HEAD_CHARS + farm->fenlen + maxplies * PGN_MOVE_CHARS + FARM_HEAD_CHARS
+                           : FARM_HEAD_CHARS + (size_t) maxplies * FARM_MOVE_CHARS + 2;
+    char *line = (char *) alloc_malloc(linecap);
+    if (!moves || !scores || !hashes || !line) {
+        fprintf(stderr, "malloc error in _farm_worker\n");
+        exit(EXIT_FAILURE);
+    }
+    tt_t *tt = config->policy == FARM_SEARCH && config->ttmb ? tt_make(config->ttmb, 0) : NULL;
+
+    farm_stats_t stats;
+    memset(&stats, 0, sizeof stats);
+    for (;;) {
+        const uint64_t game = __atomic_fetch_add(&farm->next, 1, __ATOMIC_RELAXED);
+        if (game >= config->games) {
+            break;
+        }
+        int result, reason;
+        const int plies = _farm_play(farm, game, tt, moves, scores, hashes, &result, &reason);
+        char *p = line;
+        if (config->pgn) {
+            p = _farm_write_pgn(farm, game, moves, plies, result, reason, p);
+        } else {
+            p += sprintf(line, "%s %s", _results[result], _reasons[reason]);
+            for (int i = 0; i < plies; ++i) {
+                *p++ = ' ';
+                p += move_uci(moves[i], p);
+            }
+            *p++ = '\n';
+        }
+        ++stats.games;
+        stats.plies += plies;
+        ++stats.results[result];
+        ++stats.reasons[reason];
+
+        pthread_mutex_lock(&farm->lock);
+        if (fwrite(line, 1, p - line, farm->out) != (size_t) (p - line)) {
+            farm->error = 1;
+        }
+        if (farm->train && train_write_game(farm->train, &farm->start, moves, scores, plies, result, game)) {
+            farm->error = 1;
+        }
+        pthread_mutex_unlock(&farm->lock);
+    }
+
+    pthread_mutex_lock(&farm->lock);
+    farm->stats.games += stats.games;
+    farm->stats.plies += stats.plies;
+    for (int i = 0; i < 4; ++i) {
+        farm->stats.results[i] += stats.results[i];
+    }
+    for (int i = 0; i < FARM_NREASONS; ++i) {
+        farm->stats.reasons[i] += stats.reasons[i];
+    }
+    pthread_mutex_unlock(&farm->lock);
+    if (tt) {
+        tt_free(tt);
+    }
+    alloc_free(moves);
+    alloc_free(scores);
+    alloc_free(hashes);
+    alloc_free(line);
+    return NULL;
+}
+
+int farm_run(const farm_config_t *config, const char *path, farm_stats_t *stats) {
+    _farm_t farm;
+    memset(&farm, 0, sizeof farm);
+    farm.config = config;
+    const char *fen = config->fen ? config->fen : STARTING_BOARD;
+    farm.fenlen = epd_parse(fen, strlen(fen), &farm.start);
+    if (!farm.fenlen) {
+        return 1;
+    }
+    farm.out = fopen(path, "w");
+    if (!farm.out) {
+        return 1;
+    }
+    if (config->train) {
+        farm.train = train_create(config->train);
+        if (!farm.train) {
+            fclose(farm.out);
+            return 1;
+        }
+    }
+    pthread_mutex_init(&farm.lock, NULL);
+
+    long nthreads = config->threads > 0 ? config->threads : sysconf(_SC_NPROCESSORS_ONLN);
+    if (nthreads < 1) {
+        nthreads = 1;
+    }
+    if ((uint64_t) nthreads > config->games) {
+        nthreads = config->games ? config->games : 1;
+    }
+    pthread_t *threads = (pthread_t *) alloc_malloc(nthreads * sizeof(pthread_t));
+    if (!threads) {
+        fprintf(stderr, "malloc error in farm_run\n");
+        exit(EXIT_FAILURE);
+    }
+    for (long i = 0; i < nthreads; ++i) {
+        if (pthread_create(&threads[i], NULL, _farm_worker, &farm)) {
+            fprintf(stderr, "pthread_create error in farm_run\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    for (long i = 0; i < nthreads; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+    alloc_free(threads);
+    pthread_mutex_destroy(&farm.lock);
+
+    if (fclose(farm.out)) {
+        farm.error = 1;
+    }
+    if (farm.train && train_close(farm.train)) {
+        farm.error = 1;
+    }
+    if (stats) {
+        *stats = farm.stats;
+    }
+    return farm.error;
+}
@@ -0,0 +1,106 @@
+#define _DEFAULT_SOURCE  // madvise
+#include <stdlib.h>
+#include <stdio.h>
+#include <pthread.h>
+#include <unistd.h>
+#ifdef __unix__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "mapfile.h"
+#include "alloc.h"
+
+int mapfile_open(const char *path, int advice, mapfile_t *file) {
+#ifdef __unix__
+    const int fd = open(path, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st)) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        return 1;
+    }
+    const size_t len = st.st_size;
+    void *mem = NULL;
+    if (len) {
+        mem = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mem == MAP_FAILED) {
+            close(fd);
+            return 1;
+        }
+        if (advice != MAPFILE_NORMAL) {
+            madvise(mem, len, advice == MAPFILE_SEQUENTIAL ? MADV_SEQUENTIAL : MADV_RANDOM);
+        }
+    }
+    close(fd);  // the mapping holds its own reference
+#else
+    (void) advice;
+    FILE *stream = fopen(path, "rb");
+    if (!stream || fseek(stream, 0, SEEK_END) || ftell(stream) < 0) {
+        if (stream) {
+            fclose(stream);
+        }
+        return 1;
+    }
+    const size_t len = ftell(stream);
+    rewind(stream);
+    char *mem = NULL;
+    if (len) {
+        mem = (char *) alloc_malloc(len);
+        if (!mem) {
+            fprintf(stderr, "malloc error in mapfile_open\n");
+            exit(EXIT_FAILURE);
+        }
+        if (fread(mem, 1, len, stream) != len) {
+            alloc_free(mem);
+            fclose(stream);
+            return 1;
+        }
+    }
+    fclose(stream);
+#endif
+    file->mem = (const char *) mem;
+    file->len = len;
+    return 0;
+}
+
+void mapfile_close(mapfile_t *file) {
+#ifdef __unix__
+    if (file->len) {
+        munmap((void *) file->mem, file->len);
+    }
+#else
+    alloc_free((void *) file->mem);
+#endif
+    file->mem = NULL;
+    file->len = 0;
+}
+
+void mapfile_pool_run(mapfile_pool_t *pool, int threads, void *(*worker)(void *), void *arg) {
+    pool->next = 0;
+    long nthreads = threads > 0 ? threads : sysconf(_SC_NPROCESSORS_ONLN);
+    if ((size_t) nthreads > pool->nchunks) {
+        nthreads = pool->nchunks;
+    }
+    if (nthreads <= 1) {
+        worker(arg);
+        return;
+    }
+    pthread_t *workers = (pthread_t *) alloc_malloc(nthreads * sizeof(pthread_t));
+    if (!workers) {
+        fprintf(stderr, "malloc error in mapfile_pool_run\n");
+        exit(EXIT_FAILURE);
+    }
+    for (long i = 0; i < nthreads; ++i) {
+        if (pthread_create(&workers[i], NULL, worker, arg)) {
+            fprintf(stderr, "pthread_create error in mapfile_pool_run\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    for (long i = 0; i < nthreads; ++i) {
+        pthread_join(workers[i], NULL);
+    }
+    alloc_free(workers);
+}
@@ -0,0 +1,291 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "mcts.h"
+#include "alloc.h"
+
+#ifndef CHESSLIB_QWORD_MOVE
+#error "mcts requires CHESSLIB_QWORD_MOVE"
+#endif
+
+// node states
+#define MCTS_NEW 0  // not expanded
+#define MCTS_PENDING 1  // children allocated, awaiting evaluation in the batch under way
+#define MCTS_EXPANDED 2
+#define MCTS_MATE 3  // no legal moves, in check
+#define MCTS_DRAW 4  // stalemate or insufficient material
+
+static void *_mcts_alloc(size_t n, size_t size) {
+    void *ret = alloc_malloc(n * size);
+    if (!ret) {
+        fprintf(stderr, "malloc error in mcts_make\n");
+        exit(EXIT_FAILURE);
+    }
+    return ret;
+}
+
+mcts_t *mcts_make(const board_t *board, const mcts_config_t *config) {
+    mcts_t *ret = (mcts_t *) alloc_calloc(1, sizeof(mcts_t));
+    if (!ret) {
+        fprintf(stderr, "calloc error in mcts_make\n");
+        exit(EXIT_FAILURE);
+    }
+    if (config) {
+        ret->config = *config;
+    }
+    if (ret->config.cpuct <= 0) {
+        ret->config.cpuct = MCTS_CPUCT;
+    }
+    if (ret->config.batch <= 0) {
+        ret->config.batch = MCTS_BATCH;
+    }
+    if (ret->config.batch > MCTS_BATCH_MAX) {
+        ret->config.batch = MCTS_BATCH_MAX;
+    }
+    if (ret->config.maxnodes < 1 + BOARD_MOVES_MAX) {
+        ret->config.maxnodes = ret->config.maxnodes ? 1 + BOARD_MOVES_MAX : MCTS_NODES;
+    }
+    const size_t batch = ret->config.batch;
+    ret->nodes = (mcts_node_t *) _mcts_alloc(ret->config.maxnodes, sizeof(mcts_node_t));
+    ret->spare = (mcts_node_t *) _mcts_alloc(ret->config.maxnodes, sizeof(mcts_node_t));
+    ret->boards = (board_t *) _mcts_alloc(batch, sizeof(board_t));
+    ret->moves = (move_t *) _mcts_alloc(batch * BOARD_MOVES_MAX, sizeof(move_t));
+    ret->offsets = (uint32_t *) _mcts_alloc(batch + 1, sizeof(uint32_t));
+    ret->priors = (float *) _mcts_alloc(batch * BOARD_MOVES_MAX, sizeof(float));
+    ret->values = (float *) _mcts_alloc(batch, sizeof(float));
+    ret->leaves = (uint32_t *) _mcts_alloc(batch, sizeof(uint32_t));
+    mcts_reset(ret, board);
+    return ret;
+}
+
+void mcts_free(mcts_t *tree) {
+    alloc_free(tree->nodes);
+    alloc_free(tree->spare);
+    alloc_free(tree->boards);
+    alloc_free(tree->moves);
+    alloc_free(tree->offsets);
+    alloc_free(tree->priors);
+    alloc_free(tree->values);
+    alloc_free(tree->leaves);
+    alloc_free(tree);
+}
+
+void mcts_reset(mcts_t *tree, const board_t *board) {
+    tree->root = *board;
+    memset(&tree->nodes[0], 0, sizeof(mcts_node_t));
+    tree->len = 1;
+}
+
+// returns the child of (node) with the highest upper confidence bound, counting pending playouts as losses
+static uint32_t _mcts_select(const mcts_t *tree, const mcts_node_t *node) {
+    const mcts_node_t *children = &tree->nodes[node->children];
+    const float n = (float) (node->visits + node->vloss);
+    const float explore = tree->config.cpuct * sqrtf(n);
+    // the value of the node for its player to move, less the first play urgency, for unvisited children
+    const float fpu = (n > 0 ? -(node->value - node->vloss) / n : 0) - tree->config.fpu;
+    uint32_t best = 0;
+    float bestscore = -INFINITY;
+    for (uint32_t i = 0; i < node->nchildren; ++i) {
+        const mcts_node_t *child = &children[i];
+        const uint32_t visits = child->visits + child->vloss;
+        const float q = visits ? (child->value - child->vloss) / visits : fpu;
+        const float score = q + explore * child->prior / (1 + visits);
+        if (score > bestscore) {
+            bestscore = score;
+            best = i;
+        }
+    }
+    return node->children + best;
+}
+
+// adds (value), for the player to move at (leaf), to the nodes from (leaf) to the root, and removes the virtual
+// loss of the playout if (pending)
+static void _mcts_backup(mcts_t *tree, uint32_t leaf, float value, int pending) {
+    value = -value;
+    for (uint32_t i = leaf;; i = tree->nodes[i].parent, value = -value) {
+        mcts_node_t *node = &tree->nodes[i];
+        ++node->visits;
+        node->value += value;
+        node->vloss -= pending;
+        if (!i) {
+            break;
+        }
+    }
+}
+
+static void _mcts_unselect(mcts_t *tree, uint32_t leaf) {
+    for (uint32_t i = leaf;; i = tree->nodes[i].parent) {
+        --tree->nodes[i].vloss;
+        if (!i) {
+            break;
+        }
+    }
+}
+
+// evaluates the batch of (n) leaves, and expands them
+static void _mcts_flush(mcts_t *tree, size_t n, mcts_eval_t eval, void *ctx) {
+    if (!n) {
+        return;
+    }
+    eval(ctx, n, tree->boards, tree->moves, tree->offsets, tree->priors, tree->values);
+    for (size_t i = 0; i < n; ++i) {
+        mcts_node_t *leaf = &tree->nodes[tree->leaves[i]];
+        const float *priors = &tree->priors[tree->offsets[i]];
+        float sum = 0;
+        for (uint32_t j = 0; j < leaf->nchildren; ++j) {
+            if (priors[j] > 0 && isfinite(priors[j])) {
+                sum += priors[j];
+            }
+        }
+        for (uint32_t j = 0; j < leaf->nchildren; ++j) {
+            mcts_node_t *child = &tree->nodes[leaf->children + j];
+            child->prior = sum > 0 ? (priors[j] > 0 && isfinite(priors[j]) ? priors[j] / sum : 0)
+                                   : 1.0f / leaf->nchildren;
+        }
+        leaf->state = MCTS_EXPANDED;
+        float value = tree->values[i];
+        value = !isfinite(value) ? 0 : value > 1 ? 1 : value < -1 ? -1 : value;
+        _mcts_backup(tree, tree->leaves[i], value, 1);
+    }
+}
+
+uint64_t mcts_search(mcts_t *tree, uint64_t playouts, mcts_eval_t eval, void *ctx) {
+    const size_t batch = tree->config.batch;
+    uint64_t done = 0;
+    int full = 0;
+    while (done < playouts && !full) {
+        size_t n = 0;
+        size_t collisions = 0;
+        tree->offsets[0] = 0;
+        while (n < batch && done + n < playouts && collisions < batch) {
+            // select a leaf, with a virtual loss on its path
+            uint32_t i = 0;
+            board_t board = tree->root;
+            ++tree->nodes[0].vloss;
+            while (tree->nodes[i].state == MCTS_EXPANDED) {
+                i = _mcts_select(tree, &tree->nodes[i]);
+                ++tree->nodes[i].vloss;
+                board_apply_move(&board, tree->nodes[i].move);
+            }
+            mcts_node_t *leaf = &tree->nodes[i];
+            if (leaf->state == MCTS_PENDING) {  // already in the batch
+                _mcts_unselect(tree, i);
+                ++collisions;
+                continue;
+            }
+            if (leaf->state == MCTS_NEW) {
+                move_t *moves = &tree->moves[tree->offsets[n]];
+                const size_t len = board_get_moves_buf(&board, moves);
+                if (!len) {
+                    leaf->state = board_in_check(&board) ? MCTS_MATE : MCTS_DRAW;
+                } else if (board_count_pieces(&board) <= 4 && board_is_stalemate(&board)) {
+                    leaf->state = MCTS_DRAW;
+                } else if (tree->len + len > tree->config.maxnodes) {
+                    _mcts_unselect(tree, i);
+                    full = 1;
+                    break;
+                } else {
+                    leaf->children = tree->len;
+                    leaf->nchildren = len;
+                    leaf->state = MCTS_PENDING;
+                    for (size_t j = 0; j < len; ++j) {
+                        mcts_node_t *child = &tree->nodes[tree->len + j];
+                        memset(child, 0, sizeof(mcts_node_t));
+                        child->move = moves[j];
+                        child->parent = i;
+                    }
+                    tree->len += len;
+                    tree->boards[n] = board;
+                    tree->leaves[n] = i;
+                    tree->offsets[n + 1] = tree->offsets[n] + len;
+                    ++n;
+                    continue;
+                }
+            }
+            // a terminal leaf, scored without evaluation
+            _mcts_backup(tree, i, leaf->state == MCTS_MATE ? -1 : 0, 1);
+            ++done;
+            if (!i) {
+                return 0;  // the root has no legal moves
+            }
+        }
+        _mcts_flush(tree, n, eval, ctx);
+        done += n;
+    }
+    return done;
+}
+
+int mcts_advance(mcts_t *tree, move_t move) {
+    const mcts_node_t *root = &tree->nodes[0];
+    uint32_t child = 0;
+    for (uint32_t i = 0; root->state == MCTS_EXPANDED && i < root->nchildren; ++i) {
+        if (tree->nodes[root->children + i].move == move) {
+            child = root->children + i;
+            break;
+        }
+    }
+    board_t board = tree->root;
+    board_apply_move(&board, move);
+    if (!child) {
+        mcts_reset(tree, &board);
+        return 1;
+    }
+    tree->root = board;
+
+    // copy the subtree breadth first, keeping the children of each node together
+    mcts_node_t *spare = tree->spare;
+    spare[0] = tree->nodes[child];
+    spare[0].parent = 0;
+    size_t len = 1;
+    for (size_t i = 0; i < len; ++i) {
+        mcts_node_t *node = &spare[i];
+        if (node->state != MCTS_EXPANDED) {
+            node->nchildren = 0;
+            continue;
+        }
+        memcpy(&spare[len], &tree->nodes[node->children], node->nchildren * sizeof(mcts_node_t));
+        for (size_t j = 0; j < node->nchildren; ++j) {
+            spare[len + j].parent = i;
+        }
+        node->children = len;
+        len += node->nchildren;
+    }
+    tree->spare = tree->nodes;
+    tree->nodes = spare;
+    tree->len = len;
+    return 0;
+}
+
+size_t mcts_policy(const mcts_t *tree, move_t *moves, uint32_t *visits) {
+    const mcts_node_t *root = &tree->nodes[0];
+    if (root->state != MCTS_EXPANDED) {
+        return 0;
+    }
+    for (uint32_t i = 0; i < root->nchildren; ++i) {
+        moves[i] = tree->nodes[root->children + i].move;
+        visits[i] = tree->nodes[root->children + i].visits;
+    }
+    return root->nchildren;
+}
+
+move_t mcts_best(const mcts_t *tree) {
+    const mcts_node_t *root = &tree->nodes[0];
+    if (root->state != MCTS_EXPANDED) {
+        return 0;
+    }
+    const mcts_node_t *best = &tree->nodes[root->children];
+    for (uint32_t i = 1; i < root->nchildren; ++i) {
+        const mcts_node_t *child = &tree->nodes[root->children + i];
+        if (child->visits > best->visits || (child->visits == best->visits && child->prior > best->prior)) {
+            best = child;
+        }
+    }
+    return best->move;
+}
+
+float mcts_value(const mcts_t *tree) {
+    const mcts_node_t *root = &tree->nodes[0];
+    return root->visits ? -root->value / root->visits : 0;
+}
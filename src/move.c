@@ -5,6 +5,7 @@
 #include "move.h"
 #include "algnot.h"
 #include "parseutils.h"
+#include "alloc.h"
 
 #ifdef CHESSLIB_QWORD_MOVE
 move_t move_make(pos_t frompos, pos_t topos, pos_t killpos, pc_t frompc, pc_t topc, pc_t killpc) {
@@ -12,7 +13,7 @@ move_t move_make(pos_t frompos, pos_t topos, pos_t killpos, pc_t frompc, pc_t to
 }
 #else
 move_t *move_make(pos_t frompos, pos_t topos, pos_t killpos, pc_t frompc, pc_t topc, pc_t killpc) {
-    move_t *move = (move_t *) malloc(sizeof(move_t));
+    move_t *move = (move_t *) alloc_malloc(sizeof(move_t));
     if (!move) {
         fprintf(stderr, "malloc error in move_make\n");
         exit(EXIT_FAILURE);
@@ -38,7 +39,7 @@ move_t move_make_algnot(const char *algnot) {
 }
 #else
 move_t *move_make_algnot(const char *algnot) {
-    move_t *ret = (move_t *) malloc(sizeof(move_t));
+    move_t *ret = (move_t *) alloc_malloc(sizeof(move_t));
     if (!ret) {
         fprintf(stderr, "malloc error in move_make_algnot\n");
         exit(EXIT_FAILURE);
@@ -53,7 +54,7 @@ move_t *move_make_algnot(const char *algnot) {
 
 #ifndef CHESSLIB_QWORD_MOVE
 move_t *move_cpy(move_t *other) {
-    move_t *cpy = (move_t *) malloc(sizeof(move_t));
+    move_t *cpy = (move_t *) alloc_malloc(sizeof(move_t));
     if (!cpy) {
         fprintf(stderr, "malloc error in move_cpy\n");
         exit(EXIT_FAILURE);
@@ -65,7 +66,7 @@ move_t *move_cpy(move_t *other) {
 
 #ifndef CHESSLIB_QWORD_MOVE
 void move_free(move_t *move) {
-    free(move);
+    alloc_free(move);
 }
 #endif
 
@@ -342,3 +343,29 @@ char *move_algnot(const move_t *move) {
     }
     return ret;
 }
+
+#ifdef CHESSLIB_QWORD_MOVE
+size_t move_uci(const move_t move, char *buf) {
+    const pos_t from = MVFROMPOS(move);
+    const pos_t to = MVTOPOS(move);
+    const pc_t frompc = MVFROMPC(move);
+    const pc_t topc = MVTOPC(move);
+#else
+size_t move_uci(const move_t *move, char *buf) {
+    const pos_t from = move->frompos;
+    const pos_t to = move->topos;
+    const pc_t frompc = move->frompc;
+    const pc_t topc = move->topc;
+#endif
+    static const char promos[] = "pnbrqkpnbrqk";
+    size_t len = 0;
+    buf[len++] = 'a' + from % 8;
+    buf[len++] = '1' + from / 8;
+    buf[len++] = 'a' + to % 8;
+    buf[len++] = '1' + to / 8;
+    if (topc != frompc) {
+        buf[len++] = promos[topc];
+    }
+    buf[len] = '\0';
+    return len;
+}
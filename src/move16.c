@@ -0,0 +1,133 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "move16.h"
+#include "alloc.h"
+
+#ifndef CHESSLIB_QWORD_MOVE
+#error "move16 requires CHESSLIB_QWORD_MOVE"
+#endif
+
+#define MOVE16_HIST_CAP 128
+
+static inline int _move16_pc(const board_t *board, int pos) {
+    return (board->ranks[pos / 8] >> ((pos % 8) << 2)) & 0xf;
+}
+
+move_t move16_to_move(const board_t *board, move16_t move) {
+    if (!move) {
+        return 0;
+    }
+    const pos_t frompos = MV16FROMPOS(move), topos = MV16TOPOS(move);
+    const int black = FLAGS_BPLAYER(board->flags);
+    const pc_t frompc = _move16_pc(board, frompos);
+    const pc_t killpc = _move16_pc(board, topos);
+    if (frompc == NOPC || (frompc >= BPAWN) != black || (killpc != NOPC && (killpc >= BPAWN) == black)) {
+        return 0;
+    }
+    const pos_t killpos = killpc != NOPC ? topos : NOPOS;
+    const int lastrank = black ? topos < 8 : topos >= 56;
+    switch (MV16KIND(move)) {
+    case MOVE16_NORMAL:
+        if (frompc % BPAWN == WPAWN && lastrank) {
+            return 0;
+        }
+        return MVMAKE(frompos, topos, killpos, frompc, frompc, killpc);
+    case MOVE16_PROMO:
+        if (frompc % BPAWN != WPAWN || !lastrank) {
+            return 0;
+        }
+        return MVMAKE(frompos, topos, killpos, frompc, MV16PROMO(move) + (black ? BPAWN : 0), killpc);
+    case MOVE16_EP:
+        if (frompc % BPAWN != WPAWN || topos != FLAGS_EP(board->flags) || killpc != NOPC) {
+            return 0;
+        }
+        return MVMAKE(frompos, topos, black ? topos + 8 : topos - 8, frompc, frompc, black ? WPAWN : BPAWN);
+    default:  // MOVE16_CASTLE
+        if (frompc % BPAWN != WKING || killpc != NOPC || (frompos - topos != 2 && topos - frompos != 2)) {
+            return 0;
+        }
+        return MVMAKE(frompos, topos, NOPOS, frompc, frompc, NOPC);
+    }
+}
+
+void move16_pack(const move_t *moves, size_t len, move16_t *dest) {
+    for (size_t i = 0; i < len; ++i) {
+        dest[i] = move16_make(moves[i]);
+    }
+}
+
+size_t move16_unpack(const board_t *board, const move16_t *moves, size_t len, move_t *dest) {
+    board_t cur = *board;
+    for (size_t i = 0; i < len; ++i) {
+        if (!(dest[i] = move16_to_move(&cur, moves[i]))) {
+            return i;
+        }
+        board_apply_move(&cur, dest[i]);
+    }
+    return len;
+}
+
+size_t move16_get_moves_buf(const board_t *board, move16_t *dest) {
+    move_t moves[BOARD_MOVES_MAX];
+    const size_t len = board_get_moves_buf(board, moves);
+    move16_pack(moves, len, dest);
+    return len;
+}
+
+move16_hist_t *move16_hist_make(const board_t *start) {
+    move16_hist_t *ret = (move16_hist_t *) alloc_malloc(sizeof(move16_hist_t));
+    move16_t *moves = (move16_t *) alloc_malloc(MOVE16_HIST_CAP * sizeof(move16_t));
+    if (!ret || !moves) {
+        fprintf(stderr, "malloc error in move16\n");
+        exit(EXIT_FAILURE);
+    }
+    ret->start = *start;
+    ret->board = *start;
+    ret->moves = moves;
+    ret->len = 0;
+    ret->cap = MOVE16_HIST_CAP;
+    return ret;
+}
+
+void move16_hist_free(move16_hist_t *hist) {
+    if (hist) {
+        alloc_free(hist->moves);
+        alloc_free(hist);
+    }
+}
+
+void move16_hist_push(move16_hist_t *hist, move_t move) {
+    if (hist->len == hist->cap) {
+        move16_t *old = hist->moves;
+        hist->cap *= 2;
+        hist->moves = (move16_t *) alloc_malloc(hist->cap * sizeof(move16_t));
+        if (!hist->moves) {
+            fprintf(stderr, "malloc error in move16\n");
+            exit(EXIT_FAILURE);
+        }
+        memcpy(hist->moves, old, hist->len * sizeof(move16_t));
+        alloc_free(old);
+    }
+    hist->moves[hist->len++] = move16_make(move);
+    board_apply_move(&hist->board, move);
+}
+
+move_t move16_hist_pop(move16_hist_t *hist) {
+    if (!hist->len) {
+        return 0;
+    }
+    // boards are not undone: replay the game up to the move taken back
+    board_t board = hist->start;
+    for (size_t i = 0; i + 1 < hist->len; ++i) {
+        board_apply_move(&board, move16_to_move(&board, hist->moves[i]));
+    }
+    const move_t ret = move16_to_move(&board, hist->moves[--hist->len]);
+    hist->board = board;
+    return ret;
+}
+
+size_t move16_hist_moves(const move16_hist_t *hist, move_t *dest) {
+    return move16_unpack(&hist->start, hist->moves, hist->len, dest);
+}
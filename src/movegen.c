@@ -4,6 +4,8 @@
 #include "board.h"
 #include "move.h"
 #include "arraylist.h"
+#include "stats.h"
+#include "trace.h"
 
 #define UP (1)
 #define RT (1)
@@ -70,12 +72,34 @@
         blocker; \
     } \
 
-void _board_generatePawnMoves(const board_t *board, alst_t *dest, const int rk, const int offs);
-void _board_generateKnightMoves(const board_t *board, alst_t *dest, const int rk, const int offs);
-void _board_generateBishopMoves(const board_t *board, alst_t *dest, const int rk, const int offs);
-void _board_generateRookMoves(const board_t *board, alst_t *dest, const int rk, const int offs);
-void _board_generateQueenMoves(const board_t *board, alst_t *dest, const int rk, const int offs);
-void _board_generateKingMoves(const board_t *board, alst_t *dest, const int rk, const int offs);
+/**
+* A fixed-capacity (BOARD_MOVES_MAX) buffer of (len) moves that the piece generators append to.
+*/
+typedef struct {
+    move_t *moves;
+    size_t len;
+} _movebuf_t;
+
+static inline void _board_pushMove(_movebuf_t *dest, pos_t frompos, pos_t topos, pos_t killpos, pc_t frompc, pc_t topc, pc_t killpc) {
+#ifdef CHESSLIB_QWORD_MOVE
+    dest->moves[dest->len++] = MVMAKE(frompos, topos, killpos, frompc, topc, killpc);
+#else
+    move_t *move = &dest->moves[dest->len++];
+    move->frompos = frompos;
+    move->topos = topos;
+    move->killpos = killpos;
+    move->frompc = frompc;
+    move->topc = topc;
+    move->killpc = killpc;
+#endif
+}
+
+void _board_generatePawnMoves(const board_t *board, _movebuf_t *dest, const int rk, const int offs);
+void _board_generateKnightMoves(const board_t *board, _movebuf_t *dest, const int rk, const int offs);
+void _board_generateBishopMoves(const board_t *board, _movebuf_t *dest, const int rk, const int offs);
+void _board_generateRookMoves(const board_t *board, _movebuf_t *dest, const int rk, const int offs);
+void _board_generateQueenMoves(const board_t *board, _movebuf_t *dest, const int rk, const int offs);
+void _board_generateKingMoves(const board_t *board, _movebuf_t *dest, const int rk, const int offs);
 int _board_hitSingle(const board_t *board, const int rk, const int offs, const int white, uint8_t *blocks);
 int _board_hitKnight(const board_t *board, const int rk, const int offs, const int white);
 int _board_hitDiagonal(const board_t *board, const int rk, const int offs, const int white, uint8_t *blocks);
@@ -97,7 +121,24 @@ _move_delta_t king_moves[8] = {{UP, 0}, {DN, 0}, {0, RT}, {0, LT}, {UP, RT}, {UP
 #define CUR_QUEEN_MOVE queen_moves[i * 7 + j]
 
 alst_t *board_get_moves(const board_t *board) {
-    alst_t *ret = alst_make(30);  // reserve 30
+    TRACE_SCOPE();
+    TRACE_CALL(TRACE_GET_MOVES, board);
+    move_t moves[BOARD_MOVES_MAX];
+    const size_t len = board_get_moves_buf(board, moves);
+
+    alst_t *ret = alst_make(len);
+    for (size_t i = 0; i < len; ++i) {
+#ifdef CHESSLIB_QWORD_MOVE
+        alst_append(ret, (void *) moves[i]);
+#else
+        alst_append(ret, (void *) move_cpy(&moves[i]));
+#endif
+    }
+    return ret;
+}
+
+size_t _board_get_pseudo_moves_buf(const board_t *board, move_t *dest, pos_t *kingpos_out) {
+    _movebuf_t buf = {dest, 0};
 
     pos_t kingpos = NOPOS;  // this should be set by the end, or we are in an invalid state
     const int player = FLAGS_BPLAYER(board->flags);  // 1 if current player is black, 0 if white
@@ -117,33 +158,36 @@ alst_t *board_get_moves(const board_t *board) {
                 rank >>= 4;
                 continue;
             }
+            if (pc != NOPC) {
+                STATS_INC(gen[pc % 6]);
+            }
             switch (pc) {
             case NOPC:
                 break;
             case WPAWN:
             case BPAWN:
-                _board_generatePawnMoves(board, ret, rk, offs);
+                _board_generatePawnMoves(board, &buf, rk, offs);
                 break;
             case WKNIGHT:
             case BKNIGHT:
-                _board_generateKnightMoves(board, ret, rk, offs);
+                _board_generateKnightMoves(board, &buf, rk, offs);
                 break;
             case WBISHOP:
             case BBISHOP:
-                _board_generateBishopMoves(board, ret, rk, offs);
+                _board_generateBishopMoves(board, &buf, rk, offs);
                 break;
             case WROOK:
             case BROOK:
-                _board_generateRookMoves(board, ret, rk, offs);
+                _board_generateRookMoves(board, &buf, rk, offs);
                 break;
             case WQUEEN:
             case BQUEEN:
-                _board_generateQueenMoves(board, ret, rk, offs);
+                _board_generateQueenMoves(board, &buf, rk, offs);
                 break;
             case WKING:
             case BKING:
                 kingpos = POS2(offs, rk);
-                _board_generateKingMoves(board, ret, rk, offs);
+                _board_generateKingMoves(board, &buf, rk, offs);
                 break;
             default:
                 break;
@@ -153,46 +197,59 @@ alst_t *board_get_moves(const board_t *board) {
     }
 
     assert(kingpos != NOPOS);
+    *kingpos_out = kingpos;
+    return buf.len;
+}
+
+#ifdef CHESSLIB_QWORD_MOVE
+int _board_is_legal(const board_t *board, const move_t move, const pos_t kingpos) {
+#else
+int _board_is_legal(const board_t *board, const move_t *move, const pos_t kingpos) {
+#endif
+    // the future board lives on the stack
+    const int player = FLAGS_BPLAYER(board->flags);
+    const pc_t king = player ? BKING : WKING;
+    board_t board_future = *board;
+    board_apply_move(&board_future, move);
+#ifdef CHESSLIB_QWORD_MOVE
+    const pos_t kingpos_future = (MVFROMPC(move) == king) ? MVTOPOS(move) : kingpos;
+#else
+    const pos_t kingpos_future = (move->frompc == king) ? move->topos : kingpos;
+#endif
+    return !_board_hit(&board_future, kingpos_future / 8, kingpos_future % 8, player);
+}
 
-    const pc_t king = FLAGS_BPLAYER(board->flags) ? BKING : WKING;
+size_t board_get_moves_buf(const board_t *board, move_t *dest) {
+    STATS_INC(get_moves);
+    TRACE_SCOPE();
+    TRACE_CALL(TRACE_GET_MOVES_BUF, board);
+    STATS_TIMER(gen_start);
+    pos_t kingpos;
+    const size_t len = _board_get_pseudo_moves_buf(board, dest, &kingpos);
+    STATS_ELAPSED(gen_cycles, gen_start);
+    STATS_ADD(pseudo, len);
+    STATS_TIMER(filter_start);
+
+    // keep the moves that don't leave the king hit, in place
     size_t j = 0;  // end of kept portion
-    for (size_t i = 0; i < ret->len; ++i) {
+    for (size_t i = 0; i < len; ++i) {
 #ifdef CHESSLIB_QWORD_MOVE
-        move_t move = (move_t) alst_get(ret, i);
-        board_t *board_future = board_copy(board);
-        board_apply_move(board_future, move);
-        pos_t kingpos_future = (MVFROMPC(move) == king) ? MVTOPOS(move) : kingpos;
-        if (!_board_hit(board_future, kingpos_future / 8, kingpos_future % 8, player)) {  // king is not hit; keep
-            // swap ith and jth move
-            move_t tmp = (move_t) alst_get(ret, j);  // tmp = ar[j]
-            alst_put(ret, j, (void *) move);            // ar[j] = ar[i]
-            alst_put(ret, i, (void *) tmp);             // ar[i] = tmp
-            ++j;
-        } // else king is hit; forget this move (free)
-        board_free(board_future);
+        if (_board_is_legal(board, dest[i], kingpos)) {  // king is not hit; keep
 #else
-        move_t *move = (move_t *) alst_get(ret, i);
-        board_t *board_future = board_copy(board);
-        board_apply_move(board_future, move);
-        pos_t kingpos_future = (move->frompc == king) ? move->topos : kingpos;
-        if (!_board_hit(board_future, kingpos_future / 8, kingpos_future % 8, player)) {  // king is not hit; keep
-            // swap ith and jth move
-            move_t *tmp = (move_t *) alst_get(ret, j);  // tmp = ar[j]
-            alst_put(ret, j, (void *) move);            // ar[j] = ar[i]
-            alst_put(ret, i, (void *) tmp);             // ar[i] = tmp
-            ++j;
-        } else {  // king is hit; forget this move (free)
-            move_free(move);
-        }
-        board_free(board_future);
+        if (_board_is_legal(board, &dest[i], kingpos)) {
 #endif
+            dest[j++] = dest[i];
+        } else {  // king is hit; forget this move
+            STATS_INC(rejected);
+        }
     }
-    ret->len = j;
+    STATS_ELAPSED(filter_cycles, filter_start);
 
-    return ret;
+    return j;
 }
 
 int _board_hit(const board_t *board, const int rk, const int offs, const int white) {
+    STATS_INC(hit);
 
     // since we are doing radius 1 checks disjoint from radius 2+ checks,
     // we need to make sure blocking pieces at rad1 block the corresponding
@@ -215,7 +272,7 @@ int _board_hit(const board_t *board, const int rk, const int offs, const int whi
     return 0;
 }
 
-void _board_generatePawnMoves(const board_t *board, alst_t *dest, const int rk, const int offs) {
+void _board_generatePawnMoves(const board_t *board, _movebuf_t *dest, const int rk, const int offs) {
 
     if (FLAGS_WPLAYER(board->flags)) {  // WHITE; moves go UP in rank
 
@@ -224,19 +281,19 @@ void _board_generatePawnMoves(const board_t *board, alst_t *dest, const int rk,
         && (((board->ranks[rk + 1] >> (offs * 4)) & 0xf) == NOPC)) {
             if (rk + 1 < 7) {
                 // add single up move (WPAWN topc)
-                alst_append(dest, (void *) move_make(POS2(offs, rk), POS2(offs, rk+1), NOPOS, WPAWN, WPAWN, NOPC));
+                _board_pushMove(dest, POS2(offs, rk), POS2(offs, rk+1), NOPOS, WPAWN, WPAWN, NOPC);
             } else {  // topc is promotion
                 // add PROMOTION up moves
-                alst_append(dest, (void *) move_make(POS2(offs, rk), POS2(offs, rk+1), NOPOS, WPAWN, WKNIGHT, NOPC));
-                alst_append(dest, (void *) move_make(POS2(offs, rk), POS2(offs, rk+1), NOPOS, WPAWN, WBISHOP, NOPC));
-                alst_append(dest, (void *) move_make(POS2(offs, rk), POS2(offs, rk+1), NOPOS, WPAWN, WROOK, NOPC));
-                alst_append(dest, (void *) move_make(POS2(offs, rk), POS2(offs, rk+1), NOPOS, WPAWN, WQUEEN, NOPC));
+                _board_pushMove(dest, POS2(offs, rk), POS2(offs, rk+1), NOPOS, WPAWN, WKNIGHT, NOPC);
+                _board_pushMove(dest, POS2(offs, rk), POS2(offs, rk+1), NOPOS, WPAWN, WBISHOP, NOPC);
+                _board_pushMove(dest, POS2(offs, rk), POS2(offs, rk+1), NOPOS, WPAWN, WROOK, NOPC);
+                _board_pushMove(dest, POS2(offs, rk), POS2(offs, rk+1), NOPOS, WPAWN, WQUEEN, NOPC);
             }
             if (rk == 1
             && ISPOS2(rk + 2, offs)
             && (((board->ranks[rk + 2] >> (offs * 4)) & 0xf) == NOPC)) {
                 // add double up move
-                alst_append(dest, (void *) move_make(POS2(offs, rk), POS2(offs, rk+2), NOPOS, WPAWN, WPAWN, NOPC));
+                _board_pushMove(dest, POS2(offs, rk), POS2(offs, rk+2), NOPOS, WPAWN, WPAWN, NOPC);
             }
         }
 
@@ -246,13 +303,13 @@ void _board_generatePawnMoves(const board_t *board, alst_t *dest, const int rk,
             if (killpc >= BPAWN && killpc <= BKING) {  // is black piece
                 if (rk + 1 < 7) {
                     // add up left diagonal take
-                    alst_append(dest, (void *) move_make(POS2(offs, rk), POS2(offs-1, rk+1), POS2(offs-1, rk+1), WPAWN, WPAWN, killpc));
+                    _board_pushMove(dest, POS2(offs, rk), POS2(offs-1, rk+1), POS2(offs-1, rk+1), WPAWN, WPAWN, killpc);
                 } else {  // killpos/topos is promotion
                     // add up left diagonal promotion take
-                    alst_append(dest, (void *) move_make(POS2(offs, rk), POS2(offs-1, rk+1), POS2(offs-1, rk+1), WPAWN, WKNIGHT, killpc));
-                    alst_append(dest, (void *) move_make(POS2(offs, rk), POS2(offs-1, rk+1), POS2(offs-1, rk+1), WPAWN, WBISHOP, killpc));
-                    alst_append(dest, (void *) move_make(POS2(offs, rk), POS2(offs-1, rk+1), POS2(offs-1, rk+1), WPAWN, WROOK, killpc));
-                    alst_append(dest, (void *) move_make(POS2(offs, rk), POS2(offs-1, rk+1), POS2(offs-1, rk+1), WPAWN, WQUEEN, killpc));
+                    _board_pushMove(dest, POS2(offs, rk), POS2(offs-1, rk+1), POS2(offs-1, rk+1), WPAWN, WKNIGHT, killpc);
+                    _board_pushMove(dest, POS2(offs, rk), POS2(offs-1, rk+1), POS2(offs-1, rk+1), WPAWN, WBISHOP, killpc);
+                    _board_pushMove(dest, POS2(offs, rk), POS2(offs-1, rk+1), POS2(offs-1, rk+1), WPAWN, WROOK, killpc);
+                    _board_pushMove(dest, POS2(offs, rk), POS2(offs-1, rk+1), POS2(offs-1, rk+1), WPAWN, WQUEEN, killpc);
                 }
             }
         }
@@ -261,13 +318,13 @@ void _board_generatePawnMoves(const board_t *board, alst_t *dest, const int rk,
             if (killpc >= BPAWN && killpc <= BKING) {  // is black piece
                 if (rk + 1 < 7) {
                     // add up right diagonal take
-                    alst_append(dest, (void *) move_make(POS2(offs, rk), POS2(offs+1, rk+1), POS2(offs+1,rk+1), WPAWN, WPAWN, killpc));
+                    _board_pushMove(dest, POS2(offs, rk), POS2(offs+1, rk+1), POS2(offs+1,rk+1), WPAWN, WPAWN, killpc);
                 } else {  // killpos/topos is promotion
                     // add up right diagonal promotion take
-                    alst_append(dest, (void *) move_make(POS2(offs, rk), POS2(offs+1, rk+1), POS2(offs+1,rk+1), WPAWN, WKNIGHT, killpc));
-                    alst_append(dest, (void *) move_make(POS2(offs, rk), POS2(offs+1, rk+1), POS2(offs+1,rk+1), WPAWN, WBISHOP, killpc));
-                    alst_append(dest, (void *) move_make(POS2(offs, rk), POS2(offs+1, rk+1), POS2(offs+1,rk+1), WPAWN, WROOK, killpc));
-                    alst_append(dest, (void *) move_make(POS2(offs, rk), POS2(offs+1, rk+1), POS2(offs+1,rk+1), WPAWN, WQUEEN, killpc));
+                    _board_pushMove(dest, POS2(offs, rk), POS2(offs+1, rk+1), POS2(offs+1,rk+1), WPAWN, WKNIGHT, killpc);
+                    _board_pushMove(dest, POS2(offs, rk), POS2(offs+1, rk+1), POS2(offs+1,rk+1), WPAWN, WBISHOP, killpc);
+                    _board_pushMove(dest, POS2(offs, rk), POS2(offs+1, rk+1), POS2(offs+1,rk+1), WPAWN, WROOK, killpc);
+                    _board_pushMove(dest, POS2(offs, rk), POS2(offs+1, rk+1), POS2(offs+1,rk+1), WPAWN, WQUEEN, killpc);
                 }
             }
         }
@@ -278,7 +335,7 @@ void _board_generatePawnMoves(const board_t *board, alst_t *dest, const int rk,
         && ((ISPOS2(rk+1, offs-1) && eppos == POS2(offs - 1, rk + 1))
          || (ISPOS2(rk+1, offs+1) && eppos == POS2(offs + 1, rk + 1)))) {
             // add ep up take
-            alst_append(dest, (void *) move_make(POS2(offs, rk), eppos, eppos - 8, WPAWN, WPAWN, BPAWN));
+            _board_pushMove(dest, POS2(offs, rk), eppos, eppos - 8, WPAWN, WPAWN, BPAWN);
         }
 
     } else {  // BLACK; moves go DOWN in rank
@@ -289,19 +346,19 @@ void _board_generatePawnMoves(const board_t *board, alst_t *dest, const int rk,
         && (((board->ranks[rk - 1] >> (offs * 4)) & 0xf) == NOPC)) {
             if (rk - 1 > 0) {
                 // add single down move (BPAWN topc)
-                alst_append(dest, (void *) move_make(POS2(offs, rk), POS2(offs, rk-1), NOPOS, BPAWN, BPAWN, NOPC));
+                _board_pushMove(dest, POS2(offs, rk), POS2(offs, rk-1), NOPOS, BPAWN, BPAWN, NOPC);
             } else {  // topc is promotion
                 // add PROMOTION down moves
-                alst_append(dest, (void *) move_make(POS2(offs, rk), POS2(offs, rk-1), NOPOS, BPAWN, BKNIGHT, NOPC));
-                alst_append(dest, (void *) move_make(POS2(offs, rk), POS2(offs, rk-1), NOPOS, BPAWN, BBISHOP, NOPC));
-                alst_append(dest, (void *) move_make(POS2(offs, rk), POS2(offs, rk-1), NOPOS, BPAWN, BROOK, NOPC));
-                alst_append(dest, (void *) move_make(POS2(offs, rk), POS2(offs, rk-1), NOPOS, BPAWN, BQUEEN, NOPC));
+                _board_pushMove(dest, POS2(offs, rk), POS2(offs, rk-1), NOPOS, BPAWN, BKNIGHT, NOPC);
+                _board_pushMove(dest, POS2(offs, rk), POS2(offs, rk-1), NOPOS, BPAWN, BBISHOP, NOPC);
+                _board_pushMove(dest, POS2(offs, rk), POS2(offs, rk-1), NOPOS, BPAWN, BROOK, NOPC);
+                _board_pushMove(dest, POS2(offs, rk), POS2(offs, rk-1), NOPOS, BPAWN, BQUEEN, NOPC);
             }
             if (rk == 6
             && ISPOS2(rk - 2, offs)
             && (((board->ranks[rk - 2] >> (offs * 4)) & 0xf) == NOPC)) {
                 // add double down move
-                alst_append(dest, (void *) move_make(POS2(offs, rk), POS2(offs, rk-2), NOPOS, BPAWN, BPAWN, NOPC));
+                _board_pushMove(dest, POS2(offs, rk), POS2(offs, rk-2), NOPOS, BPAWN, BPAWN, NOPC);
             }
         }
 
@@ -311,12 +368,12 @@ void _board_generatePawnMoves(const board_t *board, alst_t *dest, const int rk,
             if (killpc <= WKING) {  // is white piece
                 if (rk - 1 > 0) {
                     // add down left diagonal take
-                    alst_append(dest, (void *) move_make(POS2(offs, rk), POS2(offs-1, rk-1), POS2(offs-1, rk-1), BPAWN, BPAWN, killpc));
+                    _board_pushMove(dest, POS2(offs, rk), POS2(offs-1, rk-1), POS2(offs-1, rk-1), BPAWN, BPAWN, killpc);
                 } else {  // killpos/topos is promotion
-                    alst_append(dest, (void *) move_make(POS2(offs, rk), POS2(offs-1, rk-1), POS2(offs-1, rk-1), BPAWN, BKNIGHT, killpc));
-                    alst_append(dest, (void *) move_make(POS2(offs, rk), POS2(offs-1, rk-1), POS2(offs-1, rk-1), BPAWN, BBISHOP, killpc));
-                    alst_append(dest, (void *) move_make(POS2(offs, rk), POS2(offs-1, rk-1), POS2(offs-1, rk-1), BPAWN, BROOK, killpc));
-                    alst_append(dest, (void *) move_make(POS2(offs, rk), POS2(offs-1, rk-1), POS2(offs-1, rk-1), BPAWN, BQUEEN, killpc));
+                    _board_pushMove(dest, POS2(offs, rk), POS2(offs-1, rk-1), POS2(offs-1, rk-1), BPAWN, BKNIGHT, killpc);
+                    _board_pushMove(dest, POS2(offs, rk), POS2(offs-1, rk-1), POS2(offs-1, rk-1), BPAWN, BBISHOP, killpc);
+                    _board_pushMove(dest, POS2(offs, rk), POS2(offs-1, rk-1), POS2(offs-1, rk-1), BPAWN, BROOK, killpc);
+                    _board_pushMove(dest, POS2(offs, rk), POS2(offs-1, rk-1), POS2(offs-1, rk-1), BPAWN, BQUEEN, killpc);
                 }
             }
         }
@@ -325,12 +382,12 @@ void _board_generatePawnMoves(const board_t *board, alst_t *dest, const int rk,
             if (killpc <= WKING) {  // is white piece
                 if (rk - 1 > 0) {
                     // add down right diagonal take
-                    alst_append(dest, (void *) move_make(POS2(offs, rk), POS2(offs+1, rk-1), POS2(offs+1, rk-1), BPAWN, BPAWN, killpc));
+                    _board_pushMove(dest, POS2(offs, rk), POS2(offs+1, rk-1), POS2(offs+1, rk-1), BPAWN, BPAWN, killpc);
                 } else {  // killpos/topos is promotion
-                    alst_append(dest, (void *) move_make(POS2(offs, rk), POS2(offs+1, rk-1), POS2(offs+1, rk-1), BPAWN, BKNIGHT, killpc));
-                    alst_append(dest, (void *) move_make(POS2(offs, rk), POS2(offs+1, rk-1), POS2(offs+1, rk-1), BPAWN, BBISHOP, killpc));
-                    alst_append(dest, (void *) move_make(POS2(offs, rk), POS2(offs+1, rk-1), POS2(offs+1, rk-1), BPAWN, BROOK, killpc));
-                    alst_append(dest, (void *) move_make(POS2(offs, rk), POS2(offs+1, rk-1), POS2(offs+1, rk-1), BPAWN, BQUEEN, killpc));
+                    _board_pushMove(dest, POS2(offs, rk), POS2(offs+1, rk-1), POS2(offs+1, rk-1), BPAWN, BKNIGHT, killpc);
+                    _board_pushMove(dest, POS2(offs, rk), POS2(offs+1, rk-1), POS2(offs+1, rk-1), BPAWN, BBISHOP, killpc);
+                    _board_pushMove(dest, POS2(offs, rk), POS2(offs+1, rk-1), POS2(offs+1, rk-1), BPAWN, BROOK, killpc);
+                    _board_pushMove(dest, POS2(offs, rk), POS2(offs+1, rk-1), POS2(offs+1, rk-1), BPAWN, BQUEEN, killpc);
                 }
             }
         }
@@ -341,12 +398,12 @@ void _board_generatePawnMoves(const board_t *board, alst_t *dest, const int rk,
         && ((ISPOS2(rk-1, offs-1) && eppos == POS2(offs - 1, rk - 1))
          || (ISPOS2(rk-1, offs+1) && eppos == POS2(offs + 1, rk - 1)))) {
             // add ep down take
-            alst_append(dest, (void *) move_make(POS2(offs, rk), eppos, eppos + 8, BPAWN, BPAWN, WPAWN));
+            _board_pushMove(dest, POS2(offs, rk), eppos, eppos + 8, BPAWN, BPAWN, WPAWN);
         }
     }
 }
 
-void _board_generateKnightMoves(const board_t *board, alst_t *dest, const int rk, const int offs) {
+void _board_generateKnightMoves(const board_t *board, _movebuf_t *dest, const int rk, const int offs) {
     const pc_t frompc = FLAGS_WPLAYER(board->flags) ? WKNIGHT : BKNIGHT;
     pc_t killpc;
 
@@ -356,16 +413,16 @@ void _board_generateKnightMoves(const board_t *board, alst_t *dest, const int rk
             killpc = (board->ranks[rk + mv.dx] >> ((offs + mv.dy) * 4)) & 0xf;
             if (killpc == NOPC) {
                 // just a knight move
-                alst_append(dest, (void *) move_make(POS2(offs, rk), POS2(offs+mv.dy, rk+mv.dx), NOPOS, frompc, frompc, NOPC));
+                _board_pushMove(dest, POS2(offs, rk), POS2(offs+mv.dy, rk+mv.dx), NOPOS, frompc, frompc, NOPC);
             } else if ((killpc / 6) != (frompc / 6)) {  // pc is different color
                 // knight capture
-                alst_append(dest, (void *) move_make(POS2(offs, rk), POS2(offs+mv.dy, rk+mv.dx), POS2(offs+mv.dy, rk+mv.dx), frompc, frompc, killpc));
+                _board_pushMove(dest, POS2(offs, rk), POS2(offs+mv.dy, rk+mv.dx), POS2(offs+mv.dy, rk+mv.dx), frompc, frompc, killpc);
             }
         }
     }
 }
 
-void _board_generateBishopMoves(const board_t *board, alst_t *dest, const int rk, const int offs) {
+void _board_generateBishopMoves(const board_t *board, _movebuf_t *dest, const int rk, const int offs) {
     const pc_t frompc = FLAGS_WPLAYER(board->flags) ? WBISHOP : BBISHOP;
     pc_t killpc;
 
@@ -374,10 +431,10 @@ void _board_generateBishopMoves(const board_t *board, alst_t *dest, const int rk
             if (ISPOS2(rk + CUR_BISHOP_MOVE.dx, offs + CUR_BISHOP_MOVE.dy)) {  // in bounds
                 killpc = (board->ranks[rk+CUR_BISHOP_MOVE.dx] >> ((offs+CUR_BISHOP_MOVE.dy) * 4)) & 0xf;
                 if (killpc == NOPC) {  // normal bishop move
-                    alst_append(dest, (void *) move_make(POS2(offs, rk), POS2(offs+CUR_BISHOP_MOVE.dy, rk+CUR_BISHOP_MOVE.dx), NOPOS, frompc, frompc, NOPC));
+                    _board_pushMove(dest, POS2(offs, rk), POS2(offs+CUR_BISHOP_MOVE.dy, rk+CUR_BISHOP_MOVE.dx), NOPOS, frompc, frompc, NOPC);
                 } else {  // kill the diagonal
                     if ((killpc / 6) != (frompc / 6)) {  // capture
-                        alst_append(dest, (void *) move_make(POS2(offs, rk), POS2(offs+CUR_BISHOP_MOVE.dy, rk+CUR_BISHOP_MOVE.dx), POS2(offs+CUR_BISHOP_MOVE.dy, rk+CUR_BISHOP_MOVE.dx), frompc, frompc, killpc));
+                        _board_pushMove(dest, POS2(offs, rk), POS2(offs+CUR_BISHOP_MOVE.dy, rk+CUR_BISHOP_MOVE.dx), POS2(offs+CUR_BISHOP_MOVE.dy, rk+CUR_BISHOP_MOVE.dx), frompc, frompc, killpc);
                     }
                     j = 7;  // unconditionally kill diagonal if encountered another piece
                 }
@@ -388,7 +445,7 @@ void _board_generateBishopMoves(const board_t *board, alst_t *dest, const int rk
     }
 }
 
-void _board_generateRookMoves(const board_t *board, alst_t *dest, const int rk, const int offs) {
+void _board_generateRookMoves(const board_t *board, _movebuf_t *dest, const int rk, const int offs) {
     const pc_t frompc = FLAGS_WPLAYER(board->flags) ? WROOK : BROOK;
     pc_t killpc;
 
@@ -397,10 +454,10 @@ void _board_generateRookMoves(const board_t *board, alst_t *dest, const int rk,
             if (ISPOS2(rk + CUR_ROOK_MOVE.dx, offs + CUR_ROOK_MOVE.dy)) {  // in bounds
                 killpc = (board->ranks[rk+CUR_ROOK_MOVE.dx] >> ((offs+CUR_ROOK_MOVE.dy) * 4)) & 0xf;
                 if (killpc == NOPC) {  // normal rook move
-                    alst_append(dest, (void *) move_make(POS2(offs, rk), POS2(offs+CUR_ROOK_MOVE.dy, rk+CUR_ROOK_MOVE.dx), NOPOS, frompc, frompc, NOPC));
+                    _board_pushMove(dest, POS2(offs, rk), POS2(offs+CUR_ROOK_MOVE.dy, rk+CUR_ROOK_MOVE.dx), NOPOS, frompc, frompc, NOPC);
                 } else {  // kill the lateral
                     if ((killpc / 6) != (frompc / 6)) {  // capture
-                        alst_append(dest, (void *) move_make(POS2(offs, rk), POS2(offs+CUR_ROOK_MOVE.dy, rk+CUR_ROOK_MOVE.dx), POS2(offs+CUR_ROOK_MOVE.dy, rk+CUR_ROOK_MOVE.dx), frompc, frompc, killpc));
+                        _board_pushMove(dest, POS2(offs, rk), POS2(offs+CUR_ROOK_MOVE.dy, rk+CUR_ROOK_MOVE.dx), POS2(offs+CUR_ROOK_MOVE.dy, rk+CUR_ROOK_MOVE.dx), frompc, frompc, killpc);
                     }
                     j = 7;  // unconditionally kill lateral if encountered another piece
                 }
@@ -411,7 +468,7 @@ void _board_generateRookMoves(const board_t *board, alst_t *dest, const int rk,
     }
 }
 
-void _board_generateQueenMoves(const board_t *board, alst_t *dest, const int rk, const int offs) {
+void _board_generateQueenMoves(const board_t *board, _movebuf_t *dest, const int rk, const int offs) {
     const pc_t frompc = FLAGS_WPLAYER(board->flags) ? WQUEEN : BQUEEN;
     pc_t killpc;
 
@@ -420,10 +477,10 @@ void _board_generateQueenMoves(const board_t *board, alst_t *dest, const int rk,
             if (ISPOS2(rk + CUR_QUEEN_MOVE.dx, offs + CUR_QUEEN_MOVE.dy)) {  // in bounds
                 killpc = (board->ranks[rk+CUR_QUEEN_MOVE.dx] >> ((offs+CUR_QUEEN_MOVE.dy) * 4)) & 0xf;
                 if (killpc == NOPC) {  // normal queen move
-                    alst_append(dest, (void *) move_make(POS2(offs, rk), POS2(offs+CUR_QUEEN_MOVE.dy, rk+CUR_QUEEN_MOVE.dx), NOPOS, frompc, frompc, NOPC));
+                    _board_pushMove(dest, POS2(offs, rk), POS2(offs+CUR_QUEEN_MOVE.dy, rk+CUR_QUEEN_MOVE.dx), NOPOS, frompc, frompc, NOPC);
                 } else {  // kill the lat / diag
                     if ((killpc / 6) != (frompc / 6)) {  // capture
-                        alst_append(dest, (void *) move_make(POS2(offs, rk), POS2(offs+CUR_QUEEN_MOVE.dy, rk+CUR_QUEEN_MOVE.dx), POS2(offs+CUR_QUEEN_MOVE.dy, rk+CUR_QUEEN_MOVE.dx), frompc, frompc, killpc));
+                        _board_pushMove(dest, POS2(offs, rk), POS2(offs+CUR_QUEEN_MOVE.dy, rk+CUR_QUEEN_MOVE.dx), POS2(offs+CUR_QUEEN_MOVE.dy, rk+CUR_QUEEN_MOVE.dx), frompc, frompc, killpc);
                     }
                     j = 7;  // unconditionally kill lat / diag if encountered another piece
                 }
@@ -434,7 +491,7 @@ void _board_generateQueenMoves(const board_t *board, alst_t *dest, const int rk,
     }
 }
 
-void _board_generateKingMoves(const board_t *board, alst_t *dest, const int rk, const int offs) {
+void _board_generateKingMoves(const board_t *board, _movebuf_t *dest, const int rk, const int offs) {
     const pc_t frompc = FLAGS_WPLAYER(board->flags) ? WKING : BKING;
     pc_t killpc;
 
@@ -445,10 +502,10 @@ void _board_generateKingMoves(const board_t *board, alst_t *dest, const int rk,
             killpc = (board->ranks[rk + mv.dx] >> ((offs + mv.dy) * 4)) & 0xf;
             if (killpc == NOPC) {
                 // just a king move
-                alst_append(dest, (void *) move_make(POS2(offs, rk), POS2(offs+mv.dy, rk+mv.dx), NOPOS, frompc, frompc, NOPC));
+                _board_pushMove(dest, POS2(offs, rk), POS2(offs+mv.dy, rk+mv.dx), NOPOS, frompc, frompc, NOPC);
             } else if ((killpc / 6) != (frompc / 6)) {  // pc is different color
                 // king capture
-                alst_append(dest, (void *) move_make(POS2(offs, rk), POS2(offs+mv.dy, rk+mv.dx), POS2(offs+mv.dy, rk+mv.dx), frompc, frompc, killpc));
+                _board_pushMove(dest, POS2(offs, rk), POS2(offs+mv.dy, rk+mv.dx), POS2(offs+mv.dy, rk+mv.dx), frompc, frompc, killpc);
             }
         }
     }
@@ -462,7 +519,7 @@ void _board_generateKingMoves(const board_t *board, alst_t *dest, const int rk,
         && !_board_hit(board, rk, offs, 0)       // king not in check
         && !_board_hit(board, rk, offs+1, 0)) {  // f1 not hit
 //        && !hit(rk, offs+2, false)) {  // g1 not hit
-            alst_append(dest, (void *) move_make(POS2(offs, rk), POS2(offs+2, rk), NOPOS, frompc, frompc, NOPC));
+            _board_pushMove(dest, POS2(offs, rk), POS2(offs+2, rk), NOPOS, frompc, frompc, NOPC);
         }
 
         if (FLAGS_WQCASTLE(board->flags)  // white queenside
@@ -472,7 +529,7 @@ void _board_generateKingMoves(const board_t *board, alst_t *dest, const int rk,
         && !_board_hit(board, rk, offs, 0)       // king not in check
         && !_board_hit(board, rk, offs-1, 0)) {  // d1 not hit
 //        && !hit(rk, offs-2, false)) {  // c1 not hit
-            alst_append(dest, (void *) move_make(POS2(offs, rk), POS2(offs-2, rk), NOPOS, frompc, frompc, NOPC));
+            _board_pushMove(dest, POS2(offs, rk), POS2(offs-2, rk), NOPOS, frompc, frompc, NOPC);
         }
 
     } else {  // black
@@ -483,7 +540,7 @@ void _board_generateKingMoves(const board_t *board, alst_t *dest, const int rk,
         && !_board_hit(board, rk, offs, 1)       // king not in check
         && !_board_hit(board, rk, offs+1, 1)) {  // f8 not hit
 //        && !hit(rk, offs+2, true)) {  // g8 not hit
-            alst_append(dest, (void *) move_make(POS2(offs, rk), POS2(offs+2, rk), NOPOS, frompc, frompc, NOPC));
+            _board_pushMove(dest, POS2(offs, rk), POS2(offs+2, rk), NOPOS, frompc, frompc, NOPC);
         }
 
         if (FLAGS_BQCASTLE(board->flags)  // black queenside
@@ -493,7 +550,7 @@ void _board_generateKingMoves(const board_t *board, alst_t *dest, const int rk,
         && !_board_hit(board, rk, offs, 1)       // king not in check
         && !_board_hit(board, rk, offs-1, 1)) {  // d8 not hit
 //        && !hit(rk, offs-2, true)) {  // c8 not hit
-            alst_append(dest, (void *) move_make(POS2(offs, rk), POS2(offs-2, rk), NOPOS, frompc, frompc, NOPC));
+            _board_pushMove(dest, POS2(offs, rk), POS2(offs-2, rk), NOPOS, frompc, frompc, NOPC);
         }
     }
 }
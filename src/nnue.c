@@ -0,0 +1,286 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "nnue.h"
+#include "alloc.h"
+
+#ifndef CHESSLIB_QWORD_MOVE
+#error "nnue requires CHESSLIB_QWORD_MOVE"
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define NNUE_X86
+#include <immintrin.h>
+#define NNUE_AVX2 __attribute__((target("avx2")))
+#endif
+
+#define NNUE_HEADER 16
+#define NNUE_FEATURES_MAX 32  // inputs changed at once: all pieces of a board, when refreshing
+
+static int _nnue_avx2;  // nonzero if the processor has AVX2
+static int _nnue_simd;  // nonzero if the AVX2 kernels are in use
+
+#ifdef NNUE_X86
+__attribute__((constructor)) static void _nnue_init(void) {
+    __builtin_cpu_init();
+    _nnue_avx2 = _nnue_simd = __builtin_cpu_supports("avx2");
+}
+#endif
+
+int nnue_set_simd(int enable) {
+    _nnue_simd = enable && _nnue_avx2;
+    return _nnue_simd;
+}
+
+static inline uint32_t _nnue_read32(const uint8_t *p) {
+    return (uint32_t) p[0] | (uint32_t) p[1] << 8 | (uint32_t) p[2] << 16 | (uint32_t) p[3] << 24;
+}
+
+static inline int16_t _nnue_read16(const uint8_t *p) {
+    return (int16_t) (p[0] | p[1] << 8);
+}
+
+static void *_nnue_alloc(size_t size) {
+    void *ret = alloc_malloc(size);
+    if (!ret) {
+        fprintf(stderr, "malloc error in nnue_load\n");
+        exit(EXIT_FAILURE);
+    }
+    return ret;
+}
+
+nnue_t *nnue_load(const char *path) {
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        return NULL;
+    }
+    uint8_t header[NNUE_HEADER];
+    if (fread(header, 1, NNUE_HEADER, file) != NNUE_HEADER || memcmp(header, "CLNN", 4)
+        || _nnue_read32(&header[4]) != NNUE_VERSION) {
+        fclose(file);
+        return NULL;
+    }
+    const uint32_t hidden = _nnue_read32(&header[8]);
+    const uint32_t l2 = _nnue_read32(&header[12]);
+    if (!hidden || hidden % 32 || hidden > NNUE_HIDDEN_MAX || !l2 || l2 > NNUE_L2_MAX) {
+        fclose(file);
+        return NULL;
+    }
+
+    // the rest of the file, which must be exactly the size of the network
+    const size_t bytes = (NNUE_INPUTS + 1) * hidden * 2 + l2 * 2 * hidden + l2 * 4 + l2 + 4;
+    uint8_t *buf = (uint8_t *) _nnue_alloc(bytes + 1);
+    const size_t len = fread(buf, 1, bytes + 1, file);
+    fclose(file);
+    if (len != bytes) {
+        alloc_free(buf);
+        return NULL;
+    }
+
+    nnue_t *ret = (nnue_t *) _nnue_alloc(sizeof(nnue_t));
+    ret->hidden = hidden;
+    ret->l2 = l2;
+    ret->ft_weights = (int16_t *) _nnue_alloc((NNUE_INPUTS + 1) * hidden * sizeof(int16_t));
+    ret->ft_biases = ret->ft_weights + NNUE_INPUTS * hidden;
+    ret->l1_weights = (int8_t *) _nnue_alloc(l2 * 2 * hidden);
+    const uint8_t *p = buf;
+    for (size_t i = 0; i < (NNUE_INPUTS + 1) * hidden; ++i, p += 2) {
+        ret->ft_weights[i] = _nnue_read16(p);
+    }
+    memcpy(ret->l1_weights, p, l2 * 2 * hidden);
+    p += l2 * 2 * hidden;
+    for (size_t i = 0; i < l2; ++i, p += 4) {
+        ret->l1_biases[i] = (int32_t) _nnue_read32(p);
+    }
+    memcpy(ret->out_weights, p, l2);
+    p += l2;
+    ret->out_bias = (int32_t) _nnue_read32(p);
+    alloc_free(buf);
+    return ret;
+}
+
+void nnue_free(nnue_t *net) {
+    if (net) {
+        alloc_free(net->ft_weights);
+        alloc_free(net->l1_weights);
+        alloc_free(net);
+    }
+}
+
+// the feature weights of piece (pc) on position (pos) from the point of view of (player), 0 white and 1 black
+static inline const int16_t *_nnue_row(const nnue_t *net, int player, int pc, int pos) {
+    if (player) {
+        pc = pc < BPAWN ? pc + BPAWN : pc - BPAWN;
+        pos ^= 56;
+    }
+    return &net->ft_weights[(size_t) (64 * pc + pos) * net->hidden];
+}
+
+// dest = src + the sum of the (nadd) rows of (add) - the sum of the (nsub) rows of (sub), over (len) values
+static void _nnue_accumulate(int16_t *dest, const int16_t *src, const int16_t **add, int nadd,
+                             const int16_t **sub, int nsub, int len) {
+    for (int i = 0; i < len; ++i) {
+        int16_t v = src[i];
+        for (int j = 0; j < nadd; ++j) {
+            v += add[j][i];
+        }
+        for (int j = 0; j < nsub; ++j) {
+            v -= sub[j][i];
+        }
+        dest[i] = v;
+    }
+}
+
+#ifdef NNUE_X86
+NNUE_AVX2 static void _nnue_accumulate_avx2(int16_t *dest, const int16_t *src, const int16_t **add, int nadd,
+                                            const int16_t **sub, int nsub, int len) {
+    for (int i = 0; i < len; i += 16) {
+        __m256i v = _mm256_loadu_si256((const __m256i *) &src[i]);
+        for (int j = 0; j < nadd; ++j) {
+            v = _mm256_add_epi16(v, _mm256_loadu_si256((const __m256i *) &add[j][i]));
+        }
+        for (int j = 0; j < nsub; ++j) {
+            v = _mm256_sub_epi16(v, _mm256_loadu_si256((const __m256i *) &sub[j][i]));
+        }
+        _mm256_storeu_si256((__m256i *) &dest[i], v);
+    }
+}
+#endif
+
+static inline void _nnue_apply(const nnue_t *net, int16_t *dest, const int16_t *src, const int16_t **add, int nadd,
+                               const int16_t **sub, int nsub) {
+#ifdef NNUE_X86
+    if (_nnue_simd) {
+        _nnue_accumulate_avx2(dest, src, add, nadd, sub, nsub, net->hidden);
+        return;
+    }
+#endif
+    _nnue_accumulate(dest, src, add, nadd, sub, nsub, net->hidden);
+}
+
+void nnue_refresh(const nnue_t *net, const board_t *board, nnue_acc_t *dest) {
+    int pcs[NNUE_FEATURES_MAX], poss[NNUE_FEATURES_MAX];
+    int n = 0;
+    for (int rk = 0; rk < 8; ++rk) {
+        uint32_t rank = board->ranks[rk];
+        for (int offs = 0; offs < 8; ++offs, rank >>= 4) {
+            if ((rank & 0xf) != NOPC && n < NNUE_FEATURES_MAX) {
+                pcs[n] = rank & 0xf;
+                poss[n++] = 8 * rk + offs;
+            }
+        }
+    }
+    for (int player = 0; player < 2; ++player) {
+        const int16_t *add[NNUE_FEATURES_MAX];
+        for (int i = 0; i < n; ++i) {
+            add[i] = _nnue_row(net, player, pcs[i], poss[i]);
+        }
+        _nnue_apply(net, dest->v[player], net->ft_biases, add, n, NULL, 0);
+    }
+}
+
+void nnue_update(const nnue_t *net, const nnue_acc_t *src, nnue_acc_t *dest, move_t move) {
+    // the moved piece, a captured piece, and the rook of a castle
+    int addpcs[2] = {MVTOPC(move)}, addposs[2] = {MVTOPOS(move)};
+    int subpcs[2] = {MVFROMPC(move)}, subposs[2] = {MVFROMPOS(move)};
+    int nadd = 1, nsub = 1;
+    if (MVKILLPC(move) != NOPC) {
+        subpcs[nsub] = MVKILLPC(move);
+        subposs[nsub++] = MVKILLPOS(move);
+    }
+    switch (move_is_castle(move)) {
+        case 0: break;
+        case WKCASTLE:
+            addpcs[nadd] = subpcs[nsub] = WROOK; addposs[nadd++] = POS('f', 1); subposs[nsub++] = POS('h', 1); break;
+        case WQCASTLE:
+            addpcs[nadd] = subpcs[nsub] = WROOK; addposs[nadd++] = POS('d', 1); subposs[nsub++] = POS('a', 1); break;
+        case BKCASTLE:
+            addpcs[nadd] = subpcs[nsub] = BROOK; addposs[nadd++] = POS('f', 8); subposs[nsub++] = POS('h', 8); break;
+        case BQCASTLE:
+            addpcs[nadd] = subpcs[nsub] = BROOK; addposs[nadd++] = POS('d', 8); subposs[nsub++] = POS('a', 8); break;
+    }
+    for (int player = 0; player < 2; ++player) {
+        const int16_t *add[2], *sub[2];
+        for (int i = 0; i < nadd; ++i) {
+            add[i] = _nnue_row(net, player, addpcs[i], addposs[i]);
+        }
+        for (int i = 0; i < nsub; ++i) {
+            sub[i] = _nnue_row(net, player, subpcs[i], subposs[i]);
+        }
+        _nnue_apply(net, dest->v[player], src->v[player], add, nadd, sub, nsub);
+    }
+}
+
+static inline int _nnue_clip(int v) {
+    return v < 0 ? 0 : v > NNUE_QA ? NNUE_QA : v;
+}
+
+// the hidden layer from the accumulators (us) and (them), into (dest)
+static void _nnue_hidden(const nnue_t *net, const int16_t *us, const int16_t *them, int32_t *dest) {
+    uint8_t in[2 * NNUE_HIDDEN_MAX];
+    for (int i = 0; i < net->hidden; ++i) {
+        in[i] = (uint8_t) _nnue_clip(us[i]);
+        in[net->hidden + i] = (uint8_t) _nnue_clip(them[i]);
+    }
+    for (int j = 0; j < net->l2; ++j) {
+        const int8_t *w = &net->l1_weights[(size_t) j * 2 * net->hidden];
+        int32_t sum = net->l1_biases[j];
+        for (int i = 0; i < 2 * net->hidden; ++i) {
+            sum += in[i] * w[i];
+        }
+        dest[j] = sum;
+    }
+}
+
+#ifdef NNUE_X86
+NNUE_AVX2 static void _nnue_hidden_avx2(const nnue_t *net, const int16_t *us, const int16_t *them, int32_t *dest) {
+    uint8_t in[2 * NNUE_HIDDEN_MAX] __attribute__((aligned(32)));
+    const __m256i qa = _mm256_set1_epi16(NNUE_QA);
+    for (int half = 0; half < 2; ++half) {
+        const int16_t *acc = half ? them : us;
+        for (int i = 0; i < net->hidden; i += 32) {
+            // clip to [0, NNUE_QA]: the minimum here, and the maximum by the unsigned saturation of the pack,
+            // which interleaves the halves of its operands, so the permutation restores their order
+            const __m256i a = _mm256_min_epi16(_mm256_loadu_si256((const __m256i *) &acc[i]), qa);
+            const __m256i b = _mm256_min_epi16(_mm256_loadu_si256((const __m256i *) &acc[i + 16]), qa);
+            const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xd8);
+            _mm256_store_si256((__m256i *) &in[half * net->hidden + i], packed);
+        }
+    }
+    const __m256i ones = _mm256_set1_epi16(1);
+    for (int j = 0; j < net->l2; ++j) {
+        const int8_t *w = &net->l1_weights[(size_t) j * 2 * net->hidden];
+        __m256i sum = _mm256_setzero_si256();
+        for (int i = 0; i < 2 * net->hidden; i += 32) {
+            // pairs of products fit in int16: 2 * NNUE_QA * 128 < 32768
+            const __m256i prods = _mm256_maddubs_epi16(_mm256_load_si256((const __m256i *) &in[i]),
+                                                       _mm256_loadu_si256((const __m256i *) &w[i]));
+            sum = _mm256_add_epi32(sum, _mm256_madd_epi16(prods, ones));
+        }
+        __m128i s = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+        s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4e));
+        s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xb1));
+        dest[j] = net->l1_biases[j] + _mm_cvtsi128_si32(s);
+    }
+}
+#endif
+
+int nnue_evaluate(const nnue_t *net, const board_t *board, const nnue_acc_t *acc) {
+    const int player = FLAGS_BPLAYER(board->flags);
+    int32_t hidden[NNUE_L2_MAX];
+#ifdef NNUE_X86
+    if (_nnue_simd) {
+        _nnue_hidden_avx2(net, acc->v[player], acc->v[!player], hidden);
+    } else {
+        _nnue_hidden(net, acc->v[player], acc->v[!player], hidden);
+    }
+#else
+    _nnue_hidden(net, acc->v[player], acc->v[!player], hidden);
+#endif
+    int32_t out = net->out_bias;
+    for (int j = 0; j < net->l2; ++j) {
+        out += _nnue_clip(hidden[j] >> NNUE_SHIFT) * net->out_weights[j];
+    }
+    return out / NNUE_SCALE;
+}
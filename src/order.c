@@ -0,0 +1,96 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "order.h"
+
+#ifndef CHESSLIB_QWORD_MOVE
+#error "order requires CHESSLIB_QWORD_MOVE"
+#endif
+
+// score bands, from the first searched to the last; quiet moves score their history, within +-ORDER_HISTORY_MAX
+#define ORDER_PV      (1 << 30)
+#define ORDER_HASH    (1 << 29)
+#define ORDER_CAPTURE (1 << 28)
+#define ORDER_KILLER  (1 << 27)
+#define ORDER_COUNTER (1 << 26)
+
+#define ORDER_PLAYER(move) (MVFROMPC(move) >= BPAWN)
+
+void order_clear(order_t *order) {
+    memset(order, 0, sizeof(order_t));
+}
+
+void order_age(order_t *order) {
+    memset(order->killers, 0, sizeof(order->killers));
+    int32_t *history = &order->history[0][0][0];
+    for (size_t i = 0; i < sizeof(order->history) / sizeof(int32_t); ++i) {
+        history[i] /= 2;
+    }
+}
+
+void order_moves(const order_t *order, move_t *moves, size_t len, move_t pvmove, move_t hashmove, int ply, move_t prev) {
+    int scores[BOARD_MOVES_MAX];
+    const move16_t *killers = ply < ORDER_MAX_PLY ? order->killers[ply] : NULL;
+    const move16_t counter = prev ? order->counters[MVTOPC(prev)][MVTOPOS(prev)] : 0;
+    for (size_t i = 0; i < len; ++i) {
+        const move_t move = moves[i];
+        if (move == pvmove) {
+            scores[i] = ORDER_PV;
+        } else if (move == hashmove) {
+            scores[i] = ORDER_HASH;
+        } else if (!order_is_quiet(move)) {
+            // by victim and promoted piece, then by attacker, least valuable first
+            const int victim = MVKILLPC(move) != NOPC ? MVKILLPC(move) % 6 + 1 : 0;
+            const int promo = MVTOPC(move) != MVFROMPC(move) ? MVTOPC(move) % 6 : 0;
+            scores[i] = ORDER_CAPTURE + (victim + promo) * 8 - MVFROMPC(move) % 6;
+        } else {
+            const move16_t packed = move16_make(move);
+            if (killers && packed == killers[0]) {
+                scores[i] = ORDER_KILLER + 1;
+            } else if (killers && packed == killers[1]) {
+                scores[i] = ORDER_KILLER;
+            } else if (packed == counter) {
+                scores[i] = ORDER_COUNTER;
+            } else {
+                scores[i] = order->history[ORDER_PLAYER(move)][MVFROMPOS(move)][MVTOPOS(move)];
+            }
+        }
+    }
+    for (size_t i = 1; i < len; ++i) {  // insertion sort, stable for equal scores
+        const move_t move = moves[i];
+        const int score = scores[i];
+        size_t j = i;
+        for (; j > 0 && scores[j - 1] < score; --j) {
+            moves[j] = moves[j - 1];
+            scores[j] = scores[j - 1];
+        }
+        moves[j] = move;
+        scores[j] = score;
+    }
+}
+
+// moves a history score towards +-ORDER_HISTORY_MAX by (bonus), by less the closer it is
+static inline void _order_history_add(int32_t *entry, int bonus) {
+    *entry += bonus - *entry * abs(bonus) / ORDER_HISTORY_MAX;
+}
+
+void order_update(order_t *order, move_t move, const move_t *tried, size_t ntried, int depth, int ply, move_t prev) {
+    if (!order_is_quiet(move)) {
+        return;
+    }
+    const move16_t packed = move16_make(move);
+    if (ply < ORDER_MAX_PLY && order->killers[ply][0] != packed) {
+        order->killers[ply][1] = order->killers[ply][0];
+        order->killers[ply][0] = packed;
+    }
+    if (prev) {
+        order->counters[MVTOPC(prev)][MVTOPOS(prev)] = packed;
+    }
+    const int bonus = depth * depth < ORDER_HISTORY_MAX / 4 ? depth * depth : ORDER_HISTORY_MAX / 4;
+    _order_history_add(&order->history[ORDER_PLAYER(move)][MVFROMPOS(move)][MVTOPOS(move)], bonus);
+    for (size_t i = 0; i < ntried; ++i) {
+        if (tried[i] != move) {
+            _order_history_add(&order->history[ORDER_PLAYER(tried[i])][MVFROMPOS(tried[i])][MVTOPOS(tried[i])], -bonus);
+        }
+    }
+}
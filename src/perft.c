@@ -0,0 +1,82 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "perft.h"
+
+uint64_t perft_count(const board_t *board, int depth) {
+    if (depth <= 0) {
+        return 1;
+    }
+    move_t moves[BOARD_MOVES_MAX];
+    const size_t len = board_get_moves_buf(board, moves);
+    if (depth == 1) {  // bulk count the leaves
+        return len;
+    }
+    uint64_t ct = 0;
+    board_t future;
+    for (size_t i = 0; i < len; ++i) {
+        future = *board;
+#ifdef CHESSLIB_QWORD_MOVE
+        board_apply_move(&future, moves[i]);
+#else
+        board_apply_move(&future, &moves[i]);
+#endif
+        ct += perft_count(&future, depth - 1);
+    }
+    return ct;
+}
+
+int perft_epd_parse(const char *line, perft_epd_t *epd) {
+    memset(epd, 0, sizeof(perft_epd_t));
+
+    // position: the first four space-separated fields before the first ';'
+    const char *p = line;
+    size_t len = 0;
+    for (int field = 0; field < 4; ++field) {
+        while (*p == ' ' || *p == '\t') {
+            ++p;
+        }
+        if (*p == '\0' || *p == ';' || *p == '\n' || *p == '\r') {
+            return 1;  // missing field
+        }
+        if (field) {
+            epd->fen[len++] = ' ';
+        }
+        while (*p && !isspace((unsigned char) *p) && *p != ';') {
+            if (len >= 81) {  // longer than board_make accepts
+                return 1;
+            }
+            epd->fen[len++] = *p++;
+        }
+    }
+    epd->fen[len] = '\0';
+
+    // depth annotations: ';D<depth> <count>', anything else before or between them is skipped
+    while ((p = strchr(p, ';'))) {
+        ++p;
+        while (*p == ' ' || *p == '\t') {
+            ++p;
+        }
+        if (*p != 'D') {
+            continue;
+        }
+        char *end;
+        long depth = strtol(p + 1, &end, 10);
+        if (end == p + 1 || depth < 1 || depth > PERFT_MAX_DEPTH) {
+            return 1;
+        }
+        p = end;
+        uint64_t count = strtoull(p, &end, 10);
+        if (end == p) {
+            return 1;
+        }
+        p = end;
+        epd->counts[depth] = count;
+        if (depth > epd->maxdepth) {
+            epd->maxdepth = (int) depth;
+        }
+    }
+    return 0;
+}
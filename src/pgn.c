@@ -0,0 +1,561 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "pgn.h"
+#include "epd.h"
+#include "alloc.h"
+#include "mapfile.h"
+
+#ifndef CHESSLIB_QWORD_MOVE
+#error "pgn requires CHESSLIB_QWORD_MOVE"
+#endif
+
+typedef struct {
+    const char *text;
+    size_t len;
+    mapfile_pool_t pool;  // of the chunks of (text)
+    pgn_callback_t callback;
+    void *ctx;
+    pthread_mutex_t lock;  // guards (stats)
+    pgn_stats_t stats;
+} _pgn_t;
+
+// buffers of a thread, grown to the largest game it reads
+typedef struct {
+    move_t *moves;
+    size_t movescap;
+    char *strs;  // tag names and values
+    size_t strscap;
+    pgn_tag_t tags[PGN_TAGS_MAX];
+} _pgn_buf_t;
+
+static board_t _pgn_start;
+
+__attribute__((constructor)) static void _pgn_init(void) {
+    board_t *start = board_make(STARTING_BOARD);
+    _pgn_start = *start;
+    board_free(start);
+}
+
+static void *_pgn_alloc(size_t size) {
+    void *ret = alloc_malloc(size);
+    if (!ret) {
+        fprintf(stderr, "malloc error in pgn_read\n");
+        exit(EXIT_FAILURE);
+    }
+    return ret;
+}
+
+static inline int _pgn_space(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\f' || c == '\v';
+}
+
+// nonzero if (c) ends a movetext token
+static inline int _pgn_delim(char c) {
+    return _pgn_space(c) || c == '{' || c == '}' || c == '(' || c == ')' || c == ';' || c == '$';
+}
+
+static int _pgn_kind(char c) {
+    switch (c) {
+        case 'N': return WKNIGHT;
+        case 'B': return WBISHOP;
+        case 'R': return WROOK;
+        case 'Q': return WQUEEN;
+        case 'K': return WKING;
+        default: return -1;
+    }
+}
+
+move_t pgn_parse_san(const board_t *board, const char *san, size_t len) {
+    while (len && (san[len - 1] == '+' || san[len - 1] == '#' || san[len - 1] == '!' || san[len - 1] == '?')) {
+        --len;
+    }
+    int kind = WPAWN, promo = -1, fromfile = -1, fromrank = -1, to = -1, castle = -1;
+    if ((len == 3 || len == 5) && (san[0] == 'O' || san[0] == '0')) {
+        for (size_t i = 1; i < len; ++i) {
+            if (san[i] != (i % 2 ? '-' : san[0])) {
+                return 0;
+            }
+        }
+        kind = WKING;
+        castle = len == 3 ? 6 : 2;  // the file the king goes to
+    } else {
+        size_t i = 0, end = len;
+        if (len && _pgn_kind(san[0]) >= 0) {
+            kind = _pgn_kind(san[0]);
+            i = 1;
+        }
+        if (kind == WPAWN && end >= 3) {
+            const char c = san[end - 1];
+            if (san[end - 2] == '=' && _pgn_kind(c >= 'a' ? c - 'a' + 'A' : c) > WPAWN) {
+                promo = _pgn_kind(c >= 'a' ? c - 'a' + 'A' : c);
+                end -= 2;
+            } else if (_pgn_kind(c) > WPAWN) {
+                promo = _pgn_kind(c);
+                end -= 1;
+            }
+        }
+        if (end < i + 2 || san[end - 2] < 'a' || san[end - 2] > 'h' || san[end - 1] < '1' || san[end - 1] > '8') {
+            return 0;
+        }
+        to = POS(san[end - 2], san[end - 1] - '0');
+        for (; i < end - 2; ++i) {
+            if (san[i] >= 'a' && san[i] <= 'h') {
+                fromfile = san[i] - 'a';
+            } else if (san[i] >= '1' && san[i] <= '8') {
+                fromrank = san[i] - '1';
+            } else if (san[i] != 'x' && san[i] != '-' && san[i] != ':') {
+                return 0;
+            }
+        }
+    }
+
+    // the candidates among the pseudo-legal moves, of which exactly one must be legal
+    move_t moves[BOARD_MOVES_MAX];
+    pos_t kingpos;
+    const size_t n = _board_get_pseudo_moves_buf(board, moves, &kingpos);
+    move_t ret = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const move_t move = moves[i];
+        if (MVFROMPC(move) % BPAWN != kind) {
+            continue;
+        }
+        if (castle >= 0) {
+            if (!move_is_castle(move) || MVTOPOS(move) % 8 != castle) {
+                continue;
+            }
+        } else if (MVTOPOS(move) != to || (fromfile >= 0 && MVFROMPOS(move) % 8 != fromfile)
+                   || (fromrank >= 0 && MVFROMPOS(move) / 8 != fromrank)
+                   || (promo < 0 ? MVTOPC(move) != MVFROMPC(move) : MVTOPC(move) % BPAWN != promo)) {
+            continue;
+        }
+        if (!_board_is_legal(board, move, kingpos)) {
+            continue;
+        }
+        if (ret) {
+            return 0;  // ambiguous
+        }
+        ret = move;
+    }
+    return ret;
+}
+
+static inline int _pgn_pc(const board_t *board, int pos) {
+    return (board->ranks[pos / 8] >> ((pos % 8) << 2)) & 0xf;
+}
+
+// nonzero if the piece of kind (kind) on (from) attacks (to), on the board
+static int _pgn_attacks(const board_t *board, int kind, int from, int to) {
+    const int dr = to / 8 - from / 8, df = to % 8 - from % 8;
+    if (kind == WKNIGHT) {
+        return (abs(dr) == 1 && abs(df) == 2) || (abs(dr) == 2 && abs(df) == 1);
+    }
+    const int line = !dr || !df, diagonal = abs(dr) == abs(df);
+    if ((kind == WROOK && !line) || (kind == WBISHOP && !diagonal) || (kind == WQUEEN && !line && !diagonal)) {
+        return 0;
+    }
+    const int step = 8 * ((dr > 0) - (dr < 0)) + (df > 0) - (df < 0);
+    for (int pos = from + step; pos != to; pos += step) {
+        if (_pgn_pc(board, pos) != NOPC) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// writes the SAN of the move, and makes (next) the board after it
+static size_t _pgn_san(const board_t *board, move_t move, char *dest, board_t *next) {
+    static const char kinds[] = "PNBRQK";
+    const int pc = MVFROMPC(move), kind = pc % BPAWN;
+    const int from = MVFROMPOS(move), to = MVTOPOS(move);
+    char *p = dest;
+    const int castle = move_is_castle(move);
+    if (castle) {
+        const char *san = castle == WKCASTLE || castle == BKCASTLE ? "O-O" : "O-O-O";
+        const size_t len = strlen(san);
+        memcpy(p, san, len);
+        p += len;
+    } else if (kind == WPAWN) {
+        if (MVKILLPC(move) != NOPC) {
+            *p++ = 'a' + from % 8;
+            *p++ = 'x';
+        }
+        *p++ = 'a' + to % 8;
+        *p++ = '1' + to / 8;
+        if (MVTOPC(move) != pc) {
+            *p++ = '=';
+            *p++ = kinds[MVTOPC(move) % BPAWN];
+        }
+    } else {
+        *p++ = kinds[kind];
+        if (kind != WKING) {
+            // the other pieces like it that can legally go to the same position
+            const pos_t kingpos = FLAGS_WPLAYER(board->flags) ? FLAGS_WKING(board->flags) : FLAGS_BKING(board->flags);
+            int others = 0, file = 0, rank = 0;
+            for (int pos = 0; pos < 64; ++pos) {
+                if (pos == from || _pgn_pc(board, pos) != pc || !_pgn_attacks(board, kind, pos, to)) {
+                    continue;
+                }
+                const move_t other = MVMAKE(pos, to, MVKILLPOS(move), pc, pc, MVKILLPC(move));
+                if (_board_is_legal(board, other, kingpos)) {
+                    ++others;
+                    file |= pos % 8 == from % 8;
+                    rank |= pos / 8 == from / 8;
+                }
+            }
+            if (others && (!file || rank)) {
+                *p++ = 'a' + from % 8;
+            }
+            if (others && file) {
+                *p++ = '1' + from / 8;
+            }
+        }
+        if (MVKILLPC(move) != NOPC) {
+            *p++ = 'x';
+        }
+        *p++ = 'a' + to % 8;
+        *p++ = '1' + to / 8;
+    }
+
+    *next = *board;
+    board_apply_move(next, move);
+    if (board_in_check(next)) {
+        // mate, unless the opponent has a legal move
+        move_t moves[BOARD_MOVES_MAX];
+        pos_t nextking;
+        const size_t n = _board_get_pseudo_moves_buf(next, moves, &nextking);
+        size_t i = 0;
+        while (i < n && !_board_is_legal(next, moves[i], nextking)) {
+            ++i;
+        }
+        *p++ = i < n ? '+' : '#';
+    }
+    *p = '\0';
+    return p - dest;
+}
+
+size_t pgn_san(const board_t *board, move_t move, char *dest) {
+    board_t next;
+    return _pgn_san(board, move, dest, &next);
+}
+
+size_t pgn_write_moves(const board_t *board, const move_t *moves, size_t len, char *dest) {
+    board_t boards[2] = {*board};
+    char *p = dest;
+    int number = 1;
+    for (size_t i = 0; i < len; ++i) {
+        const board_t *cur = &boards[i & 1];
+        if (i) {
+            *p++ = ' ';
+        }
+        if (FLAGS_WPLAYER(cur->flags)) {
+            p += sprintf(p, "%d. ", number);
+        } else {
+            if (!i) {
+                p += sprintf(p, "%d... ", number);
+            }
+            ++number;
+        }
+        p += _pgn_san(cur, moves[i], p, &boards[~i & 1]);
+    }
+    *p = '\0';
+    return p - dest;
+}
+
+const char *pgn_tag(const pgn_game_t *game, const char *name) {
+    for (size_t i = 0; i < game->ntags; ++i) {
+        if (!strcmp(game->tags[i].name, name)) {
+            return game->tags[i].value;
+        }
+    }
+    return NULL;
+}
+
+// nonzero if a game starts at (p), which starts a line
+static int _pgn_is_start(const char *text, size_t p) {
+    if (text[p] != '[') {
+        return 0;
+    }
+    // the last line before, which is not blank, must not be a tag
+    while (p > 0 && _pgn_space(text[p - 1])) {
+        --p;
+    }
+    if (!p) {
+        return 1;
+    }
+    while (p > 0 && text[p - 1] != '\n') {
+        --p;
+    }
+    return text[p] != '[';
+}
+
+// the first game start from (p) on, or (len) if there is none
+static size_t _pgn_next_start(const char *text, size_t len, size_t p) {
+    if (p && p < len && text[p - 1] != '\n') {
+        const char *nl = (const char *) memchr(&text[p], '\n', len - p);
+        p = nl ? (size_t) (nl - text) + 1 : len;
+    }
+    while (p < len && !_pgn_is_start(text, p)) {
+        const char *nl = (const char *) memchr(&text[p], '\n', len - p);
+        p = nl ? (size_t) (nl - text) + 1 : len;
+    }
+    return p;
+}
+
+static int _pgn_result(const char *s, size_t len) {
+    if (len == 3 && !memcmp(s, "1-0", 3)) {
+        return RESULT_WHITE_WINS;
+    }
+    if (len == 3 && !memcmp(s, "0-1", 3)) {
+        return RESULT_BLACK_WINS;
+    }
+    if (len == 7 && !memcmp(s, "1/2-1/2", 7)) {
+        return RESULT_DRAW;
+    }
+    if (len == 1 && *s == '*') {
+        return RESULT_UNFINISHED;
+    }
+    return -1;
+}
+
+// reads a tag line at (p), before (end), into the buffers; returns the end of the line
+static size_t _pgn_tag_line(const char *text, size_t p, size_t end, _pgn_buf_t *buf, pgn_game_t *game,
+                            char **strs) {
+    const char *nl = (const char *) memchr(&text[p], '\n', end - p);
+    const size_t eol = nl ? (size_t) (nl - text) : end;
+    ++p;
+    while (p < eol && _pgn_space(text[p])) {
+        ++p;
+    }
+    const size_t name = p;
+    while (p < eol && !_pgn_space(text[p]) && text[p] != '"') {
+        ++p;
+    }
+    const size_t namelen = p - name;
+    while (p < eol && text[p] != '"') {
+        ++p;
+    }
+    if (p >= eol || !namelen || game->ntags >= PGN_TAGS_MAX) {
+        return eol;
+    }
+    pgn_tag_t *tag = &buf->tags[game->ntags++];
+    memcpy(*strs, &text[name], namelen);
+    (*strs)[namelen] = '\0';
+    tag->name = *strs;
+    *strs += namelen + 1;
+    tag->value = *strs;
+    for (++p; p < eol && text[p] != '"'; ++p) {
+        if (text[p] == '\\' && p + 1 < eol) {
+            ++p;
+        }
+        *(*strs)++ = text[p];
+    }
+    *(*strs)++ = '\0';
+    return eol;
+}
+
+// sets the starting position of the game from its FEN tag, if any
+static void _pgn_set_start(pgn_game_t *game) {
+    game->start = _pgn_start;
+    const char *fen = pgn_tag(game, "FEN");
+    if (!fen) {
+        return;
+    }
+    // the first four fields, validated, as board_make does not; the move counters are not kept
+    if (!epd_parse(fen, strlen(fen), &game->start)) {
+        game->start = _pgn_start;
+        game->error = 1;
+    }
+}
+
+// reads the game at [p, end) and passes it to the callback
+static void _pgn_game(const _pgn_t *pgn, _pgn_buf_t *buf, size_t p, const size_t end, pgn_stats_t *stats) {
+    const char *text = pgn->text;
+    if (buf->strscap < end - p + 1) {
+        alloc_free(buf->strs);
+        buf->strscap = 2 * (end - p + 1);
+        buf->strs = (char *) _pgn_alloc(buf->strscap);
+    }
+    char *strs = buf->strs;
+    pgn_game_t game;
+    memset(&game, 0, sizeof game);
+    game.offset = p;
+    game.tags = buf->tags;
+    game.moves = buf->moves;
+    game.result = -1;
+    int movetext = 0;  // nonzero once the movetext starts
+    int terminated = 0;
+    board_t board;
+
+    while (p < end && !terminated) {
+        const char c = text[p];
+        if ((p == game.offset || text[p - 1] == '\n') && (c == '[' || c == '%')) {
+            if (c == '[' && !movetext) {
+                p = _pgn_tag_line(text, p, end, buf, &game, &strs);
+            } else {  // escaped lines, and tags in movetext, which cannot be
+                const char *nl = (const char *) memchr(&text[p], '\n', end - p);
+                p = nl ? (size_t) (nl - text) : end;
+            }
+            continue;
+        }
+        if (_pgn_space(c) || c == ')' || c == '}') {
+            ++p;
+            continue;
+        }
+        if (c == '{') {
+            const char *close = (const char *) memchr(&text[p], '}', end - p);
+            p = close ? (size_t) (close - text) + 1 : end;
+            continue;
+        }
+        if (c == ';') {
+            const char *nl = (const char *) memchr(&text[p], '\n', end - p);
+            p = nl ? (size_t) (nl - text) : end;
+            continue;
+        }
+        if (c == '(') {  // variations, which nest
+            int depth = 0;
+            for (; p < end; ++p) {
+                if (text[p] == '{') {
+                    const char *close = (const char *) memchr(&text[p], '}', end - p);
+                    p = close ? (size_t) (close - text) : end - 1;
+                } else if (text[p] == '(') {
+                    ++depth;
+                } else if (text[p] == ')' && !--depth) {
+                    ++p;
+                    break;
+                }
+            }
+            continue;
+        }
+        size_t q = p + 1;
+        while (q < end && !_pgn_delim(text[q])) {
+            ++q;
+        }
+        const char *tok = &text[p];
+        size_t len = q - p;
+        p = q;
+        if (c == '$') {  // numeric annotation glyph
+            while (p < end && text[p] >= '0' && text[p] <= '9') {
+                ++p;
+            }
+            continue;
+        }
+        if (!movetext) {
+            movetext = 1;
+            _pgn_set_start(&game);
+            board = game.start;
+        }
+        const int result = _pgn_result(tok, len);
+        if (result >= 0) {
+            game.result = result;
+            terminated = 1;
+            continue;
+        }
+        if (c >= '0' && c <= '9' && (len < 3 || memcmp(tok, "0-0", 3))) {  // move numbers, e.g., "12." or "12.e4"
+            while (len && ((*tok >= '0' && *tok <= '9') || *tok == '.')) {
+                ++tok;
+                --len;
+            }
+        }
+        while (len && *tok == '.') {
+            ++tok;
+            --len;
+        }
+        if (!len || game.error) {
+            continue;
+        }
+        const move_t move = pgn_parse_san(&board, tok, len);
+        if (!move) {
+            game.error = 1;
+            continue;
+        }
+        if (game.len == buf->movescap) {
+            buf->movescap = buf->movescap ? 2 * buf->movescap : 256;
+            move_t *moves = (move_t *) _pgn_alloc(buf->movescap * sizeof(move_t));
+            memcpy(moves, buf->moves, game.len * sizeof(move_t));
+            alloc_free(buf->moves);
+            buf->moves = moves;
+            game.moves = moves;
+        }
+        buf->moves[game.len++] = move;
+        board_apply_move(&board, move);
+    }
+
+    if (!movetext) {
+        if (!game.ntags) {
+            return;  // nothing but blanks and comments
+        }
+        _pgn_set_start(&game);
+    }
+    if (game.result < 0) {
+        const char *result = pgn_tag(&game, "Result");
+        game.result = result ? _pgn_result(result, strlen(result)) : -1;
+        if (game.result < 0) {
+            game.result = RESULT_UNFINISHED;
+        }
+    }
+    ++stats->games;
+    stats->moves += game.len;
+    stats->errors += !!game.error;
+    pgn->callback(pgn->ctx, &game);
+}
+
+static void *_pgn_worker(void *arg) {
+    _pgn_t *pgn = (_pgn_t *) arg;
+    _pgn_buf_t buf;
+    memset(&buf, 0, sizeof buf);
+    pgn_stats_t stats;
+    memset(&stats, 0, sizeof stats);
+    for (;;) {
+        const size_t chunk = mapfile_pool_next(&pgn->pool);
+        if (chunk == pgn->pool.nchunks) {
+            break;
+        }
+        // the games starting in the chunk, the first game of the text starting at its start
+        const size_t end = chunk + 1 < pgn->pool.nchunks ? (chunk + 1) * PGN_CHUNK : pgn->len;
+        size_t start = chunk ? _pgn_next_start(pgn->text, pgn->len, chunk * PGN_CHUNK) : 0;
+        while (start < end) {
+            const size_t next = _pgn_next_start(pgn->text, pgn->len, start + 1);
+            _pgn_game(pgn, &buf, start, next, &stats);
+            start = next;
+        }
+    }
+
+    pthread_mutex_lock(&pgn->lock);
+    pgn->stats.games += stats.games;
+    pgn->stats.moves += stats.moves;
+    pgn->stats.errors += stats.errors;
+    pthread_mutex_unlock(&pgn->lock);
+    alloc_free(buf.moves);
+    alloc_free(buf.strs);
+    return NULL;
+}
+
+void pgn_read_buf(const char *text, size_t len, int threads, pgn_callback_t callback, void *ctx, pgn_stats_t *stats) {
+    _pgn_t pgn;
+    memset(&pgn, 0, sizeof pgn);
+    pgn.text = text;
+    pgn.len = len;
+    pgn.pool.nchunks = (len + PGN_CHUNK - 1) / PGN_CHUNK;
+    pgn.callback = callback;
+    pgn.ctx = ctx;
+    pthread_mutex_init(&pgn.lock, NULL);
+
+    mapfile_pool_run(&pgn.pool, threads, _pgn_worker, &pgn);
+    pthread_mutex_destroy(&pgn.lock);
+    if (stats) {
+        *stats = pgn.stats;
+    }
+}
+
+int pgn_read(const char *path, int threads, pgn_callback_t callback, void *ctx, pgn_stats_t *stats) {
+    mapfile_t file;
+    if (mapfile_open(path, MAPFILE_SEQUENTIAL, &file)) {  // each chunk is read through once
+        return 1;
+    }
+    pgn_read_buf(file.mem, file.len, threads, callback, ctx, stats);
+    mapfile_close(&file);
+    return 0;
+}
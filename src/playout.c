@@ -0,0 +1,99 @@
+#include <stdlib.h>
+
+#include "playout.h"
+
+#ifndef CHESSLIB_QWORD_MOVE
+#error "playout requires CHESSLIB_QWORD_MOVE"
+#endif
+
+// uniform in [0, n), by multiplication rather than division
+static inline size_t _playout_below(uint64_t *rng, size_t n) {
+    return (size_t) (((playout_rand(rng) >> 32) * n) >> 32);
+}
+
+// nonzero if neither player can mate, as for board_is_stalemate; only called after captures
+static int _playout_insufficient(const board_t *board) {
+    int minors = 0;
+    int bishops[2] = {0, 0};  // square colors of the bishops of each player, plus one
+    for (int rk = 0; rk < 8; ++rk) {
+        uint32_t rank = board->ranks[rk];
+        for (int offs = 0; offs < 8; ++offs, rank >>= 4) {
+            switch (rank & 0xf) {
+                case NOPC:
+                case WKING:
+                case BKING:
+                    break;
+                case WKNIGHT:
+                case BKNIGHT:
+                    ++minors;
+                    bishops[0] = bishops[1] = -1;  // no pair of bishops
+                    break;
+                case WBISHOP:
+                case BBISHOP:
+                    ++minors;
+                    if (!bishops[(rank & 0xf) == BBISHOP]) {
+                        bishops[(rank & 0xf) == BBISHOP] = 1 + ((rk + offs) & 1);
+                    }
+                    break;
+                default:
+                    return 0;  // pawns, rooks and queens
+            }
+        }
+    }
+    return minors <= 1 || (minors == 2 && bishops[0] > 0 && bishops[0] == bishops[1]);
+}
+
+move_t playout_move(const board_t *board, uint64_t *rng, int *incheck) {
+    move_t moves[BOARD_MOVES_MAX];
+    pos_t kingpos;
+    size_t len = _board_get_pseudo_moves_buf(board, moves, &kingpos);
+    while (len) {
+        const size_t i = _playout_below(rng, len);
+        if (_board_is_legal(board, moves[i], kingpos)) {
+            return moves[i];
+        }
+        moves[i] = moves[--len];
+    }
+    if (incheck) {
+        *incheck = _board_hit(board, kingpos / 8, kingpos % 8, FLAGS_BPLAYER(board->flags));
+    }
+    return 0;
+}
+
+int playout(const board_t *board, int maxplies, uint64_t *rng, int *plies) {
+    board_t cur = *board;
+    int halfmoves = 0;
+    int ply = 0;
+    int result = RESULT_UNFINISHED;
+    if (_playout_insufficient(&cur)) {
+        result = RESULT_DRAW;
+        maxplies = 0;
+    }
+    for (; ply < maxplies; ++ply) {
+        if (halfmoves >= 100) {
+            result = RESULT_DRAW;
+            break;
+        }
+        int incheck;
+        const move_t move = playout_move(&cur, rng, &incheck);
+        if (!move) {
+            result = !incheck ? RESULT_DRAW : FLAGS_WPLAYER(cur.flags) ? RESULT_BLACK_WINS : RESULT_WHITE_WINS;
+            break;
+        }
+        board_apply_move(&cur, move);
+        if (MVKILLPC(move) != NOPC) {
+            halfmoves = 0;
+            if (_playout_insufficient(&cur)) {
+                ++ply;
+                result = RESULT_DRAW;
+                break;
+            }
+        } else {
+            halfmoves = MVFROMPC(move) == WPAWN || MVFROMPC(move) == BPAWN ? 0 : halfmoves + 1;
+        }
+    }
+    if (plies) {
+        *plies = ply;
+    }
+    return result;
+}
@@ -17,6 +17,11 @@ UTIL
 
 NOPOS = 64
 NOPC = 12
+PLAYER = 0b10000
+EVAL_PHASE_MAX = 24
+SEARCH_INF = 32000
+BOARD_MOVES_MAX = 64 * (8 + 8) + 8 * 3 * 3  # as in include/board.h
+RESULTS = ['1/2-1/2', '1-0', '0-1', '*']  # as in include/defs.h
 
 STARTING_FEN = 'rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq -'
 _FEN_RK_1_8 = r'[rnbqkRNBQK1-8]+'
@@ -35,7 +40,11 @@ TYPE DEFINITIONS
 
 class BOARD(Structure):
   _fields_ = [("ranks", c_uint*8),
-              ("flags", c_uint)]
+              ("flags", c_uint),
+              ("hash", c_uint64),
+              ("mg", c_int16),
+              ("eg", c_int16),
+              ("phase", c_int16)]
 BOARD_PTR_T = POINTER(BOARD)
 
 class ALST(Structure):
@@ -44,6 +53,27 @@ ALST_PTR_T = POINTER(ALST)
 
 MOVE_T = c_ulonglong
 
+SEARCH_MAX_PLY = 64
+SEARCH_MATE = 31000
+
+class SEARCH_LIMITS(Structure):
+  _fields_ = [("depth", c_int), ("nodes", c_uint64), ("movetime_ms", c_uint64), ("tt", c_void_p),
+              ("threads", c_int), ("stop", POINTER(c_int)), ("softtime_ms", c_uint64)]
+
+class SEARCH_RESULT(Structure):
+  _fields_ = [("best", MOVE_T),
+              ("score", c_int),
+              ("depth", c_int),
+              ("pvlen", c_int),
+              ("pv", MOVE_T*SEARCH_MAX_PLY),
+              ("nodes", c_uint64),
+              ("time_ms", c_uint64)]
+
+BOOK_MOVES_MAX = 64
+
+class BOOK_MOVE(Structure):
+  _fields_ = [("move", MOVE_T), ("weight", c_uint16)]
+
 '''
 PYTHON CLASS WRAPPERS
 '''
@@ -260,6 +290,21 @@ _board_hit_lib = lib._board_hit
 _board_hit_lib.argtypes = [BOARD_PTR_T, c_int, c_int, c_int]
 _board_hit_lib.restype = c_int
 
+search_lib = lib.search
+search_lib.argtypes = [BOARD_PTR_T, POINTER(SEARCH_LIMITS), POINTER(SEARCH_RESULT)]
+search_lib.restype = c_int
+
+search_quiesce_lib = lib.search_quiesce
+search_quiesce_lib.argtypes = [BOARD_PTR_T, c_int, c_int, POINTER(c_uint64)]
+search_quiesce_lib.restype = c_int
+
+
+playout_lib = lib.playout
+playout_lib.argtypes = [BOARD_PTR_T, c_int, POINTER(c_uint64), POINTER(c_int)]
+playout_lib.restype = c_int
+
+_playout_rng = c_uint64(int.from_bytes(os.urandom(8), 'little'))
+
 class Board:
   def __init__(self, board):
     if isinstance(board, Board):
@@ -342,6 +387,78 @@ class Board:
     '''
     return board_is_stalemate_lib(self._board)
 
+  def search(self, depth=0, nodes=0, movetime_ms=0, softtime_ms=0):
+    '''
+    Searches the board natively with iterative deepening alpha-beta search, stopping at the given depth,
+    node count or time, whichever comes first (unspecified limits are not applied); no new iteration is started
+    after softtime_ms milliseconds.
+    Returns the best move (None if there are no legal moves), its score in centipawns from the point of view of
+    the current player, and the principal variation as a list of moves.
+    '''
+    limits = SEARCH_LIMITS(depth, nodes, movetime_ms, None, 1, None, softtime_ms)
+    result = SEARCH_RESULT()
+    if search_lib(self._board, byref(limits), byref(result)):
+      return None, result.score, []
+    return Move(MOVE_T(result.best)), result.score, [Move(MOVE_T(result.pv[i])) for i in range(result.pvlen)]
+
+  def quiesce(self):
+    '''
+    Returns the score of the board in centipawns, from the point of view of the current player, after natively
+    resolving captures and promotions with a quiescence search.
+    '''
+    return search_quiesce_lib(self._board, -SEARCH_INF, SEARCH_INF, None)
+
+  def playout(self, maxplies=1000):
+    '''
+    Plays uniformly random legal moves from the board natively until the game ends or maxplies plies are played,
+    leaving the board unchanged. Returns the result ('1-0', '0-1', '1/2-1/2', or '*' if unfinished) and the
+    number of plies played.
+    '''
+    plies = c_int()
+    result = playout_lib(self._board, maxplies, byref(_playout_rng), byref(plies))
+    return RESULTS[result], plies.value
+
+  def san(self, move):
+    '''
+    Returns the move, a legal move of the board, in standard algebraic notation.
+    '''
+    buf = create_string_buffer(PGN_SAN_CHARS)
+    pgn_san_lib(self._board, move._move, buf)
+    return buf.value.decode()
+
+  def parse_san(self, san):
+    '''
+    Returns the legal move of the board written san in standard algebraic notation, or None if there is none.
+    '''
+    san = san.encode()
+    move = pgn_parse_san_lib(self._board, san, len(san))
+    return Move(MOVE_T(move)) if move else None
+
+  def pack_move(self, move):
+    '''
+    Returns the move packed in 16 bits (see include/move16.h).
+    '''
+    packed = MOVE16_T()
+    move16_pack_lib(byref(move._move), 1, byref(packed))
+    return packed.value
+
+  def unpack_move(self, packed):
+    '''
+    Returns the move packed in 16 bits, played on the board, or None if it cannot be a move of the board.
+    '''
+    move = move16_to_move_lib(self._board, packed)
+    return Move(MOVE_T(move)) if move else None
+
+  def eval(self):
+    '''
+    Returns the static evaluation of the board in centipawns, from the point of view of the current player.
+    Reads the incrementally updated terms of the board, so does not scan it (see eval.h).
+    '''
+    board = self._board.contents
+    phase = min(board.phase, EVAL_PHASE_MAX)
+    score = int((board.mg * phase + board.eg * (EVAL_PHASE_MAX - phase)) / EVAL_PHASE_MAX)
+    return score if board.flags & PLAYER else -score
+
   def to_fen(self):
     '''
     Returns the FEN representation of the board, excluding the halfmove clock and fullmove number;
@@ -392,3 +509,529 @@ alst_free_lib.argtypes = [POINTER(ALST), alst_free_func_type]
 alst_get_lib = lib.alst_get
 alst_get_lib.argtypes = [POINTER(ALST), c_size_t]
 alst_get_lib.restype = c_void_p
+
+'''
+BOOK
+'''
+
+book_load_randoms_lib = lib.book_load_randoms
+book_load_randoms_lib.argtypes = [c_char_p]
+book_load_randoms_lib.restype = c_int
+
+book_open_lib = lib.book_open
+book_open_lib.argtypes = [c_char_p]
+book_open_lib.restype = c_void_p
+
+book_close_lib = lib.book_close
+book_close_lib.argtypes = [c_void_p]
+book_close_lib.restype = None
+
+book_probe_lib = lib.book_probe
+book_probe_lib.argtypes = [c_void_p, BOARD_PTR_T, POINTER(BOOK_MOVE), c_size_t]
+book_probe_lib.restype = c_size_t
+
+class Book:
+  def __init__(self, path):
+    '''
+    Opens a Polyglot opening book (.bin), memory mapped.
+    '''
+    self._book = book_open_lib(path.encode())
+    if not self._book:
+      raise IOError('cannot open book %s' % path)
+
+  def __del__(self):
+    if getattr(self, '_book', None):
+      book_close_lib(self._book)
+
+  @staticmethod
+  def load_randoms(path):
+    '''
+    Overrides the built-in Polyglot random table with one loaded from a file of 781 big-endian 64 bit integers.
+    '''
+    if book_load_randoms_lib(path.encode()):
+      raise IOError('cannot load polyglot randoms from %s' % path)
+
+  def probe(self, board):
+    '''
+    Returns the book moves for the board as a list of (move, weight) pairs, empty if it is out of book.
+    '''
+    moves = (BOOK_MOVE * BOOK_MOVES_MAX)()
+    n = book_probe_lib(self._book, board.board(), moves, BOOK_MOVES_MAX)
+    return [(Move(MOVE_T(moves[i].move)), moves[i].weight) for i in range(n)]
+
+'''
+MCTS
+'''
+
+class MCTS_CONFIG(Structure):
+  _fields_ = [("cpuct", c_float), ("fpu", c_float), ("batch", c_int), ("maxnodes", c_size_t)]
+
+mcts_eval_func_type = CFUNCTYPE(None, c_void_p, c_size_t, BOARD_PTR_T, POINTER(MOVE_T), POINTER(c_uint32),
+                                POINTER(c_float), POINTER(c_float))
+
+mcts_make_lib = lib.mcts_make
+mcts_make_lib.argtypes = [BOARD_PTR_T, POINTER(MCTS_CONFIG)]
+mcts_make_lib.restype = c_void_p
+
+mcts_free_lib = lib.mcts_free
+mcts_free_lib.argtypes = [c_void_p]
+mcts_free_lib.restype = None
+
+mcts_reset_lib = lib.mcts_reset
+mcts_reset_lib.argtypes = [c_void_p, BOARD_PTR_T]
+mcts_reset_lib.restype = None
+
+mcts_search_lib = lib.mcts_search
+mcts_search_lib.argtypes = [c_void_p, c_uint64, mcts_eval_func_type, c_void_p]
+mcts_search_lib.restype = c_uint64
+
+mcts_advance_lib = lib.mcts_advance
+mcts_advance_lib.argtypes = [c_void_p, MOVE_T]
+mcts_advance_lib.restype = c_int
+
+mcts_policy_lib = lib.mcts_policy
+mcts_policy_lib.argtypes = [c_void_p, POINTER(MOVE_T), POINTER(c_uint32)]
+mcts_policy_lib.restype = c_size_t
+
+mcts_best_lib = lib.mcts_best
+mcts_best_lib.argtypes = [c_void_p]
+mcts_best_lib.restype = MOVE_T
+
+mcts_value_lib = lib.mcts_value
+mcts_value_lib.argtypes = [c_void_p]
+mcts_value_lib.restype = c_float
+
+class Mcts:
+  def __init__(self, board, cpuct=0, fpu=0, batch=0, maxnodes=0):
+    '''
+    Makes a Monte Carlo search tree for the board; zeroed settings other than fpu take the library defaults.
+    '''
+    config = MCTS_CONFIG(cpuct, fpu, batch, maxnodes)
+    self._tree = mcts_make_lib(board.board(), byref(config))
+
+  def __del__(self):
+    if getattr(self, '_tree', None):
+      mcts_free_lib(self._tree)
+
+  def reset(self, board):
+    '''
+    Clears the tree, and sets its root to the board.
+    '''
+    mcts_reset_lib(self._tree, board.board())
+
+  def search(self, playouts, evaluate):
+    '''
+    Runs playouts from the root, and returns the number run.
+    evaluate(boards, moves, offsets, priors, values) is called once per batch of leaves with ctypes arrays, which
+    support the buffer protocol (e.g., numpy.frombuffer) and are only valid during the call: for each board i, it
+    must set values[i] to its value in [-1, 1] for the player to move, and priors[offsets[i]:offsets[i + 1]] to the
+    priors of its legal moves moves[offsets[i]:offsets[i + 1]].
+    '''
+    def callback(ctx, n, boards, moves, offsets, priors, values):
+      offs = cast(offsets, POINTER(c_uint32 * (n + 1))).contents
+      evaluate(cast(boards, POINTER(BOARD * n)).contents,
+               cast(moves, POINTER(MOVE_T * offs[n])).contents, offs,
+               cast(priors, POINTER(c_float * offs[n])).contents,
+               cast(values, POINTER(c_float * n)).contents)
+    return mcts_search_lib(self._tree, playouts, mcts_eval_func_type(callback), None)
+
+  def advance(self, move):
+    '''
+    Plays a legal move of the root, keeping its subtree. Returns True if the subtree was kept.
+    '''
+    return not mcts_advance_lib(self._tree, move._move)
+
+  def policy(self):
+    '''
+    Returns the moves of the root and their visits as a list of (move, visits) pairs.
+    '''
+    moves = (MOVE_T * BOARD_MOVES_MAX)()
+    visits = (c_uint32 * BOARD_MOVES_MAX)()
+    n = mcts_policy_lib(self._tree, moves, visits)
+    return [(Move(MOVE_T(moves[i])), visits[i]) for i in range(n)]
+
+  def best(self):
+    '''
+    Returns the most visited move of the root, None if there is none.
+    '''
+    move = mcts_best_lib(self._tree)
+    return Move(MOVE_T(move)) if move else None
+
+  def value(self):
+    '''
+    Returns the mean value of the playouts, in [-1, 1] for the player to move at the root.
+    '''
+    return mcts_value_lib(self._tree)
+
+'''
+FARM
+'''
+
+FARM_POLICIES = {'random': 0, 'weighted': 1, 'search': 2}
+FARM_REASONS = ['mate', 'stalemate', 'material', 'repetition', 'fifty', 'plies']
+
+class FARM_CONFIG(Structure):
+  _fields_ = [("games", c_uint64), ("threads", c_int), ("fen", c_char_p), ("policy", c_int), ("maxplies", c_int),
+              ("openingplies", c_int), ("temperature", c_int), ("depth", c_int), ("nodes", c_uint64),
+              ("ttmb", c_size_t), ("seed", c_uint64), ("pgn", c_int), ("train", c_char_p)]
+
+class FARM_STATS(Structure):
+  _fields_ = [("games", c_uint64), ("plies", c_uint64), ("results", c_uint64*4),
+              ("reasons", c_uint64*len(FARM_REASONS))]
+
+farm_run_lib = lib.farm_run
+farm_run_lib.argtypes = [POINTER(FARM_CONFIG), c_char_p, POINTER(FARM_STATS)]
+farm_run_lib.restype = c_int
+
+def farm(path, games, policy='random', threads=0, fen=None, maxplies=0, openingplies=0, temperature=0, depth=0,
+         nodes=0, ttmb=0, seed=0, pgn=False, train=None):
+  '''
+  Plays self-play games natively on a pool of threads, and writes them to path, one per line: the result, the
+  reason the game ended, and the moves in UCI notation, or in PGN if pgn is set. If train is set, the positions of
+  the games are also written to that path as training records (see TrainRecords). Zeroed settings take the library
+  defaults.
+  Returns the counts of games by result and by reason, and the number of plies played.
+  '''
+  if fen and not epd_parse_lib(fen.encode('ascii'), len(fen), byref(BOARD())):
+    raise ValueError('bad fen %s' % fen)
+  config = FARM_CONFIG(games, threads, fen.encode('ascii') if fen else None, FARM_POLICIES[policy], maxplies,
+                       openingplies, temperature, depth, nodes, ttmb, seed, int(pgn), train.encode() if train else None)
+  stats = FARM_STATS()
+  if farm_run_lib(byref(config), path.encode(), byref(stats)):
+    raise IOError('cannot write %s' % (path if not train else path + ' or ' + train))
+  return {'games': stats.games, 'plies': stats.plies,
+          'results': dict(zip(RESULTS, stats.results)), 'reasons': dict(zip(FARM_REASONS, stats.reasons))}
+
+'''
+NNUE
+'''
+
+NNUE_ACC_SIZE = 2 * 2 * 512  # sizeof(nnue_acc_t)
+
+nnue_load_lib = lib.nnue_load
+nnue_load_lib.argtypes = [c_char_p]
+nnue_load_lib.restype = c_void_p
+
+nnue_free_lib = lib.nnue_free
+nnue_free_lib.argtypes = [c_void_p]
+nnue_free_lib.restype = None
+
+nnue_refresh_lib = lib.nnue_refresh
+nnue_refresh_lib.argtypes = [c_void_p, BOARD_PTR_T, c_void_p]
+nnue_refresh_lib.restype = None
+
+nnue_evaluate_lib = lib.nnue_evaluate
+nnue_evaluate_lib.argtypes = [c_void_p, BOARD_PTR_T, c_void_p]
+nnue_evaluate_lib.restype = c_int
+
+class Nnue:
+  def __init__(self, path):
+    '''
+    Loads a quantised network (see include/nnue.h for the file format).
+    '''
+    self._net = nnue_load_lib(path.encode())
+    if not self._net:
+      raise IOError('cannot load network %s' % path)
+    self._buf = create_string_buffer(NNUE_ACC_SIZE + 32)
+    self._acc = (addressof(self._buf) + 31) & ~31  # accumulators are 32 byte aligned
+
+  def __del__(self):
+    if getattr(self, '_net', None):
+      nnue_free_lib(self._net)
+
+  def evaluate(self, board):
+    '''
+    Returns the evaluation of the board by the network in centipawns, from the point of view of the player to move.
+    '''
+    nnue_refresh_lib(self._net, board.board(), self._acc)
+    return nnue_evaluate_lib(self._net, board.board(), self._acc)
+
+'''
+PGN
+'''
+
+PGN_SAN_CHARS = 8
+
+class PGN_TAG(Structure):
+  _fields_ = [("name", c_char_p), ("value", c_char_p)]
+
+class PGN_GAME(Structure):
+  _fields_ = [("offset", c_size_t), ("tags", POINTER(PGN_TAG)), ("ntags", c_size_t), ("start", BOARD),
+              ("moves", POINTER(MOVE_T)), ("len", c_size_t), ("result", c_int), ("error", c_int)]
+
+class PGN_STATS(Structure):
+  _fields_ = [("games", c_uint64), ("moves", c_uint64), ("errors", c_uint64)]
+
+pgn_callback_func_type = CFUNCTYPE(None, c_void_p, POINTER(PGN_GAME))
+
+pgn_parse_san_lib = lib.pgn_parse_san
+pgn_parse_san_lib.argtypes = [BOARD_PTR_T, c_char_p, c_size_t]
+pgn_parse_san_lib.restype = MOVE_T
+
+pgn_san_lib = lib.pgn_san
+pgn_san_lib.argtypes = [BOARD_PTR_T, MOVE_T, c_char_p]
+pgn_san_lib.restype = c_size_t
+
+pgn_read_lib = lib.pgn_read
+pgn_read_lib.argtypes = [c_char_p, c_int, pgn_callback_func_type, c_void_p, POINTER(PGN_STATS)]
+pgn_read_lib.restype = c_int
+
+def pgn_read(path, threads=0):
+  '''
+  Reads the games of a PGN file natively on a pool of threads, and returns them in the order of the file, as dicts
+  of their tags, starting board, moves, result, and whether a move could not be read (error).
+  '''
+  games = []
+  def collect(ctx, game):  # called on the reading threads, holding the interpreter lock
+    g = game.contents
+    games.append((g.offset, {
+      'tags': {g.tags[i].name.decode(errors='replace'): g.tags[i].value.decode(errors='replace')
+               for i in range(g.ntags)},
+      'start': Board.from_board(pointer(g.start)),
+      'moves': [Move(MOVE_T(g.moves[i])) for i in range(g.len)],
+      'result': RESULTS[g.result],
+      'error': bool(g.error)}))
+  if pgn_read_lib(path.encode(), threads, pgn_callback_func_type(collect), None, None):
+    raise IOError('cannot read %s' % path)
+  games.sort(key=lambda g: g[0])
+  return [g for _, g in games]
+
+'''
+MOVE16
+'''
+
+MOVE16_T = c_uint16
+
+move16_to_move_lib = lib.move16_to_move
+move16_to_move_lib.argtypes = [BOARD_PTR_T, MOVE16_T]
+move16_to_move_lib.restype = MOVE_T
+
+move16_pack_lib = lib.move16_pack
+move16_pack_lib.argtypes = [POINTER(MOVE_T), c_size_t, POINTER(MOVE16_T)]
+move16_pack_lib.restype = None
+
+'''
+EPD
+'''
+
+class EPD_OP(Structure):
+  _fields_ = [("name", c_char_p), ("value", c_char_p)]
+
+class EPD(Structure):
+  _fields_ = [("boards", POINTER(BOARD)), ("len", c_size_t), ("ops", POINTER(EPD_OP)), ("opsidx", POINTER(c_size_t)),
+              ("nops", c_size_t), ("strs", c_void_p), ("errors", c_size_t)]
+
+epd_load_lib = lib.epd_load
+epd_load_lib.argtypes = [c_char_p, c_int]
+epd_load_lib.restype = POINTER(EPD)
+
+epd_free_lib = lib.epd_free
+epd_free_lib.argtypes = [POINTER(EPD)]
+epd_free_lib.restype = None
+
+epd_parse_lib = lib.epd_parse
+epd_parse_lib.argtypes = [c_char_p, c_size_t, BOARD_PTR_T]
+epd_parse_lib.restype = c_size_t
+
+class Epd:
+  '''
+  The positions of an EPD or FEN file, loaded natively on a pool of threads. Indexing gives the board of a position
+  and a dict of its EPD operations.
+  '''
+  def __init__(self, path, threads=0):
+    self._epd = epd_load_lib(path.encode(), threads)
+    if not self._epd:
+      raise IOError('cannot read %s' % path)
+
+  def __del__(self):
+    if getattr(self, '_epd', None):
+      epd_free_lib(self._epd)
+
+  def __len__(self):
+    return self._epd.contents.len
+
+  def __getitem__(self, i):
+    epd = self._epd.contents
+    if not 0 <= i < epd.len:
+      raise IndexError(i)
+    ops = {epd.ops[j].name.decode(errors='replace'): epd.ops[j].value.decode(errors='replace')
+           for j in range(epd.opsidx[i], epd.opsidx[i + 1])}
+    return Board.from_board(pointer(epd.boards[i])), ops
+
+  def errors(self):
+    '''
+    Returns the number of lines that are not positions.
+    '''
+    return self._epd.contents.errors
+
+'''
+ARCHIVE
+'''
+
+class ARCHIVE_GAME(Structure):
+  _fields_ = [("moves", POINTER(MOVE_T)), ("boards", POINTER(BOARD)), ("len", c_size_t), ("result", c_int)]
+
+archive_create_lib = lib.archive_create
+archive_create_lib.argtypes = [c_char_p]
+archive_create_lib.restype = c_void_p
+
+archive_open_lib = lib.archive_open
+archive_open_lib.argtypes = [c_char_p]
+archive_open_lib.restype = c_void_p
+
+archive_write_lib = lib.archive_write
+archive_write_lib.argtypes = [c_void_p, BOARD_PTR_T, POINTER(MOVE_T), c_size_t, c_int]
+archive_write_lib.restype = c_int
+
+archive_read_lib = lib.archive_read
+archive_read_lib.argtypes = [c_void_p, POINTER(ARCHIVE_GAME)]
+archive_read_lib.restype = c_int
+
+archive_close_lib = lib.archive_close
+archive_close_lib.argtypes = [c_void_p]
+archive_close_lib.restype = c_int
+
+def archive_write(path, games):
+  '''
+  Writes the games, dicts of their moves, result (as PGN results) and optionally their starting board (start), to a
+  binary game archive at path.
+  '''
+  archive = archive_create_lib(path.encode())
+  if not archive:
+    raise IOError('cannot write %s' % path)
+  try:
+    for game in games:
+      moves = (MOVE_T * len(game['moves']))(*[m._move for m in game['moves']])
+      start = game['start'].board() if game.get('start') is not None else None
+      if archive_write_lib(archive, start, moves, len(moves), RESULTS.index(game['result'])):
+        raise IOError('cannot write a game to %s' % path)
+  finally:
+    if archive_close_lib(archive):
+      raise IOError('cannot write %s' % path)
+
+def archive_read(path):
+  '''
+  Yields the games of the binary game archive at path, as dicts of their starting board, moves and result.
+  '''
+  archive = archive_open_lib(path.encode())
+  if not archive:
+    raise IOError('cannot read %s' % path)
+  try:
+    game = ARCHIVE_GAME()
+    while True:
+      ret = archive_read_lib(archive, byref(game))
+      if ret < 0:
+        raise IOError('%s is corrupt' % path)
+      if not ret:
+        return
+      yield {'start': Board.from_board(pointer(game.boards[0])),
+             'moves': [Move(MOVE_T(game.moves[i])) for i in range(game.len)],
+             'result': RESULTS[game.result]}
+  finally:
+    archive_close_lib(archive)
+
+'''
+TRAIN
+'''
+
+TRAIN_HEADER = 16
+TRAIN_NO_SCORE = -32768
+
+class TRAIN_RECORD(Structure):
+  _fields_ = [("ranks", c_uint32*8), ("flags", c_uint32), ("score", c_int16), ("move", c_uint16), ("player", c_uint8),
+              ("result", c_uint8), ("ply", c_uint16), ("game", c_uint32)]
+
+class MAPFILE(Structure):
+  _fields_ = [("mem", c_void_p), ("len", c_size_t)]
+
+class TRAIN_FILE(Structure):
+  _fields_ = [("records", POINTER(TRAIN_RECORD)), ("len", c_size_t), ("file", MAPFILE)]
+
+# the NumPy dtype of records, as in include/train.h
+TRAIN_DTYPE = [('ranks', '<u4', (8,)), ('flags', '<u4'), ('score', '<i2'), ('move', '<u2'), ('player', 'u1'),
+               ('result', 'u1'), ('ply', '<u2'), ('game', '<u4')]
+
+train_open_lib = lib.train_open
+train_open_lib.argtypes = [c_char_p]
+train_open_lib.restype = POINTER(TRAIN_FILE)
+
+train_free_lib = lib.train_free
+train_free_lib.argtypes = [POINTER(TRAIN_FILE)]
+train_free_lib.restype = None
+
+train_board_lib = lib.train_board
+train_board_lib.argtypes = [POINTER(TRAIN_RECORD), BOARD_PTR_T, POINTER(MOVE_T)]
+train_board_lib.restype = c_int
+
+def _numpy():
+  try:
+    import numpy
+  except ImportError:
+    raise ImportError('NumPy is required to map training records as arrays; TrainRecords reads them without it')
+  return numpy
+
+def train_array(path):
+  '''
+  Returns the training records of the file at path (see include/train.h) as a read-only NumPy structured array of
+  dtype TRAIN_DTYPE, memory mapped rather than read, so that batches are sliced from it without copying or
+  decoding (e.g., train_array(path)[i:i + 4096]). Requires NumPy.
+  '''
+  np = _numpy()
+  with open(path, 'rb') as f:
+    header = f.read(TRAIN_HEADER)
+  if len(header) < TRAIN_HEADER or header[:4] != b'CLTR' or header[4:12] != bytes([1, 0, 0, 0, 48, 0, 0, 0]):
+    raise IOError('%s is not a file of training records' % path)
+  dtype = np.dtype(TRAIN_DTYPE)
+  n = (os.path.getsize(path) - TRAIN_HEADER) // dtype.itemsize
+  if not n:
+    return np.zeros(0, dtype)
+  return np.memmap(path, dtype, 'r', TRAIN_HEADER, (n,))
+
+def train_pieces(records):
+  '''
+  Returns the pieces of the positions of training records, a NumPy array of them, as an array of shape (n, 64) of
+  uint8, square a1 first, of the piece indices of the library (0-5 white pawn to king, 6-11 black, 12 for none).
+  Requires NumPy.
+  '''
+  np = _numpy()
+  # each little-endian byte of a rank holds two squares, the lower in its low nibble
+  nibbles = np.ascontiguousarray(records['ranks']).view(np.uint8).reshape(-1, 32)
+  return np.stack([nibbles & 0xf, nibbles >> 4], -1).reshape(-1, 64)
+
+class TrainRecords:
+  '''
+  The training records of a file (see include/train.h and farm), memory mapped natively. Indexing gives a dict of
+  the board of a record, the move played from it (None for the last position of a game), its score (None if not
+  scored), the result of its game, its ply and game. array() maps the records as a NumPy array instead.
+  '''
+  def __init__(self, path):
+    self._path = path
+    self._file = train_open_lib(path.encode())
+    if not self._file:
+      raise IOError('cannot read %s' % path)
+
+  def __del__(self):
+    if getattr(self, '_file', None):
+      train_free_lib(self._file)
+
+  def __len__(self):
+    return self._file.contents.len
+
+  def __getitem__(self, i):
+    f = self._file.contents
+    if not 0 <= i < f.len:
+      raise IndexError(i)
+    record = f.records[i]
+    board = BOARD()
+    move = MOVE_T()
+    if train_board_lib(byref(record), byref(board), byref(move)):
+      raise ValueError('record %d does not hold a valid board' % i)
+    return {'board': Board.from_board(pointer(board)), 'move': Move(move) if move.value else None,
+            'score': record.score if record.score != TRAIN_NO_SCORE else None,
+            'result': RESULTS[record.result], 'ply': record.ply, 'game': record.game}
+
+  def array(self):
+    '''
+    Returns the records as a memory mapped NumPy structured array (see train_array). Requires NumPy.
+    '''
+    return train_array(self._path)
@@ -0,0 +1,511 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "search.h"
+#include "order.h"
+
+#ifndef CHESSLIB_QWORD_MOVE
+#error "search requires CHESSLIB_QWORD_MOVE"
+#endif
+
+// moves assumed to be left in the game when budgeting time without a time control
+#define SEARCH_CLOCK_MOVES 30
+
+// factor by which an iteration may overrun the time budgeted for a move
+#define SEARCH_CLOCK_STRETCH 4
+
+// margin for positional gains in quiescence delta pruning, in centipawns
+#define SEARCH_DELTA_MARGIN 200
+
+// relaxed atomic access to state shared between search threads
+#define LOAD(var) __atomic_load_n(&(var), __ATOMIC_RELAXED)
+#define STORE(var, value) __atomic_store_n(&(var), (value), __ATOMIC_RELAXED)
+#define ADD(var, value) __atomic_fetch_add(&(var), (value), __ATOMIC_RELAXED)
+
+// depths skipped by helper threads, so that they spread over the next few iterations of the main thread
+#define SEARCH_SKIP_PATTERNS 20
+static const int _search_skip_size[SEARCH_SKIP_PATTERNS] = {1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4};
+static const int _search_skip_phase[SEARCH_SKIP_PATTERNS] = {0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7};
+
+// state shared by the threads of a search
+typedef struct {
+    const board_t *board;
+    tt_t *tt;  // NULL if none
+    int maxdepth;
+    uint64_t maxnodes;  // 0 if unlimited
+    uint64_t deadline;  // monotonic ns, 0 if unlimited
+    uint64_t softdeadline;  // monotonic ns after which no iteration is started, 0 if unlimited
+    const int *extstop;  // NULL if none
+    int stop;  // set once the main thread is done
+    uint64_t nodes;  // nodes counted so far by all threads, at every node if (maxnodes), else every SEARCH_CHECK_NODES
+} _search_shared_t;
+
+// state of a search thread
+typedef struct {
+    _search_shared_t *shared;
+    tt_t *tt;
+    int id;  // 0 for the main thread
+    int exempt;  // set while limits do not apply (during the first iteration)
+    uint64_t nodes;
+    uint64_t flushed;  // nodes already added to the shared count
+    int stopped;
+    int prevpvlen;  // principal variation of the last completed iteration, searched first
+    move_t prevpv[SEARCH_MAX_PLY];
+    int pvlen[SEARCH_MAX_PLY + 1];  // triangular principal variation table
+    move_t pv[SEARCH_MAX_PLY + 1][SEARCH_MAX_PLY];
+    order_t order;  // killer moves, countermoves and history of this thread
+} _search_t;
+
+static inline uint64_t _search_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// mate scores are stored in the transposition table relative to the node, rather than to the root
+static inline int _search_to_tt(int score, int ply) {
+    return score >= SEARCH_MATE_BOUND ? score + ply : score <= -SEARCH_MATE_BOUND ? score - ply : score;
+}
+
+static inline int _search_from_tt(int score, int ply) {
+    return score >= SEARCH_MATE_BOUND ? score - ply : score <= -SEARCH_MATE_BOUND ? score + ply : score;
+}
+
+// piece values by piece for static exchange evaluation and delta pruning, 0 for NOPC
+static const int _search_see_values[NOPC + 1] = {100, 320, 330, 500, 900, 20000, 100, 320, 330, 500, 900, 20000, 0};
+
+#define SEE_VALUE(pc) (_search_see_values[(pc)])
+
+// returns the position of the least valuable piece of (white) attacking (pos) on (pcs), NOPOS if none
+static int _search_see_attacker(const pc_t *pcs, int pos, int white) {
+    static const int knight[8][2] = {{1, 2}, {2, 1}, {2, -1}, {1, -2}, {-1, -2}, {-2, -1}, {-2, 1}, {-1, 2}};
+    static const int king[8][2] = {{1, 0}, {1, 1}, {0, 1}, {-1, 1}, {-1, 0}, {-1, -1}, {0, -1}, {1, -1}};
+    const int rk = pos / 8;
+    const int offs = pos % 8;
+    const int base = white ? WPAWN : BPAWN;
+    int best = NOPOS;
+    int bestpc = NOPC;
+#define SEE_CONSIDER(r, o, types)                                         \
+    do {                                                                  \
+        const int _pos = POS2((o), (r));                                  \
+        const int _pc = pcs[_pos];                                        \
+        if (_pc != NOPC && _pc >= base && _pc < base + 6                  \
+            && ((types) >> (_pc - base) & 1) && _pc < bestpc) {          \
+            best = _pos;                                                  \
+            bestpc = _pc;                                                 \
+        }                                                                 \
+    } while (0)
+    const int prk = white ? rk - 1 : rk + 1;  // pawns attack forward
+    if (prk >= 0 && prk < 8) {
+        if (offs > 0) SEE_CONSIDER(prk, offs - 1, 1 << WPAWN);
+        if (offs < 7) SEE_CONSIDER(prk, offs + 1, 1 << WPAWN);
+    }
+    if (bestpc != NOPC) {
+        return best;
+    }
+    for (int i = 0; i < 8; ++i) {
+        if (ISPOS2(rk + knight[i][0], offs + knight[i][1])) {
+            SEE_CONSIDER(rk + knight[i][0], offs + knight[i][1], 1 << WKNIGHT);
+        }
+        if (ISPOS2(rk + king[i][0], offs + king[i][1])) {
+            SEE_CONSIDER(rk + king[i][0], offs + king[i][1], 1 << WKING);
+        }
+    }
+    for (int i = 0; i < 8; ++i) {  // sliders, up to the first piece on each ray
+        const int types = (i % 2 ? 1 << WBISHOP : 1 << WROOK) | 1 << WQUEEN;
+        int r = rk + king[i][0];
+        int o = offs + king[i][1];
+        for (; ISPOS2(r, o) && pcs[POS2(o, r)] == NOPC; r += king[i][0], o += king[i][1]);
+        if (ISPOS2(r, o)) {
+            SEE_CONSIDER(r, o, types);
+        }
+    }
+#undef SEE_CONSIDER
+    return best;
+}
+
+int search_see(const board_t *board, move_t move) {
+    pc_t pcs[64];
+    for (int rk = 0; rk < 8; ++rk) {
+        uint32_t rank = board->ranks[rk];
+        for (int offs = 0; offs < 8; ++offs, rank >>= 4) {
+            pcs[POS2(offs, rk)] = rank & 0xf;
+        }
+    }
+    const int topos = MVTOPOS(move);
+    int gain[32];
+    int d = 0;
+    gain[0] = SEE_VALUE(MVKILLPC(move)) + SEE_VALUE(MVTOPC(move)) - SEE_VALUE(MVFROMPC(move));
+    if (MVKILLPC(move) != NOPC) {
+        pcs[MVKILLPOS(move)] = NOPC;
+    }
+    pcs[MVFROMPOS(move)] = NOPC;
+    int occupant = MVTOPC(move);
+    int white = MVTOPC(move) >= BPAWN;  // the side recapturing
+    pcs[topos] = occupant;
+    while (d < 31) {
+        const int from = _search_see_attacker(pcs, topos, white);
+        if (from == NOPOS) {
+            break;
+        }
+        ++d;
+        gain[d] = SEE_VALUE(occupant) - gain[d - 1];  // for the side capturing, if the exchange stopped here
+        occupant = pcs[from];
+        pcs[from] = NOPC;
+        pcs[topos] = occupant;
+        white = !white;
+    }
+    while (d) {  // each side may stop capturing when it is ahead
+        gain[d - 1] = -(-gain[d - 1] > gain[d] ? -gain[d - 1] : gain[d]);
+        --d;
+    }
+    return gain[0];
+}
+
+static inline int _search_stop(_search_t *s) {
+    if (s->stopped) {
+        return 1;
+    }
+    _search_shared_t *shared = s->shared;
+    if (shared->maxnodes) {
+        // each new node takes its place in the count of all threads, and is not searched if the limit is reached
+        if (s->nodes != s->flushed) {
+            if (ADD(shared->nodes, 1) >= shared->maxnodes && !s->exempt) {
+                --s->nodes;
+                s->stopped = 1;
+            }
+            s->flushed = s->nodes;
+        } else if (!s->exempt && LOAD(shared->nodes) >= shared->maxnodes) {
+            s->stopped = 1;
+        }
+    }
+    if (!(s->nodes % SEARCH_CHECK_NODES)) {
+        ADD(shared->nodes, s->nodes - s->flushed);
+        s->flushed = s->nodes;
+        if (!s->exempt && (LOAD(shared->stop) || (shared->extstop && LOAD(*shared->extstop))
+            || (shared->deadline && _search_now() >= shared->deadline))) {
+            s->stopped = 1;
+        }
+    }
+    return s->stopped;
+}
+
+// quiescence search over captures and promotions (all moves when in check)
+static int _search_quiesce(_search_t *s, const board_t *board, int ply, int alpha, int beta) {
+    s->pvlen[ply] = 0;
+    ++s->nodes;
+    if (_search_stop(s)) {
+        return 0;
+    }
+    const int incheck = board_in_check(board);
+    const int standpat = eval_board(board);
+    if (ply >= SEARCH_MAX_PLY) {
+        return standpat;
+    }
+    if (!incheck) {
+        if (standpat >= beta) {
+            return standpat;
+        }
+        if (standpat + SEE_VALUE(WQUEEN) + SEE_VALUE(WQUEEN) - SEE_VALUE(WPAWN) < alpha) {
+            return standpat;  // no capture, even of a queen with a promotion, can raise alpha
+        }
+        if (standpat > alpha) {
+            alpha = standpat;
+        }
+    }
+
+    move_t moves[BOARD_MOVES_MAX];
+    size_t len = board_get_moves_buf(board, moves);
+    if (!len) {
+        return incheck ? -(SEARCH_MATE - ply) : 0;
+    }
+    if (!incheck) {  // keep captures and promotions
+        size_t n = 0;
+        for (size_t i = 0; i < len; ++i) {
+            if (MVKILLPC(moves[i]) != NOPC || MVTOPC(moves[i]) != MVFROMPC(moves[i])) {
+                moves[n++] = moves[i];
+            }
+        }
+        len = n;
+    }
+    order_moves(&s->order, moves, len, 0, 0, ply, 0);
+
+    int best = incheck ? -(SEARCH_MATE - ply) : standpat;
+    for (size_t i = 0; i < len; ++i) {
+        const move_t move = moves[i];
+        if (!incheck) {
+            const int promo = MVTOPC(move) != MVFROMPC(move);
+            // delta pruning: the capture cannot raise alpha, even with a margin for positional gains
+            if (!promo && standpat + SEE_VALUE(MVKILLPC(move)) + SEARCH_DELTA_MARGIN <= alpha) {
+                continue;
+            }
+            // bad capture pruning: the exchange loses material
+            if (SEE_VALUE(MVFROMPC(move)) > SEE_VALUE(MVKILLPC(move)) && search_see(board, move) < 0) {
+                continue;
+            }
+        }
+        board_t child = *board;
+        board_apply_move(&child, move);
+        const int score = -_search_quiesce(s, &child, ply + 1, -beta, -alpha);
+        if (s->stopped) {
+            return 0;
+        }
+        if (score > best) {
+            best = score;
+            if (score > alpha) {
+                alpha = score;
+                if (alpha >= beta) {
+                    break;
+                }
+            }
+        }
+    }
+    return best;
+}
+
+// negamax alpha-beta; (onpv) is set while following the principal variation of the last iteration,
+// and (prev) is the move that led to the board, 0 at the root
+static int _search_node(_search_t *s, const board_t *board, int depth, int ply, int alpha, int beta, int onpv,
+                        move_t prev) {
+    if (depth <= 0 || ply >= SEARCH_MAX_PLY) {
+        return _search_quiesce(s, board, ply, alpha, beta);
+    }
+    s->pvlen[ply] = 0;
+    ++s->nodes;
+    if (_search_stop(s)) {
+        return 0;
+    }
+
+    uint16_t ttmove = 0;
+    tt_hit_t hit;
+    if (s->tt && tt_probe(s->tt, board->hash, &hit)) {
+        ttmove = hit.move;
+        if (ply && hit.depth >= depth) {
+            const int score = _search_from_tt(hit.score, ply);
+            if (hit.bound == TT_EXACT || (hit.bound == TT_LOWER && score >= beta)
+                || (hit.bound == TT_UPPER && score <= alpha)) {
+                return score;
+            }
+        }
+    }
+
+    move_t moves[BOARD_MOVES_MAX];
+    const size_t len = board_get_moves_buf(board, moves);
+    if (!len) {
+        return board_in_check(board) ? -(SEARCH_MATE - ply) : 0;
+    }
+    const move_t pvmove = (onpv && ply < s->prevpvlen) ? s->prevpv[ply] : 0;
+    move_t hashmove = 0;
+    for (size_t i = 0; ttmove && i < len; ++i) {
+        if (TT_MOVE(moves[i]) == ttmove) {
+            hashmove = moves[i];
+            break;
+        }
+    }
+    order_moves(&s->order, moves, len, pvmove, hashmove, ply, prev);
+
+    const int alpha0 = alpha;
+    int best = -SEARCH_INF;
+    move_t bestmove = 0;
+    move_t quiets[BOARD_MOVES_MAX];  // quiet moves searched so far
+    size_t nquiets = 0;
+    for (size_t i = 0; i < len; ++i) {
+        if (order_is_quiet(moves[i])) {
+            quiets[nquiets++] = moves[i];
+        }
+        board_t child = *board;
+        board_apply_move(&child, moves[i]);
+        if (s->tt) {
+            tt_prefetch(s->tt, child.hash);
+        }
+        const int score = -_search_node(s, &child, depth - 1, ply + 1, -beta, -alpha, onpv && moves[i] == pvmove,
+                                        moves[i]);
+        if (s->stopped) {
+            return 0;
+        }
+        if (score > best) {
+            best = score;
+            bestmove = moves[i];
+            if (score > alpha) {
+                alpha = score;
+                // prepend the move to the child's principal variation
+                s->pv[ply][0] = moves[i];
+                memcpy(&s->pv[ply][1], s->pv[ply + 1], s->pvlen[ply + 1] * sizeof(move_t));
+                s->pvlen[ply] = s->pvlen[ply + 1] + 1;
+                if (alpha >= beta) {
+                    order_update(&s->order, moves[i], quiets, nquiets, depth, ply, prev);
+                    break;
+                }
+            }
+        }
+    }
+    if (s->tt) {
+        const int bound = best >= beta ? TT_LOWER : best > alpha0 ? TT_EXACT : TT_UPPER;
+        tt_store(s->tt, board->hash, bound == TT_UPPER ? 0 : bestmove, _search_to_tt(best, ply), depth, bound);
+    }
+    return best;
+}
+
+// iterative deepening, storing the deepest completed iteration into (result)
+static void _search_iterate(_search_t *s, search_result_t *result) {
+    _search_shared_t *shared = s->shared;
+    const int skipsize = _search_skip_size[(s->id + SEARCH_SKIP_PATTERNS - 1) % SEARCH_SKIP_PATTERNS];
+    const int skipphase = _search_skip_phase[(s->id + SEARCH_SKIP_PATTERNS - 1) % SEARCH_SKIP_PATTERNS];
+    for (int depth = 1; depth <= shared->maxdepth; ++depth) {
+        if (s->id && depth > 1 && ((depth + skipphase) / skipsize) % 2) {
+            continue;
+        }
+        s->exempt = depth == 1;  // the first iteration is always completed
+        const int score = _search_node(s, shared->board, depth, 0, -SEARCH_INF, SEARCH_INF, 1, 0);
+        s->exempt = 0;
+        if (s->stopped) {  // discard the partial iteration
+            break;
+        }
+        result->score = score;
+        result->depth = depth;
+        if (s->pvlen[0]) {
+            result->pvlen = s->pvlen[0];
+            memcpy(result->pv, s->pv[0], s->pvlen[0] * sizeof(move_t));
+            result->best = result->pv[0];
+        }
+        s->prevpvlen = result->pvlen;
+        memcpy(s->prevpv, result->pv, result->pvlen * sizeof(move_t));
+        if (abs(score) >= SEARCH_MATE_BOUND) {
+            break;  // a mate found by full-width search is exact
+        }
+        if (_search_stop(s)) {
+            break;
+        }
+        if (shared->deadline || shared->softdeadline) {
+            const uint64_t now = _search_now();
+            if ((shared->deadline && now >= shared->deadline) || (shared->softdeadline && now >= shared->softdeadline)) {
+                break;
+            }
+        }
+    }
+    ADD(shared->nodes, s->nodes - s->flushed);
+    s->flushed = s->nodes;
+    result->nodes = s->nodes;
+}
+
+typedef struct {
+    _search_shared_t *shared;
+    int id;
+    int started;
+    pthread_t thread;
+    search_result_t result;
+} _search_helper_t;
+
+static void _search_init(_search_t *s, _search_shared_t *shared, int id) {
+    s->shared = shared;
+    s->tt = shared->tt;
+    s->id = id;
+    s->exempt = 0;
+    s->nodes = 0;
+    s->flushed = 0;
+    s->stopped = 0;
+    s->prevpvlen = 0;
+    order_clear(&s->order);
+}
+
+static void *_search_helper(void *arg) {
+    _search_helper_t *helper = (_search_helper_t *) arg;
+    _search_t s;
+    _search_init(&s, helper->shared, helper->id);
+    _search_iterate(&s, &helper->result);
+    return NULL;
+}
+
+int search(const board_t *board, const search_limits_t *limits, search_result_t *result) {
+    const uint64_t start = _search_now();
+    _search_shared_t shared;
+    shared.board = board;
+    shared.tt = limits->tt;
+    shared.maxdepth = (limits->depth > 0 && limits->depth < SEARCH_MAX_PLY) ? limits->depth : SEARCH_MAX_PLY - 1;
+    shared.maxnodes = limits->nodes;
+    shared.deadline = limits->movetime_ms ? start + limits->movetime_ms * 1000000 : 0;
+    shared.softdeadline = limits->softtime_ms ? start + limits->softtime_ms * 1000000 : 0;
+    shared.extstop = limits->stop;
+    shared.stop = 0;
+    shared.nodes = 0;
+
+    memset(result, 0, sizeof(search_result_t));
+    move_t moves[BOARD_MOVES_MAX];
+    if (!board_get_moves_buf(board, moves)) {
+        result->score = board_in_check(board) ? -SEARCH_MATE : 0;
+        return 1;
+    }
+    if (shared.tt) {
+        tt_new_search(shared.tt);
+    }
+    result->best = moves[0];  // in case the first iteration finds nothing better
+    result->pv[0] = moves[0];
+    result->pvlen = 1;
+
+    const int nhelpers = limits->threads > 1 ? limits->threads - 1 : 0;
+    _search_helper_t helpers[nhelpers > 0 ? nhelpers : 1];
+    for (int i = 0; i < nhelpers; ++i) {
+        helpers[i].shared = &shared;
+        helpers[i].id = i + 1;
+        helpers[i].result = *result;
+        helpers[i].started = !pthread_create(&helpers[i].thread, NULL, _search_helper, &helpers[i]);
+        if (!helpers[i].started) {
+            fprintf(stderr, "cannot start search thread %d, continuing without it\n", i + 1);
+        }
+    }
+
+    _search_t s;
+    _search_init(&s, &shared, 0);
+    _search_iterate(&s, result);
+    STORE(shared.stop, 1);
+
+    for (int i = 0; i < nhelpers; ++i) {
+        if (!helpers[i].started) {
+            continue;
+        }
+        pthread_join(helpers[i].thread, NULL);
+        result->nodes += helpers[i].result.nodes;
+        if (helpers[i].result.depth > result->depth) {  // a helper completed a deeper iteration
+            const uint64_t nodes = result->nodes;
+            *result = helpers[i].result;
+            result->nodes = nodes;
+        }
+    }
+    result->time_ms = (_search_now() - start) / 1000000;
+    return 0;
+}
+
+int search_quiesce(const board_t *board, int alpha, int beta, uint64_t *nodes) {
+    _search_shared_t shared;
+    memset(&shared, 0, sizeof(_search_shared_t));
+    shared.board = board;
+    _search_t s;
+    _search_init(&s, &shared, 0);
+    s.exempt = 1;
+    const int score = _search_quiesce(&s, board, 0, alpha, beta);
+    if (nodes) {
+        *nodes = s.nodes;
+    }
+    return score;
+}
+
+void search_limits_clock(search_limits_t *limits, uint64_t time_ms, uint64_t inc_ms, int movestogo,
+                         uint64_t overhead_ms) {
+    const uint64_t left = time_ms > overhead_ms ? time_ms - overhead_ms : 1;
+    const uint64_t moves = movestogo > 0 ? (uint64_t) movestogo : SEARCH_CLOCK_MOVES;
+    // an even share of the time left, and most of the increment, to aim for; up to a few times that if
+    // an iteration is under way, but never more than most of the time left (all of it on the last move)
+    uint64_t hard = moves == 1 ? left : left * 4 / 5;
+    uint64_t soft = left / moves + inc_ms * 3 / 4;
+    if (soft * SEARCH_CLOCK_STRETCH < hard) {
+        hard = soft * SEARCH_CLOCK_STRETCH;
+    }
+    if (soft > hard) {
+        soft = hard;
+    }
+    limits->softtime_ms = soft > 0 ? soft : 1;
+    limits->movetime_ms = hard > 0 ? hard : 1;
+}
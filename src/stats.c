@@ -0,0 +1,22 @@
+#include <string.h>
+
+#include "stats.h"
+
+#ifdef CHESSLIB_STATS
+_Thread_local stats_t _stats;
+
+void stats_snapshot(stats_t *dest) {
+    memcpy(dest, &_stats, sizeof(stats_t));
+}
+
+void stats_reset(void) {
+    memset(&_stats, 0, sizeof(stats_t));
+}
+#else
+void stats_snapshot(stats_t *dest) {
+    memset(dest, 0, sizeof(stats_t));
+}
+
+void stats_reset(void) {
+}
+#endif
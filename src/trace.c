@@ -0,0 +1,415 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "trace.h"
+#include "alloc.h"
+#include "eval.h"
+
+static inline void _trace_write32(char *p, uint32_t v) {
+    p[0] = (char) (v & 0xff);
+    p[1] = (char) ((v >> 8) & 0xff);
+    p[2] = (char) ((v >> 16) & 0xff);
+    p[3] = (char) (v >> 24);
+}
+
+static inline uint32_t _trace_read32(const char *p) {
+    const unsigned char *u = (const unsigned char *) p;
+    return (uint32_t) u[0] | (uint32_t) u[1] << 8 | (uint32_t) u[2] << 16 | (uint32_t) u[3] << 24;
+}
+
+#ifdef CHESSLIB_TRACE
+#include <pthread.h>
+
+atomic_int _trace_on = 0;
+_Thread_local int _trace_depth = 0;
+
+static pthread_mutex_t _trace_lock = PTHREAD_MUTEX_INITIALIZER;
+static FILE *_trace_file = NULL;
+
+// bookkeeping below uses libc directly, so that tracing neither shows up in nor trips the library allocator
+
+// open addressing (linear probing) map from live board pointers to ids
+typedef struct {
+    const board_t *board;
+    uint32_t id;
+} _trace_slot_t;
+
+static _trace_slot_t *_trace_slots = NULL;
+static size_t _trace_cap = 0;  // power of two
+static size_t _trace_len = 0;
+
+// ids of freed boards, for reuse
+static uint32_t *_trace_free_ids = NULL;
+static size_t _trace_nfree = 0;
+static size_t _trace_free_cap = 0;
+static uint32_t _trace_next_id = 1;  // 0 is reserved for boards not in the map
+
+static inline size_t _trace_hash(const board_t *board) {
+    return (size_t) (((uint64_t) (uintptr_t) board * 0x9e3779b97f4a7c15ULL) >> 32) & (_trace_cap - 1);
+}
+
+static uint32_t _trace_find(const board_t *board) {
+    if (!_trace_len) {
+        return 0;
+    }
+    for (size_t i = _trace_hash(board); _trace_slots[i].board; i = (i + 1) & (_trace_cap - 1)) {
+        if (_trace_slots[i].board == board) {
+            return _trace_slots[i].id;
+        }
+    }
+    return 0;
+}
+
+static void _trace_put(const board_t *board, uint32_t id) {
+    size_t i = _trace_hash(board);
+    while (_trace_slots[i].board) {
+        i = (i + 1) & (_trace_cap - 1);
+    }
+    _trace_slots[i].board = board;
+    _trace_slots[i].id = id;
+}
+
+static uint32_t _trace_insert(const board_t *board) {
+    if ((_trace_len + 1) * 2 > _trace_cap) {  // keep the load under a half
+        _trace_slot_t *old = _trace_slots;
+        size_t oldcap = _trace_cap;
+        _trace_cap = oldcap ? oldcap * 2 : 1024;
+        _trace_slots = (_trace_slot_t *) calloc(_trace_cap, sizeof(_trace_slot_t));
+        if (!_trace_slots) {
+            fprintf(stderr, "calloc error in _trace_insert\n");
+            exit(EXIT_FAILURE);
+        }
+        for (size_t i = 0; i < oldcap; ++i) {
+            if (old[i].board) {
+                _trace_put(old[i].board, old[i].id);
+            }
+        }
+        free(old);
+    }
+    uint32_t id = _trace_nfree ? _trace_free_ids[--_trace_nfree] : _trace_next_id++;
+    _trace_put(board, id);
+    ++_trace_len;
+    return id;
+}
+
+static uint32_t _trace_remove(const board_t *board) {
+    if (!_trace_len) {
+        return 0;
+    }
+    size_t i = _trace_hash(board);
+    while (_trace_slots[i].board != board) {
+        if (!_trace_slots[i].board) {
+            return 0;
+        }
+        i = (i + 1) & (_trace_cap - 1);
+    }
+    const uint32_t id = _trace_slots[i].id;
+    // shift back following entries that would become unreachable through the hole
+    size_t hole = i;
+    for (size_t j = (i + 1) & (_trace_cap - 1); _trace_slots[j].board; j = (j + 1) & (_trace_cap - 1)) {
+        size_t home = _trace_hash(_trace_slots[j].board);
+        if (((j - home) & (_trace_cap - 1)) >= ((j - hole) & (_trace_cap - 1))) {
+            _trace_slots[hole] = _trace_slots[j];
+            hole = j;
+        }
+    }
+    _trace_slots[hole].board = NULL;
+    --_trace_len;
+
+    if (_trace_nfree == _trace_free_cap) {
+        _trace_free_cap = _trace_free_cap ? _trace_free_cap * 2 : 1024;
+        uint32_t *grown = (uint32_t *) realloc(_trace_free_ids, _trace_free_cap * sizeof(uint32_t));
+        if (!grown) {
+            fprintf(stderr, "realloc error in _trace_remove\n");
+            exit(EXIT_FAILURE);
+        }
+        _trace_free_ids = grown;
+    }
+    _trace_free_ids[_trace_nfree++] = id;
+    return id;
+}
+
+// appends a board reference to a record at (p), returns the new end of the record
+static char *_trace_put_board(char *p, uint32_t id, const board_t *board) {
+    _trace_write32(p, id);
+    p += sizeof id;
+    if (!id) {
+        for (int rk = 0; rk < 8; ++rk) {
+            _trace_write32(&p[4 * rk], board->ranks[rk]);
+        }
+        _trace_write32(&p[32], board->flags);
+        p += TRACE_BOARD;
+    }
+    return p;
+}
+
+void _trace_record(trace_op_t op, const board_t *board, uint64_t arg) {
+    char rec[1 + 2 * (sizeof(uint32_t) + TRACE_BOARD) + sizeof(uint64_t)];
+    char *p = rec;
+    *p++ = (char) op;
+    pthread_mutex_lock(&_trace_lock);
+    if (!_trace_file) {  // stopped since the caller checked
+        pthread_mutex_unlock(&_trace_lock);
+        return;
+    }
+    switch (op) {
+        case TRACE_COPY: {
+            uint32_t id = _trace_insert(board);
+            _trace_write32(p, id);
+            p += sizeof id;
+            const board_t *other = (const board_t *) (uintptr_t) arg;
+            p = _trace_put_board(p, _trace_find(other), other);
+            break;
+        }
+        case TRACE_FREE:
+            p = _trace_put_board(p, _trace_find(board), board);
+            _trace_remove(board);
+            break;
+        case TRACE_APPLY:
+            p = _trace_put_board(p, _trace_find(board), board);
+            _trace_write32(p, (uint32_t) arg);
+            _trace_write32(p + 4, (uint32_t) (arg >> 32));
+            p += sizeof arg;
+            break;
+        default:
+            p = _trace_put_board(p, _trace_find(board), board);
+            break;
+    }
+    fwrite(rec, 1, p - rec, _trace_file);
+    pthread_mutex_unlock(&_trace_lock);
+}
+
+void _trace_record_make(const board_t *board, const char *fen) {
+    char rec[1 + sizeof(uint32_t) + 1 + UINT8_MAX];
+    size_t fenlen = strlen(fen);
+    if (fenlen > UINT8_MAX) {
+        fenlen = UINT8_MAX;
+    }
+    pthread_mutex_lock(&_trace_lock);
+    if (!_trace_file) {
+        pthread_mutex_unlock(&_trace_lock);
+        return;
+    }
+    uint32_t id = _trace_insert(board);
+    rec[0] = (char) TRACE_MAKE;
+    _trace_write32(rec + 1, id);
+    rec[1 + sizeof id] = (char) fenlen;
+    memcpy(rec + 2 + sizeof id, fen, fenlen);
+    fwrite(rec, 1, 2 + sizeof id + fenlen, _trace_file);
+    pthread_mutex_unlock(&_trace_lock);
+}
+
+int trace_start(const char *path) {
+    pthread_mutex_lock(&_trace_lock);
+    if (_trace_file) {
+        pthread_mutex_unlock(&_trace_lock);
+        return 1;
+    }
+    _trace_file = fopen(path, "wb");
+    if (!_trace_file) {
+        pthread_mutex_unlock(&_trace_lock);
+        return 1;
+    }
+    setvbuf(_trace_file, NULL, _IOFBF, 1 << 20);
+    char header[TRACE_HEADER];
+    memcpy(header, TRACE_MAGIC, 8);
+    _trace_write32(&header[8], TRACE_BOARD);
+    fwrite(header, 1, TRACE_HEADER, _trace_file);
+    atomic_store(&_trace_on, 1);
+    pthread_mutex_unlock(&_trace_lock);
+    return 0;
+}
+
+void trace_stop(void) {
+    pthread_mutex_lock(&_trace_lock);
+    if (_trace_file) {
+        atomic_store(&_trace_on, 0);
+        fclose(_trace_file);
+        _trace_file = NULL;
+        free(_trace_slots);
+        free(_trace_free_ids);
+        _trace_slots = NULL;
+        _trace_free_ids = NULL;
+        _trace_cap = _trace_len = _trace_nfree = _trace_free_cap = 0;
+        _trace_next_id = 1;
+    }
+    pthread_mutex_unlock(&_trace_lock);
+}
+
+__attribute__((constructor)) static void _trace_init(void) {
+    const char *path = getenv("CHESSLIB_TRACE_FILE");
+    if (path && *path && trace_start(path)) {
+        fprintf(stderr, "cannot open trace file %s\n", path);
+    }
+}
+
+__attribute__((destructor)) static void _trace_fini(void) {
+    trace_stop();
+}
+#else
+int trace_start(const char *path) {
+    (void) path;
+    return 1;
+}
+
+void trace_stop(void) {
+}
+#endif
+
+// returns the board referenced at (*p) and sets (*id), or returns NULL if the reference is malformed;
+// id 0 boards are read into (scratch), with their hash and evaluation recomputed
+static board_t *_trace_get_board(const char **p, const char *end, board_t **boards, size_t nboards, board_t *scratch,
+        uint32_t *id) {
+    if ((size_t) (end - *p) < sizeof *id) {
+        return NULL;
+    }
+    *id = _trace_read32(*p);
+    *p += sizeof *id;
+    if (*id) {
+        return *id < nboards ? boards[*id] : NULL;
+    }
+    if ((size_t) (end - *p) < TRACE_BOARD) {
+        return NULL;
+    }
+    for (int rk = 0; rk < 8; ++rk) {
+        scratch->ranks[rk] = _trace_read32(&(*p)[4 * rk]);
+    }
+    scratch->flags = _trace_read32(&(*p)[32]);
+    scratch->hash = board_hash(scratch);
+    eval_reset(scratch);
+    *p += TRACE_BOARD;
+    return scratch;
+}
+
+int trace_replay(const char *trace, size_t len, uint64_t counts[TRACE_NOPS]) {
+    memset(counts, 0, TRACE_NOPS * sizeof(uint64_t));
+    if (len < TRACE_HEADER || memcmp(trace, TRACE_MAGIC, 8) || _trace_read32(&trace[8]) != TRACE_BOARD) {
+        return 1;
+    }
+    const char *p = trace + TRACE_HEADER;
+    const char *end = trace + len;
+    board_t **boards = NULL;  // by id
+    size_t nboards = 0;
+    board_t scratch;
+    move_t moves[BOARD_MOVES_MAX];
+    int ret = 1;
+
+    while (p < end) {
+        const trace_op_t op = (trace_op_t) (unsigned char) *p++;
+        board_t *board = NULL;
+        uint32_t id;
+        if (op == TRACE_MAKE || op == TRACE_COPY) {  // new board under the record id
+            if ((size_t) (end - p) < sizeof id) {
+                goto done;
+            }
+            id = _trace_read32(p);
+            p += sizeof id;
+            if (!id || (id < nboards && boards[id])) {
+                goto done;
+            }
+            if (id >= nboards) {
+                size_t cap = nboards ? nboards : 1024;
+                while (cap <= id) {
+                    cap *= 2;
+                }
+                board_t **grown = (board_t **) alloc_calloc(cap, sizeof(board_t *));
+                if (!grown) {
+                    fprintf(stderr, "calloc error in trace_replay\n");
+                    exit(EXIT_FAILURE);
+                }
+                if (boards) {
+                    memcpy(grown, boards, nboards * sizeof(board_t *));
+                    alloc_free(boards);
+                }
+                boards = grown;
+                nboards = cap;
+            }
+            if (op == TRACE_MAKE) {
+                char fen[82];
+                if (p == end) {
+                    goto done;
+                }
+                size_t fenlen = (unsigned char) *p++;
+                if (fenlen >= sizeof fen || (size_t) (end - p) < fenlen) {
+                    goto done;
+                }
+                memcpy(fen, p, fenlen);
+                fen[fenlen] = '\0';
+                p += fenlen;
+                boards[id] = board_make(fen);
+            } else {
+                uint32_t otherid;
+                const board_t *other = _trace_get_board(&p, end, boards, nboards, &scratch, &otherid);
+                if (!other) {
+                    goto done;
+                }
+                boards[id] = board_copy(other);
+            }
+            ++counts[op];
+            continue;
+        }
+
+        if (op >= TRACE_NOPS || !(board = _trace_get_board(&p, end, boards, nboards, &scratch, &id))) {
+            goto done;
+        }
+        switch (op) {
+            case TRACE_FREE:
+                if (id) {  // boards allocated before the trace started are not replayed
+                    board_free(board);
+                    boards[id] = NULL;
+                }
+                break;
+            case TRACE_APPLY: {
+                uint64_t mv;
+                if ((size_t) (end - p) < sizeof mv) {
+                    goto done;
+                }
+                mv = (uint64_t) _trace_read32(p) | (uint64_t) _trace_read32(p + 4) << 32;
+                p += sizeof mv;
+#ifdef CHESSLIB_QWORD_MOVE
+                board_apply_move(board, mv);
+#else
+                move_t move = {(pos_t) (mv & 0xff), (pos_t) ((mv >> 8) & 0xff), (pos_t) ((mv >> 16) & 0xff),
+                    (pc_t) ((mv >> 24) & 0xff), (pc_t) ((mv >> 32) & 0xff), (pc_t) ((mv >> 40) & 0xff)};
+                board_apply_move(board, &move);
+#endif
+                break;
+            }
+            case TRACE_GET_MOVES: {
+                alst_t *list = board_get_moves(board);
+#ifdef CHESSLIB_QWORD_MOVE
+                alst_free(list, NULL);
+#else
+                alst_free(list, (void (*) (void *)) move_free);
+#endif
+                break;
+            }
+            case TRACE_GET_MOVES_BUF:
+                board_get_moves_buf(board, moves);
+                break;
+            case TRACE_IS_MATE:
+                board_is_mate(board);
+                break;
+            case TRACE_IS_STALEMATE:
+                board_is_stalemate(board);
+                break;
+            case TRACE_TO_FEN:
+                board_to_fen(board);
+                break;
+            default:
+                goto done;
+        }
+        ++counts[op];
+    }
+    ret = 0;
+
+done:
+    for (size_t i = 1; i < nboards; ++i) {
+        if (boards[i]) {
+            board_free(boards[i]);
+        }
+    }
+    alloc_free(boards);
+    return ret;
+}
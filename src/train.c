@@ -0,0 +1,144 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "train.h"
+#include "alloc.h"
+#include "eval.h"
+
+#ifndef CHESSLIB_QWORD_MOVE
+#error "train requires CHESSLIB_QWORD_MOVE"
+#endif
+
+#define TRAIN_RECORD 48
+
+_Static_assert(sizeof(train_record_t) == TRAIN_RECORD, "train_record_t is not packed as the records of files");
+
+static inline void _train_write16(uint8_t *p, uint16_t v) {
+    p[0] = v & 0xff;
+    p[1] = v >> 8;
+}
+
+static inline void _train_write32(uint8_t *p, uint32_t v) {
+    p[0] = v & 0xff;
+    p[1] = (v >> 8) & 0xff;
+    p[2] = (v >> 16) & 0xff;
+    p[3] = v >> 24;
+}
+
+static inline uint32_t _train_read32(const uint8_t *p) {
+    return (uint32_t) p[0] | (uint32_t) p[1] << 8 | (uint32_t) p[2] << 16 | (uint32_t) p[3] << 24;
+}
+
+train_writer_t *train_create(const char *path) {
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        return NULL;
+    }
+    train_writer_t *ret = (train_writer_t *) alloc_calloc(1, sizeof(train_writer_t));
+    uint8_t *buf = (uint8_t *) alloc_malloc(TRAIN_BUFFER);
+    if (!ret || !buf) {
+        fprintf(stderr, "malloc error in train_create\n");
+        exit(EXIT_FAILURE);
+    }
+    ret->file = file;
+    ret->buf = buf;
+    memcpy(buf, "CLTR", 4);
+    _train_write32(&buf[4], TRAIN_VERSION);
+    _train_write32(&buf[8], TRAIN_RECORD);
+    _train_write32(&buf[12], 0);
+    ret->len = TRAIN_HEADER;
+    return ret;
+}
+
+static int _train_flush(train_writer_t *writer) {
+    if (writer->len && fwrite(writer->buf, 1, writer->len, writer->file) != writer->len) {
+        writer->error = 1;
+    }
+    writer->len = 0;
+    return writer->error;
+}
+
+int train_write(train_writer_t *writer, const board_t *board, move_t move, int score, int result, uint32_t game,
+                int ply) {
+    if (writer->len + TRAIN_RECORD > TRAIN_BUFFER && _train_flush(writer)) {
+        return writer->error;
+    }
+    uint8_t *p = &writer->buf[writer->len];
+    for (int rk = 0; rk < 8; ++rk) {
+        _train_write32(&p[4 * rk], board->ranks[rk]);
+    }
+    _train_write32(&p[32], board->flags);
+    score = score == TRAIN_NO_SCORE ? score : score < INT16_MIN + 1 ? INT16_MIN + 1
+          : score > INT16_MAX ? INT16_MAX : score;
+    _train_write16(&p[36], (uint16_t) (int16_t) score);
+    _train_write16(&p[38], move ? move16_make(move) : 0);
+    p[40] = FLAGS_BPLAYER(board->flags) != 0;
+    p[41] = (uint8_t) result;
+    _train_write16(&p[42], (uint16_t) ply);
+    _train_write32(&p[44], game);
+    writer->len += TRAIN_RECORD;
+    return writer->error;
+}
+
+int train_write_game(train_writer_t *writer, const board_t *start, const move_t *moves, const int *scores,
+                     size_t len, int result, uint32_t game) {
+    board_t board = *start;
+    for (size_t i = 0; i < len; ++i) {
+        train_write(writer, &board, moves[i], scores ? scores[i] : TRAIN_NO_SCORE, result, game, i);
+        board_apply_move(&board, moves[i]);
+    }
+    return train_write(writer, &board, 0, TRAIN_NO_SCORE, result, game, len);
+}
+
+int train_close(train_writer_t *writer) {
+    _train_flush(writer);
+    if (fclose(writer->file)) {
+        writer->error = 1;
+    }
+    const int ret = writer->error;
+    alloc_free(writer->buf);
+    alloc_free(writer);
+    return ret;
+}
+
+train_file_t *train_open(const char *path) {
+    mapfile_t file;
+    if (mapfile_open(path, MAPFILE_NORMAL, &file)) {
+        return NULL;
+    }
+    const uint8_t *header = (const uint8_t *) file.mem;
+    if (file.len < TRAIN_HEADER || memcmp(header, "CLTR", 4) || _train_read32(&header[4]) != TRAIN_VERSION
+        || _train_read32(&header[8]) != TRAIN_RECORD) {
+        mapfile_close(&file);
+        return NULL;
+    }
+    train_file_t *ret = (train_file_t *) alloc_malloc(sizeof(train_file_t));
+    if (!ret) {
+        fprintf(stderr, "malloc error in train_open\n");
+        exit(EXIT_FAILURE);
+    }
+    ret->records = (const train_record_t *) (header + TRAIN_HEADER);
+    ret->len = (file.len - TRAIN_HEADER) / TRAIN_RECORD;  // a record cut short is not one
+    ret->file = file;
+    return ret;
+}
+
+void train_free(train_file_t *file) {
+    if (file) {
+        mapfile_close(&file->file);
+        alloc_free(file);
+    }
+}
+
+int train_board(const train_record_t *record, board_t *dest, move_t *move) {
+    memcpy(dest->ranks, record->ranks, sizeof dest->ranks);
+    dest->flags = record->flags;
+    if (!board_is_valid(dest)) {
+        return -1;
+    }
+    dest->hash = board_hash(dest);
+    eval_reset(dest);
+    *move = record->move ? move16_to_move(dest, record->move) : 0;
+    return 0;
+}
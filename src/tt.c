@@ -0,0 +1,160 @@
+#define _DEFAULT_SOURCE  // MAP_ANONYMOUS, MAP_HUGETLB, madvise
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#ifdef __unix__
+#include <sys/mman.h>
+#endif
+
+#include "tt.h"
+#include "alloc.h"
+
+#ifndef CHESSLIB_QWORD_MOVE
+#error "tt requires CHESSLIB_QWORD_MOVE"
+#endif
+
+#define HUGEPAGE_SIZE (2UL << 20)
+
+// data word: move (16b), score (16b), depth (8b), bound (2b), generation (6b), 16b unused
+#define DATA_MAKE(move, score, depth, bound, gen) \
+    ((uint64_t) (move) | ((uint64_t) (uint16_t) (score) << 16) | ((uint64_t) (depth) << 32) \
+    | ((uint64_t) (bound) << 40) | ((uint64_t) ((gen) & 0x3f) << 42))
+#define DATA_MOVE(data)  ((uint16_t) ((data) & 0xffff))
+#define DATA_SCORE(data) ((int16_t) (((data) >> 16) & 0xffff))
+#define DATA_DEPTH(data) ((uint8_t) (((data) >> 32) & 0xff))
+#define DATA_BOUND(data) ((uint8_t) (((data) >> 40) & 0x3))
+#define DATA_GEN(data)   ((uint8_t) (((data) >> 42) & 0x3f))
+
+// relaxed, untorn loads and stores of the two words of an entry
+#define LOAD(word) __atomic_load_n(&(word), __ATOMIC_RELAXED)
+#define STORE(word, value) __atomic_store_n(&(word), (value), __ATOMIC_RELAXED)
+
+tt_t *tt_make(size_t mb, int hugepages) {
+    tt_t *ret = (tt_t *) alloc_calloc(1, sizeof(tt_t));
+    if (!ret) {
+        fprintf(stderr, "calloc error in tt_make\n");
+        exit(EXIT_FAILURE);
+    }
+    size_t nbuckets = 1;
+    while (nbuckets * 2 * sizeof(tt_bucket_t) <= (mb << 20)) {
+        nbuckets *= 2;
+    }
+    ret->mask = nbuckets - 1;
+    ret->bytes = nbuckets * sizeof(tt_bucket_t);
+
+#ifdef __unix__
+    // mapped memory is page aligned, zeroed, and committed lazily
+#ifdef MAP_HUGETLB
+    if (hugepages && !(ret->bytes % HUGEPAGE_SIZE)) {
+        ret->mem = mmap(NULL, ret->bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (ret->mem == MAP_FAILED) {  // none reserved, fall back to regular pages
+            ret->mem = NULL;
+        } else {
+            ret->hugepages = 1;
+        }
+    }
+#endif
+    if (!ret->mem) {
+        ret->mem = mmap(NULL, ret->bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (ret->mem == MAP_FAILED) {
+            fprintf(stderr, "mmap error in tt_make\n");
+            exit(EXIT_FAILURE);
+        }
+#ifdef MADV_HUGEPAGE
+        if (hugepages) {
+            madvise(ret->mem, ret->bytes, MADV_HUGEPAGE);
+        }
+#endif
+    }
+    ret->mapped = 1;
+    ret->buckets = (tt_bucket_t *) ret->mem;
+#else
+    (void) hugepages;
+    ret->mem = alloc_calloc(1, ret->bytes + sizeof(tt_bucket_t));
+    if (!ret->mem) {
+        fprintf(stderr, "calloc error in tt_make\n");
+        exit(EXIT_FAILURE);
+    }
+    ret->buckets = (tt_bucket_t *) (((uintptr_t) ret->mem + sizeof(tt_bucket_t) - 1) & ~(uintptr_t) (sizeof(tt_bucket_t) - 1));
+#endif
+    return ret;
+}
+
+void tt_free(tt_t *tt) {
+#ifdef __unix__
+    if (tt->mapped) {
+        munmap(tt->mem, tt->bytes);
+    }
+#else
+    alloc_free(tt->mem);
+#endif
+    alloc_free(tt);
+}
+
+void tt_clear(tt_t *tt) {
+    memset(tt->buckets, 0, tt->bytes);
+    tt->gen = 0;
+}
+
+void tt_new_search(tt_t *tt) {
+    tt->gen = (tt->gen + 1) & 0x3f;
+}
+
+int tt_probe(const tt_t *tt, uint64_t hash, tt_hit_t *hit) {
+    const tt_entry_t *entries = tt->buckets[hash & tt->mask].entries;
+    for (int i = 0; i < TT_BUCKET; ++i) {
+        const uint64_t data = LOAD(entries[i].data);
+        if ((LOAD(entries[i].key) ^ data) == hash && DATA_BOUND(data) != TT_NONE) {
+            hit->move = DATA_MOVE(data);
+            hit->score = DATA_SCORE(data);
+            hit->depth = DATA_DEPTH(data);
+            hit->bound = DATA_BOUND(data);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void tt_store(tt_t *tt, uint64_t hash, move_t move, int score, int depth, int bound) {
+    tt_entry_t *entries = tt->buckets[hash & tt->mask].entries;
+    tt_entry_t *victim = NULL;
+    uint16_t mv = move ? TT_MOVE(move) : 0;
+    int worst = 1 << 30;
+    for (int i = 0; i < TT_BUCKET; ++i) {
+        const uint64_t data = LOAD(entries[i].data);
+        if ((LOAD(entries[i].key) ^ data) == hash) {  // same position
+            if (!mv) {
+                mv = DATA_MOVE(data);
+            }
+            victim = &entries[i];
+            break;
+        }
+        const int value = DATA_BOUND(data) == TT_NONE ? -(1 << 30)
+            : DATA_DEPTH(data) - 8 * ((tt->gen - DATA_GEN(data)) & 0x3f);
+        if (value < worst) {
+            worst = value;
+            victim = &entries[i];
+        }
+    }
+    if (score > INT16_MAX) {
+        score = INT16_MAX;
+    } else if (score < INT16_MIN) {
+        score = INT16_MIN;
+    }
+    depth = depth < 0 ? 0 : depth > 255 ? 255 : depth;
+    const uint64_t data = DATA_MAKE(mv, score, depth, bound, tt->gen);
+    STORE(victim->data, data);
+    STORE(victim->key, hash ^ data);
+}
+
+int tt_hashfull(const tt_t *tt) {
+    int used = 0;
+    int total = 0;
+    for (uint64_t b = 0; b <= tt->mask && total < 1000; ++b) {
+        for (int i = 0; i < TT_BUCKET; ++i, ++total) {
+            const uint64_t data = LOAD(tt->buckets[b].entries[i].data);
+            used += DATA_BOUND(data) != TT_NONE && DATA_GEN(data) == tt->gen;
+        }
+    }
+    return used * 1000 / total;
+}
@@ -0,0 +1,150 @@
+extern "C" {
+#include "defs.h"
+#include "board.h"
+#include "alloc.h"
+#include "perft.h"
+}
+
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <vector>
+
+#define FEN_KIWIPETE "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -"
+
+static uint64_t counted_mallocs = 0;
+static uint64_t counted_frees = 0;
+
+static void *countingMalloc(size_t size) {
+    ++counted_mallocs;
+    return malloc(size);
+}
+
+static void *countingCalloc(size_t n, size_t size) {
+    ++counted_mallocs;
+    return calloc(n, size);
+}
+
+static void countingFree(void *ptr) {
+    ++counted_frees;
+    free(ptr);
+}
+
+// a search that only uses the non-allocating api
+static uint64_t search(const board_t *board, int depth) {
+    if (depth <= 0) {
+        return 1;
+    }
+    move_t moves[BOARD_MOVES_MAX];
+    size_t len = board_get_moves_buf(board, moves);
+    uint64_t ct = 0;
+    for (size_t i = 0; i < len; ++i) {
+        board_t future = *board;
+#ifdef CHESSLIB_QWORD_MOVE
+        board_apply_move(&future, moves[i]);
+#else
+        board_apply_move(&future, &moves[i]);
+#endif
+        if (board_is_mate(&future) || board_is_stalemate(&future)) {
+            continue;
+        }
+        ct += search(&future, depth - 1);
+    }
+    return ct;
+}
+
+TEST(AllocTest, Counters) {
+    alloc_stats_t stats;
+    alloc_reset_stats();
+    board_t *b = board_make(STARTING_BOARD);
+    board_t *c = board_copy(b);
+    alloc_stats(&stats);
+    EXPECT_EQ(stats.allocs, 2u);
+    EXPECT_EQ(stats.frees, 0u);
+    EXPECT_EQ(stats.bytes, 2 * sizeof(board_t));
+
+    alst_t *moves = board_get_moves(b);
+    EXPECT_EQ(moves->len, 20u);
+#ifdef CHESSLIB_QWORD_MOVE
+    alst_free(moves, NULL);
+#else
+    alst_free(moves, (void (*) (void *)) move_free);
+#endif
+    board_free(b);
+    board_free(c);
+    alloc_stats(&stats);
+    EXPECT_EQ(stats.allocs, stats.frees);
+}
+
+TEST(AllocTest, ListGrowth) {
+    alloc_stats_t stats;
+    alst_t *list = alst_make(10);
+    alloc_reset_stats();
+    for (size_t i = 0; i < 11; ++i) {
+        alst_append(list, (void *) i);
+    }
+    alloc_stats(&stats);
+    EXPECT_EQ(stats.allocs, 1u);  // grown once
+    EXPECT_EQ(stats.frees, 1u);  // old array
+    EXPECT_EQ(stats.bytes, 100 * sizeof(void *));
+    alst_free(list, NULL);
+}
+
+TEST(AllocTest, CustomAllocator) {
+    const alloc_t counting = {countingMalloc, countingCalloc, countingFree};
+    alloc_set(&counting);
+    counted_mallocs = 0;
+    counted_frees = 0;
+
+    board_t *b = board_make(STARTING_BOARD);
+    alst_t *moves = board_get_moves(b);
+#ifdef CHESSLIB_QWORD_MOVE
+    alst_free(moves, NULL);
+#else
+    alst_free(moves, (void (*) (void *)) move_free);
+#endif
+    board_free(b);
+    alloc_set(NULL);
+
+    EXPECT_GT(counted_mallocs, 0u);
+    EXPECT_EQ(counted_mallocs, counted_frees);
+}
+
+TEST(AllocTest, ZeroAllocSearch) {
+    board_t *b = board_make(FEN_KIWIPETE);
+    alloc_stats_t stats;
+    alloc_reset_stats();
+    alloc_forbid(1);  // any allocation below fails the test by exiting
+    EXPECT_EQ(perft_count(b, 3), 97862u);
+    EXPECT_GT(search(b, 2), 0u);
+    alloc_forbid(0);
+    alloc_stats(&stats);
+    EXPECT_EQ(stats.allocs, 0u);
+    board_free(b);
+}
+
+TEST(AllocTest, ForbiddenAllocationExits) {
+    EXPECT_EXIT({
+        alloc_forbid(1);
+        board_t *b = board_make(STARTING_BOARD);
+        board_free(b);
+    }, ::testing::ExitedWithCode(EXIT_FAILURE), "allocations are forbidden");
+}
+
+TEST(AllocTest, MovesBufferBound) {
+    // a board with more pseudo-legal moves than any legal position has legal moves
+    board_t *b = board_make("kQQQQQQQ/QQ5Q/Q6Q/Q6Q/Q6Q/Q6Q/Q6Q/QQQQQQQK w - -");
+    std::vector<move_t> moves(BOARD_MOVES_MAX + 1, 0);
+    pos_t kingpos;
+    const size_t pseudo = _board_get_pseudo_moves_buf(b, moves.data(), &kingpos);
+    EXPECT_GT(pseudo, 256u);
+    EXPECT_LE(pseudo, (size_t) BOARD_MOVES_MAX);
+    EXPECT_EQ(kingpos, POS('h', 1));
+    EXPECT_EQ(moves[BOARD_MOVES_MAX], 0u);
+
+    const size_t len = board_get_moves_buf(b, moves.data());
+    alst_t *list = board_get_moves(b);
+    EXPECT_EQ(list->len, len);
+    EXPECT_EQ(moves[BOARD_MOVES_MAX], 0u);
+    alst_free(list, NULL);
+    board_free(b);
+}
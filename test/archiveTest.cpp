@@ -0,0 +1,232 @@
+extern "C" {
+#include "defs.h"
+#include "board.h"
+#include "move.h"
+#include "archive.h"
+}
+#include "testutil.h"
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+// positions with castles, en passant and promotions at hand
+static const char *fens[] = {
+    "r3k2r/8/8/8/8/8/8/R3K2R w KQkq -",
+    "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6",
+    "4k3/1P6/8/8/8/8/6p1/4K3 w - -",
+    "8/2P1k3/8/8/8/8/3Kp3/8 b - -",
+};
+
+struct Game {
+    board_t start;
+    int fromstart;
+    vector<move_t> moves;
+    int result;
+};
+
+// plays random legal moves from the board until there are none, or for (plies) plies
+static Game play(const board_t *start, uint64_t &state, size_t plies) {
+    Game ret;
+    ret.fromstart = start == NULL;
+    ret.start = start ? *start : fen_board(STARTING_BOARD);
+    ret.moves = random_game(ret.start, plies, state);
+    ret.result = (int) (state >> 40) % 4;
+    return ret;
+}
+
+class ArchiveTest : public ::testing::Test {
+    protected:
+        void SetUp() override {
+            file = temp_file("archive");
+        }
+
+        void TearDown() override {
+            unlink(file.c_str());
+        }
+
+        void write(const vector<Game> &games) {
+            archive_t *archive = archive_create(file.c_str());
+            ASSERT_NE(archive, nullptr);
+            for (const Game &g : games) {
+                ASSERT_EQ(archive_write(archive, g.fromstart ? NULL : &g.start, g.moves.data(), g.moves.size(),
+                    g.result), 0);
+            }
+            ASSERT_EQ(archive_close(archive), 0);
+        }
+
+        string file;
+};
+
+TEST_F(ArchiveTest, RoundTrip) {
+    uint64_t state = 42;
+    vector<Game> games;
+    for (int i = 0; i < 200; ++i) {
+        if (i % 2) {
+            board_t *b = board_make(fens[i / 2 % 4]);
+            games.push_back(play(b, state, 100));
+            board_free(b);
+        } else {
+            games.push_back(play(NULL, state, 300));
+        }
+    }
+    games.push_back(play(NULL, state, 0));
+    write(games);
+
+    archive_t *archive = archive_open(file.c_str());
+    ASSERT_NE(archive, nullptr);
+    archive_game_t game;
+    for (const Game &g : games) {
+        ASSERT_EQ(archive_read(archive, &game), 1);
+        ASSERT_EQ(game.len, g.moves.size());
+        EXPECT_EQ(game.result, g.result);
+        const vector<board_t> boards = game_boards(g.start, g.moves);
+        for (size_t i = 0; i < game.len; ++i) {
+            ASSERT_EQ(game.moves[i], g.moves[i]);
+        }
+        for (size_t i = 0; i <= game.len; ++i) {
+            EXPECT_TRUE(same_board(game.boards[i], boards[i])) << i;
+        }
+    }
+    EXPECT_EQ(archive_read(archive, &game), 0);
+    EXPECT_EQ(archive_read(archive, &game), 0);
+    EXPECT_EQ(archive_close(archive), 0);
+}
+
+TEST_F(ArchiveTest, Size) {
+    uint64_t state = 7;
+    vector<Game> games;
+    size_t plies = 0;
+    for (int i = 0; i < 100; ++i) {
+        games.push_back(play(NULL, state, 200));
+        plies += games.back().moves.size();
+    }
+    write(games);
+    FILE *f = fopen(file.c_str(), "rb");
+    ASSERT_NE(f, nullptr);
+    fseek(f, 0, SEEK_END);
+    // a byte per ply, and a header per game and per archive
+    EXPECT_EQ((size_t) ftell(f), 8 + 4 * games.size() + plies);
+    fclose(f);
+}
+
+TEST_F(ArchiveTest, Errors) {
+    // an empty archive
+    write(vector<Game>());
+    archive_t *archive = archive_open(file.c_str());
+    ASSERT_NE(archive, nullptr);
+    archive_game_t game;
+    EXPECT_EQ(archive_read(archive, &game), 0);
+    archive_close(archive);
+
+    // a move that is not legal is not written
+    archive = archive_create(file.c_str());
+    ASSERT_NE(archive, nullptr);
+    const move_t bad = MVMAKE(POS('e', 2), POS('e', 5), POS('e', 5), WPAWN, WPAWN, NOPC);
+    EXPECT_NE(archive_write(archive, NULL, &bad, 1, 0), 0);
+    uint64_t state = 1;
+    Game g = play(NULL, state, 20);
+    EXPECT_EQ(archive_write(archive, NULL, g.moves.data(), g.moves.size(), g.result), 0);
+    EXPECT_EQ(archive_close(archive), 0);
+
+    archive = archive_open(file.c_str());
+    ASSERT_NE(archive, nullptr);
+    ASSERT_EQ(archive_read(archive, &game), 1);
+    EXPECT_EQ(game.len, g.moves.size());
+    EXPECT_EQ(archive_read(archive, &game), 0);
+    archive_close(archive);
+
+    // an archive cut short
+    ASSERT_EQ(truncate(file.c_str(), 8 + 4 + g.moves.size() - 1), 0);
+    archive = archive_open(file.c_str());
+    ASSERT_NE(archive, nullptr);
+    EXPECT_EQ(archive_read(archive, &game), -1);
+    archive_close(archive);
+
+    // a start board that is not valid: a piece beyond NOPC, a second white king, a king away from its flags
+    const board_t start = fen_board(fens[2]);
+    for (int corrupt = 0; corrupt < 4; ++corrupt) {
+        write({Game{start, 0, {}, RESULT_DRAW}});
+        board_t bad = start;
+        if (corrupt == 1) {
+            bad.ranks[4] = 0xcccccccd;
+        } else if (corrupt == 2) {
+            bad.ranks[4] = 0xccccccc0 | WKING;
+        } else if (corrupt == 3) {
+            bad.flags ^= 1 << 16;
+        }
+        FILE *f = fopen(file.c_str(), "r+b");
+        ASSERT_NE(f, nullptr);
+        fseek(f, 8 + 4, SEEK_SET);  // the archive header, then the game header
+        for (uint32_t word : {bad.ranks[0], bad.ranks[1], bad.ranks[2], bad.ranks[3], bad.ranks[4], bad.ranks[5],
+                              bad.ranks[6], bad.ranks[7], bad.flags}) {
+            for (int i = 0; i < 4; ++i) {
+                fputc((word >> (8 * i)) & 0xff, f);
+            }
+        }
+        fclose(f);
+        archive = archive_open(file.c_str());
+        ASSERT_NE(archive, nullptr);
+        EXPECT_EQ(archive_read(archive, &game), corrupt ? -1 : 1) << corrupt;
+        archive_close(archive);
+    }
+
+    // not an archive
+    FILE *f = fopen(file.c_str(), "wb");
+    fputs("[Event \"?\"]\n", f);
+    fclose(f);
+    EXPECT_EQ(archive_open(file.c_str()), nullptr);
+    EXPECT_EQ(archive_open("/nonexistent/archive"), nullptr);
+}
+
+TEST(ArchiveCodeTest, Ranks) {
+    board_t *b = board_make(STARTING_BOARD);
+    move_t legal[BOARD_MOVES_MAX];
+    const size_t n = board_get_moves_buf(b, legal);
+    ASSERT_EQ(n, 20u);
+    // every move has a rank of its own, whatever the order of the list
+    vector<int> seen(n, 0);
+    for (size_t i = 0; i < n; ++i) {
+        const int rank = archive_encode(legal, n, legal[i]);
+        ASSERT_GE(rank, 0);
+        ASSERT_LT(rank, (int) n);
+        seen[rank]++;
+        EXPECT_EQ(archive_decode(legal, n, rank), legal[i]);
+        move_t reversed[BOARD_MOVES_MAX];
+        for (size_t j = 0; j < n; ++j) {
+            reversed[j] = legal[n - 1 - j];
+        }
+        EXPECT_EQ(archive_encode(reversed, n, legal[i]), rank);
+        EXPECT_EQ(archive_decode(reversed, n, rank), legal[i]);
+    }
+    for (size_t i = 0; i < n; ++i) {
+        EXPECT_EQ(seen[i], 1);
+    }
+    // b1a3 comes first, by origin then destination
+    EXPECT_EQ(MVFROMPOS(archive_decode(legal, n, 0)), POS('b', 1));
+    EXPECT_EQ(MVTOPOS(archive_decode(legal, n, 0)), POS('a', 3));
+    EXPECT_EQ(archive_decode(legal, n, (int) n), 0u);
+    EXPECT_EQ(archive_decode(legal, n, -1), 0u);
+    EXPECT_EQ(archive_encode(legal, n, MVMAKE(POS('e', 2), POS('e', 5), POS('e', 5), WPAWN, WPAWN, NOPC)), -1);
+    board_free(b);
+
+    // promotions to every piece are told apart
+    b = board_make("4k3/1P6/8/8/8/8/8/4K3 w - -");
+    const size_t m = board_get_moves_buf(b, legal);
+    vector<int> ranks;
+    for (size_t i = 0; i < m; ++i) {
+        ranks.push_back(archive_encode(legal, m, legal[i]));
+    }
+    std::sort(ranks.begin(), ranks.end());
+    for (size_t i = 0; i < m; ++i) {
+        EXPECT_EQ(ranks[i], (int) i);
+    }
+    board_free(b);
+}
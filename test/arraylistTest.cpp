@@ -9,22 +9,22 @@ extern "C" {
 TEST(ArrayListTest, Make) {
   // make using default settings
   alst_t *list = alst_make(10);
-  EXPECT_EQ(list->cap, 10);
-  EXPECT_EQ(list->len, 0);
+  EXPECT_EQ(list->cap, 10u);
+  EXPECT_EQ(list->len, 0u);
   EXPECT_TRUE(list->data);
   alst_free(list, NULL);
 
   // make without capacity, expect cap to be max(10, cap)
   list = alst_make(0);
-  EXPECT_EQ(list->cap, 10);
-  EXPECT_EQ(list->len, 0);
+  EXPECT_EQ(list->cap, 10u);
+  EXPECT_EQ(list->len, 0u);
   EXPECT_TRUE(list->data);
   alst_free(list, NULL);
 
   // make with large capacity, expect appropriate allocation
   list = alst_make(999);
-  EXPECT_EQ(list->cap, 999);
-  EXPECT_EQ(list->len, 0);
+  EXPECT_EQ(list->cap, 999u);
+  EXPECT_EQ(list->len, 0u);
   EXPECT_TRUE(list->data);
   alst_free(list, NULL);
 }
@@ -63,8 +63,8 @@ TEST(ArrayListTest, Put) {
   // add one member
   list->len = 1;
   alst_put(list, 0, (void *) 0xdeadbeef);
-  EXPECT_EQ(list->cap, 10);
-  EXPECT_EQ(list->len, 1);
+  EXPECT_EQ(list->cap, 10u);
+  EXPECT_EQ(list->len, 1u);
   EXPECT_TRUE(list->data);
   // expect it to be there
   EXPECT_EQ(list->data[0], (void *) 0xdeadbeef);
@@ -72,8 +72,8 @@ TEST(ArrayListTest, Put) {
   // glassbox the alst by expanding its length, inserting a member at the end
   list->len = 10;
   alst_put(list, 9, (void *) 0xcafef00d);
-  EXPECT_EQ(list->cap, 10);
-  EXPECT_EQ(list->len, 10);
+  EXPECT_EQ(list->cap, 10u);
+  EXPECT_EQ(list->len, 10u);
   EXPECT_TRUE(list->data);
   // expect it to be there
   EXPECT_EQ(list->data[9], (void *) 0xcafef00d);
@@ -82,8 +82,8 @@ TEST(ArrayListTest, Put) {
 
   // insert a member in the middle
   alst_put(list, 5, (void *) 0x11111111);
-  EXPECT_EQ(list->cap, 10);
-  EXPECT_EQ(list->len, 10);
+  EXPECT_EQ(list->cap, 10u);
+  EXPECT_EQ(list->len, 10u);
   EXPECT_TRUE(list->data);
   // expect it to be there
   EXPECT_EQ(list->data[5], (void *) 0x11111111);
@@ -126,8 +126,8 @@ TEST(ArrayListTest, Append) {
   }
   
   // verify it's not broken
-  EXPECT_EQ(list->len, 10);
-  EXPECT_EQ(list->cap, 10);
+  EXPECT_EQ(list->len, 10u);
+  EXPECT_EQ(list->cap, 10u);
   EXPECT_TRUE(list->data);
   
   // verify members are all there
@@ -139,8 +139,8 @@ TEST(ArrayListTest, Append) {
 
   // append 11th member, expect capacity expansion
   alst_append(list, (void *) 0xcafef00d);
-  EXPECT_EQ(list->len, 11);
-  EXPECT_EQ(list->cap, 100);
+  EXPECT_EQ(list->len, 11u);
+  EXPECT_EQ(list->cap, 100u);
   EXPECT_TRUE(list->data);
 
   // verify all 11 members are still there
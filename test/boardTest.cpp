@@ -215,6 +215,10 @@ TEST_F(BoardTest, PrintOp) {
         /* fen after applying the move should match expected */ \
         char *fen = board_to_fen(b); \
         EXPECT_EQ(fen, it->first[1]) << "unexpected fen " << fen << " after applying move " << it->second << " to board with fen " << it->first[0] << endl; \
+        /* incrementally updated hash should match the hash of the resulting position */ \
+        board_t *expect = board_make(it->first[1].c_str()); \
+        EXPECT_EQ(b->hash, expect->hash) << "unexpected hash after applying move " << it->second << " to board with fen " << it->first[0] << endl; \
+        board_free(expect); \
         \
         /* cleanup */ \
         board_free(b); \
@@ -240,3 +244,84 @@ TEST_F(BoardTest, ApplyEnPassant) {
 TEST_F(BoardTest, ApplyPromotion) {
     APPLY_AND_TEST_CASES(applyPromotionCases);
 }
+
+// checks the incrementally updated hash against the hash computed from scratch in every node of the tree
+static void checkHashes(const board_t *board, int depth) {
+    ASSERT_EQ(board->hash, board_hash(board)) << "hash mismatch at " << board_to_fen(board) << endl;
+    if (!depth) {
+        return;
+    }
+    move_t moves[BOARD_MOVES_MAX];
+    size_t len = board_get_moves_buf(board, moves);
+    for (size_t i = 0; i < len; ++i) {
+        board_t future = *board;
+#ifdef CHESSLIB_QWORD_MOVE
+        board_apply_move(&future, moves[i]);
+#else
+        board_apply_move(&future, &moves[i]);
+#endif
+        checkHashes(&future, depth - 1);
+    }
+}
+
+TEST_F(BoardTest, HashIncremental) {
+    // castling, en passant and promotions all within 3 plies
+    const char *fens[] = {"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -",
+                          "n1n5/PPPk4/8/8/8/8/4Kppp/5N1N b - -", FEN_C7C5};
+    for (const char *fen : fens) {
+        board_t *b = board_make(fen);
+        checkHashes(b, 3);
+        board_free(b);
+    }
+}
+
+TEST_F(BoardTest, HashDistinguishes) {
+    const char *fens[] = {FEN_START, "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR b KQkq -",
+                          "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w Kkq -", FEN_E2E4,
+                          "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq -"};
+    vector<uint64_t> hashes;
+    for (const char *fen : fens) {
+        board_t *b = board_make(fen);
+        for (uint64_t hash : hashes) {
+            EXPECT_NE(b->hash, hash) << "hash collision on " << fen << endl;
+        }
+        hashes.push_back(b->hash);
+        board_t *c = board_copy(b);
+        EXPECT_EQ(c->hash, b->hash);
+        board_free(c);
+        board_free(b);
+    }
+}
+
+TEST_F(BoardTest, CheckAndPieces) {
+    const char *fens[] = {FEN_START, FEN_RAND_32, FEN_RAND_8, "4k3/8/8/8/8/8/4r3/4K3 w - -",
+                          "4k3/8/8/1B6/8/8/8/4K3 b - -", "4k3/8/8/1B6/8/8/8/4K3 w - -"};
+    const int checks[] = {0, 0, 0, 1, 1, 0};
+    const int pieces[] = {32, 32, 8, 3, 3, 3};
+    for (size_t i = 0; i < sizeof fens / sizeof *fens; ++i) {
+        board_t *b = board_make(fens[i]);
+        EXPECT_EQ(!!board_in_check(b), checks[i]) << fens[i];
+        EXPECT_EQ(board_count_pieces(b), pieces[i]) << fens[i];
+        board_free(b);
+    }
+}
+
+TEST_F(BoardTest, Valid) {
+    for (const char *fen : {FEN_START, FEN_RAND_32, FEN_RAND_8}) {
+        board_t *b = board_make(fen);
+        EXPECT_TRUE(board_is_valid(b)) << fen;
+        board_t bad = *b;
+        bad.ranks[3] = (bad.ranks[3] & ~0xfu) | 0xd;  // beyond NOPC
+        EXPECT_FALSE(board_is_valid(&bad)) << fen;
+        bad = *b;
+        bad.ranks[3] = (bad.ranks[3] & ~0xfu) | (FLAGS_WPLAYER(b->flags) ? BKING : WKING);  // a second king
+        EXPECT_FALSE(board_is_valid(&bad)) << fen;
+        bad = *b;
+        bad.flags ^= 1 << 24;  // the black king away from its flags
+        EXPECT_FALSE(board_is_valid(&bad)) << fen;
+        bad = *b;
+        SETEP(NOPOS + 1, bad.flags);
+        EXPECT_FALSE(board_is_valid(&bad)) << fen;
+        board_free(b);
+    }
+}
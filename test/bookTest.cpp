@@ -0,0 +1,210 @@
+extern "C" {
+#include "defs.h"
+#include "board.h"
+#include "move.h"
+#include "book.h"
+}
+#include "testutil.h"
+
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+#define FEN_KINGS "4k3/8/8/8/8/8/8/4K3 w - -"
+#define FEN_E2E4 "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3"
+#define FEN_CASTLE "r3k2r/8/8/8/8/8/8/R3K2R w KQkq -"
+#define FEN_PROMO "4k3/1P6/8/8/8/8/8/4K3 w - -"
+
+// Polyglot move encoding of from, to and promoted piece
+#define PGMOVE(from, to, promo) ((uint16_t) ((to) | ((from) << 6) | ((promo) << 12)))
+
+struct Entry {
+    uint64_t key;
+    uint16_t move;
+    uint16_t weight;
+};
+
+class BookTest : public ::testing::Test {
+    protected:
+        void SetUp() override {
+            // a stand-in overriding the Polyglot table, written and loaded as a file
+            uint64_t state = 42;
+            for (int i = 0; i < BOOK_RANDOMS; ++i) {
+                uint64_t z = (state += 0x9e3779b97f4a7c15);
+                z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+                z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+                randoms[i] = z ^ (z >> 31);
+            }
+            string bytes;
+            for (int i = 0; i < BOOK_RANDOMS; ++i) {
+                appendBig(bytes, randoms[i], 8);
+            }
+            string path = temp_file("book", bytes);
+            ASSERT_EQ(book_load_randoms(path.c_str()), 0);
+            unlink(path.c_str());
+        }
+
+        void TearDown() override {
+            book_set_randoms(NULL);
+        }
+
+        static void appendBig(string &bytes, uint64_t value, int len) {
+            for (int i = len - 1; i >= 0; --i) {
+                bytes.push_back((char) ((value >> (8 * i)) & 0xff));
+            }
+        }
+
+        // writes the entries, sorted by key as Polyglot books are, and opens them as a book
+        static book_t *makeBook(vector<Entry> entries, string &path) {
+            std::stable_sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) { return a.key < b.key; });
+            string bytes;
+            for (const Entry &e : entries) {
+                appendBig(bytes, e.key, 8);
+                appendBig(bytes, e.move, 2);
+                appendBig(bytes, e.weight, 2);
+                appendBig(bytes, 0, 4);
+            }
+            path = temp_file("book", bytes);
+            return book_open(path.c_str());
+        }
+
+        static uint64_t keyOf(const char *fen) {
+            board_t *b = board_make(fen);
+            uint64_t key = book_key(b);
+            board_free(b);
+            return key;
+        }
+
+        uint64_t randoms[BOOK_RANDOMS];
+};
+
+TEST_F(BookTest, Key) {
+    // black king (kind 10) on e8, white king (kind 11) on e1, white to move
+    EXPECT_EQ(keyOf(FEN_KINGS), randoms[64 * 10 + POS('e', 8)] ^ randoms[64 * 11 + POS('e', 1)] ^ randoms[780]);
+    EXPECT_EQ(keyOf("4k3/8/8/8/8/8/8/4K3 b - -"), randoms[64 * 10 + POS('e', 8)] ^ randoms[64 * 11 + POS('e', 1)]);
+    EXPECT_EQ(keyOf(FEN_CASTLE) ^ keyOf("r3k2r/8/8/8/8/8/8/R3K2R w Qk -"), randoms[768] ^ randoms[771]);
+
+    // the en passant file counts only if the pawn can be taken
+    EXPECT_EQ(keyOf(FEN_E2E4), keyOf("rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq -"));
+    EXPECT_EQ(keyOf("rnbqkbnr/ppp1pppp/8/8/3pP3/8/PPPP1PPP/RNBQKBNR b KQkq e3")
+              ^ keyOf("rnbqkbnr/ppp1pppp/8/8/3pP3/8/PPPP1PPP/RNBQKBNR b KQkq -"), randoms[772 + 4]);
+}
+
+TEST(BookKeyTest, Polyglot) {
+    // the keys published with the Polyglot book format, after e2e4 d7d5 e4e5 f7f5 e1e2 e8f7 and a2a4 b7b5 h2h4 b5b4
+    // c2c4 b4c3 a1a2
+    const struct {
+        const char *fen;
+        uint64_t key;
+    } keys[] = {{STARTING_BOARD, 0x463b96181691fc9cULL},
+                {"rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3", 0x823c9b50fd114196ULL},
+                {"rnbqkbnr/ppp1pppp/8/3p4/4P3/8/PPPP1PPP/RNBQKBNR w KQkq d6", 0x0756b94461c50fb0ULL},
+                {"rnbqkbnr/ppp1pppp/8/3pP3/8/8/PPPP1PPP/RNBQKBNR b KQkq -", 0x662fafb965db29d4ULL},
+                {"rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6", 0x22a48b5a8e47ff78ULL},
+                {"rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPPKPPP/RNBQ1BNR b kq -", 0x652a607ca3f242c1ULL},
+                {"rnbq1bnr/ppp1pkpp/8/3pPp2/8/8/PPPPKPPP/RNBQ1BNR w - -", 0x00fdd303c946bdd9ULL},
+                {"rnbqkbnr/p1pppppp/8/8/PpP4P/8/1P1PPPP1/RNBQKBNR b KQkq c3", 0x3c8123ea7b067637ULL},
+                {"rnbqkbnr/p1pppppp/8/8/P6P/R1p5/1P1PPPP1/1NBQKBNR b Kkq -", 0x5c3f9b829b279560ULL}};
+    for (const auto &k : keys) {
+        board_t *b = board_make(k.fen);
+        EXPECT_EQ(book_key(b), k.key) << k.fen;
+        board_free(b);
+    }
+
+    // the same keys along the moves played
+    board_t *b = board_make(STARTING_BOARD);
+    const char *moves[] = {"Pe2e4", "pd7d5", "Pe4e5", "pf7f5", "Ke1e2", "ke8f7"};
+    for (int i = 0; i < 6; ++i) {
+        board_apply_move(b, move_make_algnot(moves[i]));
+        EXPECT_EQ(book_key(b), keys[i + 1].key) << moves[i];
+    }
+    board_free(b);
+}
+
+TEST_F(BookTest, Probe) {
+    const uint64_t start = keyOf(STARTING_BOARD);
+    vector<Entry> entries = {{start, PGMOVE(POS('e', 2), POS('e', 4), 0), 10},
+                             {start, PGMOVE(POS('d', 2), POS('d', 4), 0), 5},
+                             {start, PGMOVE(POS('e', 2), POS('e', 5), 0), 7},  // not legal: skipped
+                             {keyOf(FEN_CASTLE), PGMOVE(POS('e', 1), POS('h', 1), 0), 3},
+                             {keyOf(FEN_CASTLE), PGMOVE(POS('e', 1), POS('a', 1), 0), 2},
+                             {keyOf(FEN_PROMO), PGMOVE(POS('b', 7), POS('b', 8), 4), 1}};
+    for (uint64_t i = 0; i < 1000; ++i) {  // other positions around them
+        entries.push_back({i * 0x9e3779b97f4a7c15, PGMOVE(POS('a', 2), POS('a', 3), 0), 1});
+    }
+    string path;
+    book_t *book = makeBook(entries, path);
+    ASSERT_NE(book, nullptr);
+    EXPECT_EQ(book->len, entries.size());
+
+    board_t *b = board_make(STARTING_BOARD);
+    book_move_t moves[BOOK_MOVES_MAX];
+    ASSERT_EQ(book_probe(book, b, moves, BOOK_MOVES_MAX), 2u);
+    EXPECT_EQ(moves[0].move, move_make_algnot("Pe2e4"));
+    EXPECT_EQ(moves[0].weight, 10);
+    EXPECT_EQ(moves[1].move, move_make_algnot("Pd2d4"));
+    EXPECT_EQ(moves[1].weight, 5);
+    EXPECT_EQ(book_probe(book, b, moves, 1), 1u);
+    board_free(b);
+
+    b = board_make(FEN_CASTLE);
+    ASSERT_EQ(book_probe(book, b, moves, BOOK_MOVES_MAX), 2u);
+    EXPECT_EQ(moves[0].move, move_make_algnot("Ke1g1"));
+    EXPECT_EQ(moves[1].move, move_make_algnot("Ke1c1"));
+    board_free(b);
+
+    b = board_make(FEN_PROMO);
+    ASSERT_EQ(book_probe(book, b, moves, BOOK_MOVES_MAX), 1u);
+    EXPECT_EQ(moves[0].move, move_make_algnot("Pb7b8Q"));
+    board_free(b);
+
+    b = board_make(FEN_KINGS);  // out of book
+    EXPECT_EQ(book_probe(book, b, moves, BOOK_MOVES_MAX), 0u);
+    board_free(b);
+
+    uint16_t raw[4];
+    uint16_t weights[4];
+    EXPECT_EQ(book_probe_key(book, start, raw, weights, 4), 3u);
+    EXPECT_EQ(raw[2], PGMOVE(POS('e', 2), POS('e', 5), 0));
+    EXPECT_EQ(weights[2], 7);
+
+    book_close(book);
+    unlink(path.c_str());
+}
+
+TEST_F(BookTest, Open) {
+    EXPECT_EQ(book_open("/nonexistent/book.bin"), nullptr);
+    string path = temp_file("book", string(17, '\0'));  // not a whole number of entries
+    EXPECT_EQ(book_open(path.c_str()), nullptr);
+    unlink(path.c_str());
+
+    path = temp_file("book", "");
+    book_t *book = book_open(path.c_str());
+    ASSERT_NE(book, nullptr);
+    uint16_t raw[1];
+    uint16_t weights[1];
+    EXPECT_EQ(book_probe_key(book, 0, raw, weights, 1), 0u);
+    book_close(book);
+    unlink(path.c_str());
+}
+
+TEST_F(BookTest, Pick) {
+    const book_move_t moves[] = {{1, 3}, {2, 0}, {3, 1}};
+    int counts[4] = {0, 0, 0, 0};
+    for (uint64_t r = 0; r < 400; ++r) {
+        ++counts[book_pick(moves, 3, r)];
+    }
+    EXPECT_EQ(counts[1], 300);
+    EXPECT_EQ(counts[2], 0);
+    EXPECT_EQ(counts[3], 100);
+    const book_move_t none[] = {{1, 0}};
+    EXPECT_EQ(book_pick(none, 1, 7), 0u);
+    EXPECT_EQ(book_pick(moves, 0, 7), 0u);
+}
@@ -0,0 +1,149 @@
+extern "C" {
+#include "defs.h"
+#include "board.h"
+#include "epd.h"
+}
+#include "testutil.h"
+
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+// FENs of the positions along random games, as board_to_fen writes them
+static vector<string> random_fens(size_t n, uint64_t seed) {
+    vector<string> ret;
+    const board_t start = fen_board(STARTING_BOARD);
+    while (ret.size() < n) {
+        board_t b = start;
+        for (move_t move : random_game(start, 200, seed)) {
+            board_apply_move(&b, move);
+            ret.push_back(board_to_fen(&b));  // copied out of its static buffer
+        }
+    }
+    ret.resize(n);
+    return ret;
+}
+
+TEST(EpdTest, Parse) {
+    vector<string> fens = random_fens(2000, 42);
+    fens.push_back("r3k2r/8/8/8/8/8/8/R3K2R w Kq -");
+    fens.push_back("rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6");
+    for (const string &fen : fens) {
+        board_t parsed;
+        ASSERT_EQ(epd_parse(fen.data(), fen.size(), &parsed), fen.size()) << fen;
+        EXPECT_TRUE(same_board(parsed, fen_board(fen.c_str()))) << fen;
+    }
+
+    board_t b;
+    const string fen = STARTING_BOARD " 0 1";
+    EXPECT_EQ(epd_parse(fen.data(), fen.size(), &b), strlen(STARTING_BOARD));
+    const char *bad[] = {
+        "",
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR",
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR x KQkq -",
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBN w KQkq -",
+        "rnbqkbnr/pppppppp/9/8/8/8/PPPPPPPP/RNBQKBNR w KQkq -",
+        "rnbqkbnr/pppppppp/45/8/8/8/PPPPPPPP/RNBQKBNR w KQkq -",
+        "rnbqkbnr/ppppxppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq -",
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQxq -",
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq e4",
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq -x",
+        "rnbq1bnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQ -",
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR/8 w KQkq -",
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNRw KQkq -",
+        "4k3/8/8/8/8/8/8/4K3 w -- 0 1",
+        "4k3/8/8/8/8/8/8/4K3 w --",
+        "4k3/4R3/8/8/8/8/8/4K3 w - -",
+        // castling rights without their king or rook
+        "4k3/8/8/8/8/8/8/K7 w Q - 0 1",
+        "4k3/8/8/8/8/8/8/4K3 w K -",
+        "r3k3/8/8/8/8/8/8/R3K2R w k -",
+        "r3k2r/8/8/8/8/8/8/R2K3R w Q -",
+        // en passant positions on the wrong rank, or without the pawn that moved
+        "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR w KQkq e3",
+        "rnbqkbnr/ppp1pppp/8/3p4/4P3/8/PPPP1PPP/RNBQKBNR b KQkq d6",
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR b KQkq e3",
+        // pawns on the first or last rank
+        "4k2P/8/8/8/8/8/8/4K3 w - -",
+        "4k3/8/8/8/8/8/8/p3K3 b - -",
+    };
+    for (const char *s : bad) {
+        EXPECT_EQ(epd_parse(s, strlen(s), &b), 0u) << s;
+    }
+}
+
+TEST(EpdTest, Operations) {
+    const string text =
+        "# a comment\n"
+        "\n"
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - ;D1 20 ;D2 400\r\n"
+        "  r3k2r/8/8/8/8/8/8/R3K2R b KQkq - 12 40\n"
+        "not a position\n"
+        "4k3/8/8/8/8/8/8/4K3 w -- 0 1\n"
+        "4k3/8/8/8/8/8/8/4K3 w - - bm Ke2 Kd2; id \"kings; only\"; c0 \"a\" \"b\"; noop;\n"
+        "4k3/8/8/8/8/8/8/4K3 b - -";
+    epd_t *epd = epd_load_buf(text.data(), text.size(), 1);
+    ASSERT_EQ(epd->len, 4u);
+    EXPECT_EQ(epd->errors, 2u);
+    EXPECT_EQ(epd->nops, 8u);
+
+    EXPECT_TRUE(same_board(epd->boards[0], fen_board(STARTING_BOARD)));
+    EXPECT_STREQ(epd_op(epd, 0, "D1"), "20");
+    EXPECT_STREQ(epd_op(epd, 0, "D2"), "400");
+    EXPECT_EQ(epd_op(epd, 0, "D3"), nullptr);
+
+    EXPECT_TRUE(FLAGS_BPLAYER(epd->boards[1].flags));
+    EXPECT_STREQ(epd_op(epd, 1, "hmvc"), "12");
+    EXPECT_STREQ(epd_op(epd, 1, "fmvn"), "40");
+
+    EXPECT_STREQ(epd_op(epd, 2, "bm"), "Ke2 Kd2");
+    EXPECT_STREQ(epd_op(epd, 2, "id"), "kings; only");
+    EXPECT_STREQ(epd_op(epd, 2, "c0"), "\"a\" \"b\"");
+    EXPECT_STREQ(epd_op(epd, 2, "noop"), "");
+
+    EXPECT_EQ(epd->opsidx[3], epd->opsidx[4]);
+    EXPECT_EQ(epd_op(epd, 3, "bm"), nullptr);
+    epd_free(epd);
+
+    epd = epd_load_buf("", 0, 0);
+    EXPECT_EQ(epd->len, 0u);
+    EXPECT_EQ(epd->nops, 0u);
+    epd_free(epd);
+}
+
+TEST(EpdTest, Chunks) {
+    // several chunks of lines, which the threads must split at line boundaries
+    const vector<string> fens = random_fens(60000, 7);
+    string text;
+    for (size_t i = 0; i < fens.size(); ++i) {
+        text += fens[i] + (i % 3 ? " ;id \"" + std::to_string(i) + "\";\n" : " 0 " + std::to_string(i) + "\n");
+        if (i % 1000 == 0) {
+            text += "# comment\nbad line\n";
+        }
+    }
+    ASSERT_GT(text.size(), (size_t) 3 * EPD_CHUNK);
+
+    const string path = temp_file("epd", text);
+
+    for (int threads : {1, 3, 0}) {
+        epd_t *epd = epd_load(path.c_str(), threads);
+        ASSERT_NE(epd, nullptr);
+        ASSERT_EQ(epd->len, fens.size());
+        EXPECT_EQ(epd->errors, 60u);
+        for (size_t i = 0; i < fens.size(); ++i) {
+            board_t b;
+            ASSERT_EQ(epd_parse(fens[i].data(), fens[i].size(), &b), fens[i].size());
+            ASSERT_TRUE(same_board(epd->boards[i], b)) << i;
+            ASSERT_STREQ(epd_op(epd, i, i % 3 ? "id" : "fmvn"), std::to_string(i).c_str());
+        }
+        epd_free(epd);
+    }
+    unlink(path.c_str());
+    EXPECT_EQ(epd_load("/nonexistent/file.epd", 0), nullptr);
+}
@@ -0,0 +1,95 @@
+extern "C" {
+#include "defs.h"
+#include "board.h"
+#include "move.h"
+#include "eval.h"
+}
+
+#include <gtest/gtest.h>
+#include <iostream>
+
+using std::endl;
+
+#define FEN_KIWIPETE "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -"
+#define FEN_PROMOTIONS "n1n5/PPPk4/8/8/8/8/4Kppp/5N1N b - -"
+#define FEN_EP "rnbqkbnr/pp1ppppp/8/2p5/4P3/8/PPPP1PPP/RNBQKBNR w KQkq c6"
+#define FEN_HANGING_QUEEN "4k3/8/8/3q4/8/8/3R4/4K3 w - -"
+#define FEN_KP_K "8/8/8/4k3/8/8/4P3/4K3 w - -"
+
+// checks the incrementally updated terms against the terms computed from scratch in every node of the tree
+static void checkTerms(const board_t *board, int depth) {
+    board_t fresh = *board;
+    eval_reset(&fresh);
+    ASSERT_EQ(board->mg, fresh.mg) << "midgame score mismatch at " << board_to_fen(board) << endl;
+    ASSERT_EQ(board->eg, fresh.eg) << "endgame score mismatch at " << board_to_fen(board) << endl;
+    ASSERT_EQ(board->phase, fresh.phase) << "phase mismatch at " << board_to_fen(board) << endl;
+    if (!depth) {
+        return;
+    }
+    move_t moves[BOARD_MOVES_MAX];
+    size_t len = board_get_moves_buf(board, moves);
+    for (size_t i = 0; i < len; ++i) {
+        board_t future = *board;
+#ifdef CHESSLIB_QWORD_MOVE
+        board_apply_move(&future, moves[i]);
+#else
+        board_apply_move(&future, &moves[i]);
+#endif
+        checkTerms(&future, depth - 1);
+    }
+}
+
+TEST(EvalTest, Start) {
+    board_t *b = board_make(STARTING_BOARD);
+    EXPECT_EQ(b->mg, 0);
+    EXPECT_EQ(b->eg, 0);
+    EXPECT_EQ(b->phase, EVAL_PHASE_MAX);
+    EXPECT_EQ(eval_board(b), 0);
+    board_t *c = board_copy(b);
+    EXPECT_EQ(c->mg, b->mg);
+    EXPECT_EQ(c->eg, b->eg);
+    EXPECT_EQ(c->phase, b->phase);
+    board_free(c);
+    board_free(b);
+}
+
+TEST(EvalTest, Incremental) {
+    // castling, en passant and promotions all within 3 plies
+    const char *fens[] = {FEN_KIWIPETE, FEN_PROMOTIONS, FEN_EP};
+    for (const char *fen : fens) {
+        board_t *b = board_make(fen);
+        checkTerms(b, 3);
+        board_free(b);
+    }
+}
+
+TEST(EvalTest, Symmetric) {
+    // mirrored positions score the same for the player to move
+    const char *fens[][2] = {{FEN_HANGING_QUEEN, "4k3/3r4/8/8/3Q4/8/8/4K3 b - -"},
+                             {"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -",
+                              "r3k2r/pppbbppp/2n2q1P/1P2p3/3pn3/BN2PNP1/P1PPQPB1/R3K2R b KQkq -"}};
+    for (auto &pair : fens) {
+        board_t *w = board_make(pair[0]);
+        board_t *b = board_make(pair[1]);
+        EXPECT_EQ(w->mg, -b->mg);
+        EXPECT_EQ(w->eg, -b->eg);
+        EXPECT_EQ(w->phase, b->phase);
+        EXPECT_EQ(eval_board(w), eval_board(b));
+        board_free(b);
+        board_free(w);
+    }
+}
+
+TEST(EvalTest, Tapered) {
+    board_t *b = board_make(FEN_HANGING_QUEEN);
+    EXPECT_EQ(b->phase, 6);
+    EXPECT_LT(eval_board(b), -300);  // down a queen for a rook
+    EXPECT_EQ(eval_board(b), (b->mg * 6 + b->eg * (EVAL_PHASE_MAX - 6)) / EVAL_PHASE_MAX);
+    board_free(b);
+
+    b = board_make(FEN_KP_K);  // pure endgame
+    EXPECT_EQ(b->phase, 0);
+    EXPECT_EQ(eval_board(b), b->eg);
+    EXPECT_GT(eval_board(b), 0);
+    board_free(b);
+}
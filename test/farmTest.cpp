@@ -0,0 +1,211 @@
+extern "C" {
+#include "defs.h"
+#include "board.h"
+#include "move.h"
+#include "farm.h"
+#include "pgn.h"
+}
+#include "testutil.h"
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+static vector<string> read_lines(const string &path) {
+    std::ifstream in(path);
+    vector<string> ret;
+    for (string line; std::getline(in, line);) {
+        ret.push_back(line);
+    }
+    return ret;
+}
+
+static string move_uci(move_t move) {
+    static const char promos[] = "pnbrqkpnbrqk";
+    string ret;
+    ret += 'a' + MVFROMPOS(move) % 8;
+    ret += '1' + MVFROMPOS(move) / 8;
+    ret += 'a' + MVTOPOS(move) % 8;
+    ret += '1' + MVTOPOS(move) / 8;
+    if (MVTOPC(move) != MVFROMPC(move)) {
+        ret += promos[MVTOPC(move)];
+    }
+    return ret;
+}
+
+// replays a game line, checking that its moves are legal and that it ends as it says
+static void check_game(const string &line, int maxplies) {
+    std::istringstream in(line);
+    string result, reason, token;
+    in >> result >> reason;
+    board_t *b = board_make(STARTING_BOARD);
+    int plies = 0;
+    while (in >> token) {
+        move_t moves[BOARD_MOVES_MAX];
+        const size_t len = board_get_moves_buf(b, moves);
+        size_t i = 0;
+        while (i < len && move_uci(moves[i]) != token) {
+            ++i;
+        }
+        ASSERT_LT(i, len) << "illegal move " << token << " in " << line;
+        board_apply_move(b, moves[i]);
+        ++plies;
+    }
+    ASSERT_LE(plies, maxplies);
+    if (reason == "mate") {
+        EXPECT_TRUE(board_is_mate(b));
+        EXPECT_EQ(result, FLAGS_WPLAYER(b->flags) ? "0-1" : "1-0");
+    } else if (reason == "stalemate" || reason == "material") {
+        EXPECT_TRUE(board_is_stalemate(b));
+        EXPECT_EQ(result, "1/2-1/2");
+    } else if (reason == "plies") {
+        EXPECT_EQ(plies, maxplies);
+        EXPECT_EQ(result, "*");
+    } else {
+        EXPECT_TRUE(reason == "repetition" || reason == "fifty") << reason;
+        EXPECT_EQ(result, "1/2-1/2");
+    }
+    board_free(b);
+}
+
+class FarmTest : public ::testing::Test {
+    protected:
+        void SetUp() override {
+            file = temp_file("farm");
+        }
+
+        void TearDown() override {
+            unlink(file.c_str());
+        }
+
+        string file;
+};
+
+TEST_F(FarmTest, Random) {
+    farm_config_t config = {300, 4, NULL, FARM_RANDOM, 0, 0, 0, 0, 0, 0, 42, 0, NULL};
+    farm_stats_t stats;
+    ASSERT_EQ(farm_run(&config, file.c_str(), &stats), 0);
+    vector<string> lines = read_lines(file);
+    ASSERT_EQ(lines.size(), 300u);
+    uint64_t plies = 0;
+    for (const string &line : lines) {
+        check_game(line, FARM_MAX_PLIES);
+        plies += std::count(line.begin(), line.end(), ' ') - 1;
+    }
+    EXPECT_EQ(stats.games, 300u);
+    EXPECT_EQ(stats.plies, plies);
+    uint64_t results = 0, reasons = 0;
+    for (int i = 0; i < 4; ++i) {
+        results += stats.results[i];
+    }
+    for (int i = 0; i < FARM_NREASONS; ++i) {
+        reasons += stats.reasons[i];
+    }
+    EXPECT_EQ(results, 300u);
+    EXPECT_EQ(reasons, 300u);
+    EXPECT_GT(stats.reasons[FARM_MATE], 0u);
+    EXPECT_GT(stats.reasons[FARM_MATERIAL], 0u);
+
+    // the same games on one thread
+    config.threads = 1;
+    ASSERT_EQ(farm_run(&config, file.c_str(), NULL), 0);
+    vector<string> again = read_lines(file);
+    std::sort(lines.begin(), lines.end());
+    std::sort(again.begin(), again.end());
+    EXPECT_EQ(lines, again);
+}
+
+TEST_F(FarmTest, Policies) {
+    farm_config_t config = {20, 2, NULL, FARM_WEIGHTED, 60, 4, 0, 0, 0, 0, 1, 0, NULL};
+    farm_stats_t stats;
+    ASSERT_EQ(farm_run(&config, file.c_str(), &stats), 0);
+    for (const string &line : read_lines(file)) {
+        check_game(line, 60);
+    }
+    EXPECT_EQ(stats.games, 20u);
+
+    config.policy = FARM_SEARCH;
+    config.depth = 2;
+    config.ttmb = 1;
+    ASSERT_EQ(farm_run(&config, file.c_str(), &stats), 0);
+    vector<string> lines = read_lines(file);
+    ASSERT_EQ(lines.size(), 20u);
+    for (const string &line : lines) {
+        check_game(line, 60);
+    }
+    std::sort(lines.begin(), lines.end());
+    EXPECT_NE(lines.front(), lines.back());  // random openings
+}
+
+TEST_F(FarmTest, Endings) {
+    // a mate in one, found by the search
+    farm_config_t config = {10, 1, "k7/8/1K6/8/8/8/8/6Q1 w - -", FARM_SEARCH, 0, 0, 0, 3, 0, 0, 7, 0, NULL};
+    farm_stats_t stats;
+    ASSERT_EQ(farm_run(&config, file.c_str(), &stats), 0);
+    EXPECT_EQ(stats.results[RESULT_WHITE_WINS], 10u);
+    EXPECT_EQ(stats.reasons[FARM_MATE], 10u);
+    EXPECT_EQ(stats.plies, 10u);
+
+    // zeroed limits search to FARM_DEPTH rather than without end
+    config.depth = 0;
+    ASSERT_EQ(farm_run(&config, file.c_str(), &stats), 0);
+    EXPECT_EQ(stats.reasons[FARM_MATE], 10u);
+    config.depth = 3;
+
+    // kings alone
+    config.fen = "k7/8/8/8/8/8/8/K7 w - -";
+    ASSERT_EQ(farm_run(&config, file.c_str(), &stats), 0);
+    EXPECT_EQ(stats.reasons[FARM_MATERIAL], 10u);
+    EXPECT_EQ(stats.plies, 0u);
+
+    // rooks shuffling: repetition or the fifty-move rule, never the ply limit
+    config.fen = "r3k3/8/8/8/8/8/8/R3K3 w - -";
+    config.policy = FARM_RANDOM;
+    config.maxplies = 400;
+    ASSERT_EQ(farm_run(&config, file.c_str(), &stats), 0);
+    EXPECT_EQ(stats.reasons[FARM_PLIES], 0u);
+
+    EXPECT_NE(farm_run(&config, "/nonexistent/games.txt", NULL), 0);
+    config.fen = "notafen";
+    EXPECT_NE(farm_run(&config, file.c_str(), NULL), 0);
+    config.fen = "4k3/8/8/8/8/8/8/K7 w Q - 0 1";
+    EXPECT_NE(farm_run(&config, file.c_str(), NULL), 0);
+    EXPECT_STREQ(farm_result_str(RESULT_BLACK_WINS), "0-1");
+    EXPECT_STREQ(farm_reason_str(FARM_FIFTY), "fifty");
+}
+
+static void count_game(void *ctx, const pgn_game_t *game) {
+    EXPECT_FALSE(game->error);
+    EXPECT_STREQ(pgn_tag(game, "Event"), "farm");
+    __atomic_fetch_add((uint64_t *) ctx, game->len, __ATOMIC_RELAXED);
+}
+
+TEST_F(FarmTest, Pgn) {
+    farm_config_t config = {50, 2, NULL, FARM_RANDOM, 0, 0, 0, 0, 0, 0, 3, 1, NULL};
+    farm_stats_t stats;
+    ASSERT_EQ(farm_run(&config, file.c_str(), &stats), 0);
+    uint64_t plies = 0;
+    pgn_stats_t read;
+    ASSERT_EQ(pgn_read(file.c_str(), 2, count_game, &plies, &read), 0);
+    EXPECT_EQ(read.games, 50u);
+    EXPECT_EQ(read.errors, 0u);
+    EXPECT_EQ(plies, stats.plies);
+
+    config.fen = "r3k3/8/8/8/8/8/8/R3K3 w Qq -";
+    config.games = 5;
+    ASSERT_EQ(farm_run(&config, file.c_str(), &stats), 0);
+    plies = 0;
+    ASSERT_EQ(pgn_read(file.c_str(), 1, count_game, &plies, &read), 0);
+    EXPECT_EQ(read.games, 5u);
+    EXPECT_EQ(read.errors, 0u);
+    EXPECT_EQ(plies, stats.plies);
+}
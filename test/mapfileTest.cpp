@@ -0,0 +1,86 @@
+extern "C" {
+#include "mapfile.h"
+}
+#include "testutil.h"
+
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+class MapfileTest : public ::testing::Test {
+    protected:
+        void SetUp() override {
+            file = temp_file("mapfile");
+        }
+
+        void TearDown() override {
+            unlink(file.c_str());
+        }
+
+        string file;
+};
+
+TEST_F(MapfileTest, Open) {
+    mapfile_t map;
+    ASSERT_EQ(mapfile_open(file.c_str(), MAPFILE_SEQUENTIAL, &map), 0);
+    EXPECT_EQ(map.mem, nullptr);
+    EXPECT_EQ(map.len, 0u);
+    mapfile_close(&map);
+
+    const string text = "8/8/8/8/8/8/8/8\n";
+    FILE *out = fopen(file.c_str(), "w");
+    ASSERT_NE(out, nullptr);
+    fputs(text.c_str(), out);
+    fclose(out);
+    for (int advice : {MAPFILE_NORMAL, MAPFILE_SEQUENTIAL, MAPFILE_RANDOM}) {
+        ASSERT_EQ(mapfile_open(file.c_str(), advice, &map), 0);
+        ASSERT_EQ(map.len, text.size());
+        EXPECT_EQ(string(map.mem, map.len), text);
+        mapfile_close(&map);
+        EXPECT_EQ(map.len, 0u);
+    }
+
+    map.len = 7;
+    EXPECT_NE(mapfile_open("/nonexistent/file", MAPFILE_NORMAL, &map), 0);
+    EXPECT_EQ(map.len, 7u);
+}
+
+struct Counts {
+    mapfile_pool_t pool;
+    vector<int> taken;
+};
+
+static void *count_chunks(void *arg) {
+    Counts *counts = (Counts *) arg;
+    for (;;) {
+        const size_t chunk = mapfile_pool_next(&counts->pool);
+        if (chunk == counts->pool.nchunks) {
+            break;
+        }
+        __atomic_fetch_add(&counts->taken[chunk], 1, __ATOMIC_RELAXED);
+    }
+    return NULL;
+}
+
+TEST(MapfilePoolTest, Run) {
+    // every chunk is taken exactly once, on any number of threads, and again on every run
+    for (size_t nchunks : {0, 1, 3, 100}) {
+        for (int threads : {0, 1, 4, 200}) {
+            Counts counts;
+            counts.pool.nchunks = nchunks;
+            counts.taken.assign(nchunks, 0);
+            mapfile_pool_run(&counts.pool, threads, count_chunks, &counts);
+            mapfile_pool_run(&counts.pool, threads, count_chunks, &counts);
+            for (size_t i = 0; i < nchunks; ++i) {
+                EXPECT_EQ(counts.taken[i], 2) << nchunks << " chunks on " << threads << " threads";
+            }
+            EXPECT_EQ(mapfile_pool_next(&counts.pool), nchunks);
+        }
+    }
+}
@@ -0,0 +1,178 @@
+extern "C" {
+#include "defs.h"
+#include "board.h"
+#include "move.h"
+#include "mcts.h"
+}
+
+#include <gtest/gtest.h>
+#include <vector>
+
+using std::vector;
+
+// an evaluator of uniform priors and a draw value, which checks and records its batches
+struct Recorder {
+    vector<size_t> batches;
+    int badmoves = 0;
+    move_t favored = 0;  // a move given all the prior where legal
+};
+
+static void uniform(void *ctx, size_t n, const board_t *boards, const move_t *moves, const uint32_t *offsets,
+                    float *priors, float *values) {
+    Recorder *rec = (Recorder *) ctx;
+    rec->batches.push_back(n);
+    move_t buf[BOARD_MOVES_MAX];
+    for (size_t i = 0; i < n; ++i) {
+        const size_t len = board_get_moves_buf(&boards[i], buf);
+        if (len != offsets[i + 1] - offsets[i]) {
+            ++rec->badmoves;
+        }
+        for (uint32_t j = offsets[i]; j < offsets[i + 1]; ++j) {
+            if (len == offsets[i + 1] - offsets[i] && moves[j] != buf[j - offsets[i]]) {
+                ++rec->badmoves;
+            }
+            priors[j] = rec->favored ? moves[j] == rec->favored : 1;
+        }
+        values[i] = 0;
+    }
+}
+
+static uint32_t root_children_visits(const mcts_t *tree) {
+    move_t moves[BOARD_MOVES_MAX];
+    uint32_t visits[BOARD_MOVES_MAX];
+    const size_t len = mcts_policy(tree, moves, visits);
+    uint32_t ret = 0;
+    for (size_t i = 0; i < len; ++i) {
+        ret += visits[i];
+    }
+    return ret;
+}
+
+TEST(MctsTest, Batches) {
+    board_t *b = board_make(STARTING_BOARD);
+    mcts_config_t config = {0, 0, 16, 0};
+    mcts_t *tree = mcts_make(b, &config);
+    Recorder rec;
+    EXPECT_EQ(mcts_policy(tree, NULL, NULL), 0u);
+    EXPECT_EQ(mcts_best(tree), 0u);
+    EXPECT_EQ(mcts_search(tree, 500, uniform, &rec), 500u);
+    EXPECT_EQ(rec.badmoves, 0);
+    size_t evaluated = 0;
+    size_t largest = 0;
+    for (size_t n : rec.batches) {
+        evaluated += n;
+        largest = n > largest ? n : largest;
+    }
+    EXPECT_EQ(evaluated, 500u);
+    EXPECT_EQ(largest, 16u);
+    EXPECT_LT(rec.batches.size(), 100u);  // virtual losses spread the batches over many leaves
+    EXPECT_EQ(tree->nodes[0].visits, 500u);
+    EXPECT_EQ(root_children_visits(tree), 499u);  // the first playout expands the root
+    for (size_t i = 0; i < tree->len; ++i) {
+        EXPECT_EQ(tree->nodes[i].vloss, 0u);
+    }
+    EXPECT_FLOAT_EQ(mcts_value(tree), 0);
+    mcts_free(tree);
+    board_free(b);
+}
+
+TEST(MctsTest, Priors) {
+    board_t *b = board_make(STARTING_BOARD);
+    mcts_t *tree = mcts_make(b, NULL);
+    Recorder rec;
+    rec.favored = MVMAKE(POS('d', 2), POS('d', 4), NOPOS, WPAWN, WPAWN, NOPC);
+    mcts_search(tree, 1000, uniform, &rec);
+    EXPECT_EQ(mcts_best(tree), rec.favored);
+    mcts_free(tree);
+    board_free(b);
+}
+
+TEST(MctsTest, Terminal) {
+    // mate in one: Qg8
+    board_t *b = board_make("k7/8/1K6/8/8/8/8/6Q1 w - -");
+    mcts_config_t config = {0, 0, 8, 0};
+    mcts_t *tree = mcts_make(b, &config);
+    Recorder rec;
+    mcts_search(tree, 2000, uniform, &rec);
+    board_t *child = board_copy(b);
+    board_apply_move(child, mcts_best(tree));
+    EXPECT_TRUE(board_is_mate(child));
+    EXPECT_GT(mcts_value(tree), 0.5);
+    mcts_free(tree);
+
+    // no playouts from a mate, nor a stalemate
+    tree = mcts_make(child, NULL);
+    EXPECT_EQ(mcts_search(tree, 100, uniform, &rec), 0u);
+    EXPECT_FLOAT_EQ(mcts_value(tree), -1);
+    EXPECT_EQ(mcts_best(tree), 0u);
+    board_free(child);
+    child = board_make("k7/2Q5/1K6/8/8/8/8/8 b - -");
+    mcts_reset(tree, child);
+    EXPECT_EQ(mcts_search(tree, 100, uniform, &rec), 0u);
+    EXPECT_FLOAT_EQ(mcts_value(tree), 0);
+    mcts_free(tree);
+    board_free(child);
+    board_free(b);
+}
+
+TEST(MctsTest, Advance) {
+    board_t *b = board_make(STARTING_BOARD);
+    mcts_config_t config = {0, 0, 32, 0};
+    mcts_t *tree = mcts_make(b, &config);
+    Recorder rec;
+    mcts_search(tree, 2000, uniform, &rec);
+    const size_t len = tree->len;
+    const move_t best = mcts_best(tree);
+    uint32_t visits = 0;
+    for (uint32_t i = 0; i < tree->nodes[0].nchildren; ++i) {
+        if (tree->nodes[tree->nodes[0].children + i].move == best) {
+            visits = tree->nodes[tree->nodes[0].children + i].visits;
+        }
+    }
+    EXPECT_EQ(mcts_advance(tree, best), 0);
+    board_apply_move(b, best);
+    EXPECT_EQ(memcmp(&tree->root, b, sizeof(board_t)), 0);
+    EXPECT_EQ(tree->nodes[0].visits, visits);
+    EXPECT_EQ(root_children_visits(tree), visits - 1);
+    EXPECT_LT(tree->len, len);
+    for (size_t i = 1; i < tree->len; ++i) {  // parents come before children, which are together
+        const mcts_node_t *parent = &tree->nodes[tree->nodes[i].parent];
+        EXPECT_LT(tree->nodes[i].parent, i);
+        EXPECT_GE(i, parent->children);
+        EXPECT_LT(i, parent->children + parent->nchildren);
+    }
+
+    // searching on from the subtree kept, and its checks of moves
+    rec.batches.clear();
+    EXPECT_EQ(mcts_search(tree, 500, uniform, &rec), 500u);
+    EXPECT_EQ(rec.badmoves, 0);
+    EXPECT_EQ(tree->nodes[0].visits, visits + 500);
+
+    // a move out of the tree clears it
+    move_t moves[BOARD_MOVES_MAX];
+    uint32_t counts[BOARD_MOVES_MAX];
+    ASSERT_GT(mcts_policy(tree, moves, counts), 0u);
+    mcts_reset(tree, &tree->root);
+    EXPECT_NE(mcts_advance(tree, moves[0]), 0);
+    EXPECT_EQ(tree->len, 1u);
+    EXPECT_EQ(tree->nodes[0].visits, 0u);
+    mcts_free(tree);
+    board_free(b);
+}
+
+TEST(MctsTest, Full) {
+    board_t *b = board_make(STARTING_BOARD);
+    mcts_config_t config = {0, 0, 4, 1 + BOARD_MOVES_MAX};
+    mcts_t *tree = mcts_make(b, &config);
+    Recorder rec;
+    const uint64_t done = mcts_search(tree, 1000, uniform, &rec);
+    EXPECT_GT(done, 0u);
+    EXPECT_LT(done, 1000u);
+    EXPECT_LE(tree->len, (size_t) 1 + BOARD_MOVES_MAX);
+    EXPECT_EQ(tree->nodes[0].visits, done);
+    for (size_t i = 0; i < tree->len; ++i) {
+        EXPECT_EQ(tree->nodes[i].vloss, 0u);
+    }
+    mcts_free(tree);
+    board_free(b);
+}
@@ -0,0 +1,140 @@
+extern "C" {
+#include "defs.h"
+#include "board.h"
+#include "move.h"
+#include "move16.h"
+}
+#include "testutil.h"
+
+#include <gtest/gtest.h>
+#include <cstring>
+#include <set>
+#include <vector>
+
+using std::set;
+using std::vector;
+
+static const char *fens[] = {
+    STARTING_BOARD,
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -",
+    "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6",
+    "r3k2r/1P6/8/8/8/8/1p6/R3K2R b KQkq -",
+    "n1n5/PPPk4/8/8/8/8/4Kppp/5N1N b - -",
+};
+
+TEST(Move16Test, Pack) {
+    EXPECT_EQ(move16_make(0), 0);
+    const move_t e2e4 = MVMAKE(POS('e', 2), POS('e', 4), NOPOS, WPAWN, WPAWN, NOPC);
+    EXPECT_EQ(move16_make(e2e4), MV16MAKE(POS('e', 2), POS('e', 4), WKNIGHT, MOVE16_NORMAL));
+    const move16_t promo = move16_make(MVMAKE(POS('b', 2), POS('a', 1), POS('a', 1), BPAWN, BROOK, WROOK));
+    EXPECT_EQ(MV16FROMPOS(promo), POS('b', 2));
+    EXPECT_EQ(MV16TOPOS(promo), POS('a', 1));
+    EXPECT_EQ(MV16PROMO(promo), WROOK);
+    EXPECT_EQ(MV16KIND(promo), MOVE16_PROMO);
+    EXPECT_EQ(MV16KIND(move16_make(MVMAKE(POS('e', 5), POS('f', 6), POS('f', 5), WPAWN, WPAWN, BPAWN))), MOVE16_EP);
+    EXPECT_EQ(MV16KIND(move16_make(MVMAKE(POS('e', 8), POS('c', 8), NOPOS, BKING, BKING, NOPC))), MOVE16_CASTLE);
+    EXPECT_EQ(MV16KIND(move16_make(MVMAKE(POS('e', 1), POS('f', 1), NOPOS, WKING, WKING, NOPC))), MOVE16_NORMAL);
+}
+
+TEST(Move16Test, RoundTrip) {
+    // every legal move of positions along random games packs to a value of its own and unpacks to itself
+    uint64_t state = 42;
+    size_t kinds[4] = {0};
+    for (const char *fen : fens) {
+        board_t *b = board_make(fen);
+        for (int ply = 0; ply < 60; ++ply) {
+            move_t moves[BOARD_MOVES_MAX];
+            move16_t packed[BOARD_MOVES_MAX];
+            const size_t len = board_get_moves_buf(b, moves);
+            ASSERT_EQ(move16_get_moves_buf(b, packed), len);
+            if (!len) {
+                break;
+            }
+            set<move16_t> seen;
+            for (size_t i = 0; i < len; ++i) {
+                EXPECT_EQ(packed[i], move16_make(moves[i]));
+                EXPECT_EQ(move16_to_move(b, packed[i]), moves[i]) << fen;
+                EXPECT_NE(packed[i], 0);
+                seen.insert(packed[i]);
+                kinds[MV16KIND(packed[i])]++;
+            }
+            EXPECT_EQ(seen.size(), len);
+            board_apply_move(b, random_move(moves, len, state));
+        }
+        board_free(b);
+    }
+    for (int kind = 0; kind < 4; ++kind) {
+        EXPECT_GT(kinds[kind], 0u) << kind;
+    }
+}
+
+TEST(Move16Test, Invalid) {
+    board_t *b = board_make(fens[2]);
+    EXPECT_EQ(move16_to_move(b, 0), 0u);
+    // no piece, a piece of the opponent, taking a piece of the player
+    EXPECT_EQ(move16_to_move(b, MV16MAKE(POS('e', 3), POS('e', 4), WKNIGHT, MOVE16_NORMAL)), 0u);
+    EXPECT_EQ(move16_to_move(b, MV16MAKE(POS('e', 7), POS('e', 6), WKNIGHT, MOVE16_NORMAL)), 0u);
+    EXPECT_EQ(move16_to_move(b, MV16MAKE(POS('d', 1), POS('d', 2), WKNIGHT, MOVE16_NORMAL)), 0u);
+    // moves not of their kind
+    EXPECT_EQ(move16_to_move(b, MV16MAKE(POS('g', 1), POS('f', 3), WQUEEN, MOVE16_PROMO)), 0u);
+    EXPECT_EQ(move16_to_move(b, MV16MAKE(POS('e', 5), POS('d', 6), WKNIGHT, MOVE16_EP)), 0u);
+    EXPECT_EQ(move16_to_move(b, MV16MAKE(POS('e', 1), POS('e', 2), WKNIGHT, MOVE16_CASTLE)), 0u);
+    EXPECT_EQ(move16_to_move(b, MV16MAKE(POS('e', 5), POS('f', 6), WKNIGHT, MOVE16_EP)),
+              MVMAKE(POS('e', 5), POS('f', 6), POS('f', 5), WPAWN, WPAWN, BPAWN));
+    board_free(b);
+
+    b = board_make(fens[3]);
+    EXPECT_EQ(move16_to_move(b, MV16MAKE(POS('b', 2), POS('a', 1), WKNIGHT, MOVE16_NORMAL)), 0u);
+    EXPECT_EQ(move16_to_move(b, MV16MAKE(POS('b', 2), POS('a', 1), WKNIGHT, MOVE16_PROMO)),
+              MVMAKE(POS('b', 2), POS('a', 1), POS('a', 1), BPAWN, BKNIGHT, WROOK));
+    board_free(b);
+}
+
+TEST(Move16Test, Sequences) {
+    board_t *b = board_make(fens[1]);
+    uint64_t state = 7;
+    const vector<move_t> moves = random_game(*b, 40, state);
+    vector<move16_t> packed(moves.size());
+    move16_pack(moves.data(), moves.size(), packed.data());
+    vector<move_t> unpacked(moves.size());
+    EXPECT_EQ(move16_unpack(b, packed.data(), packed.size(), unpacked.data()), moves.size());
+    EXPECT_EQ(unpacked, moves);
+
+    // a move that cannot be played stops unpacking
+    packed[5] = MV16MAKE(POS('h', 4), POS('h', 5), WKNIGHT, MOVE16_PROMO);
+    EXPECT_EQ(move16_unpack(b, packed.data(), packed.size(), unpacked.data()), 5u);
+
+    move16_hist_free(NULL);
+    board_free(b);
+}
+
+TEST(Move16Test, History) {
+    // a game longer than the initial capacity of histories
+    board_t *b = board_make(STARTING_BOARD);
+    uint64_t state = 3;
+    const vector<move_t> moves = random_game(*b, 300, state);
+    const vector<board_t> boards = game_boards(*b, moves);
+    ASSERT_GT(moves.size(), 200u);
+
+    move16_hist_t *hist = move16_hist_make(b);
+    EXPECT_EQ(move16_hist_pop(hist), 0u);
+    for (move_t move : moves) {
+        move16_hist_push(hist, move);
+    }
+    EXPECT_EQ(hist->len, moves.size());
+    EXPECT_TRUE(same_board(hist->board, boards.back()));
+    vector<move_t> all(hist->len);
+    EXPECT_EQ(move16_hist_moves(hist, all.data()), moves.size());
+    EXPECT_EQ(all, moves);
+
+    // taking moves back replays the game up to them
+    for (size_t i = moves.size(); i > moves.size() - 10; --i) {
+        EXPECT_EQ(move16_hist_pop(hist), moves[i - 1]);
+        EXPECT_TRUE(same_board(hist->board, boards[i - 1]));
+    }
+    move16_hist_push(hist, moves[moves.size() - 10]);
+    EXPECT_EQ(hist->len, moves.size() - 9);
+    EXPECT_TRUE(same_board(hist->board, boards[moves.size() - 9]));
+    move16_hist_free(hist);
+    board_free(b);
+}
@@ -3,7 +3,9 @@ extern "C" {
 }
 
 #include <gtest/gtest.h>
+#include <algorithm>
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <vector>
 #include <map>
@@ -165,6 +167,29 @@ TEST(MoveTest, Print) {
     }
 }
 
+TEST(MoveTest, Uci) {
+    const char *ucis[] = {"e2e4", "b1c3", "f6c3", "a5d5", "b8c8", "e1g1", "e1c1", "e8g8", "e8c8", "f7f8q", "c7b8r",
+                          "d2d1b", "b2a1n", "d5e6", "g4f3"};
+    vector<string> expected(ucis, ucis + sizeof ucis / sizeof *ucis);
+    vector<string> actual;
+    for (auto it = rawCases.begin(); it != rawCases.end(); ++it) {
+        char buf[6];
+#ifdef CHESSLIB_QWORD_MOVE
+        move_t m = move_make(it->first[0], it->first[1], it->first[2], it->first[3], it->first[4], it->first[5]);
+        const size_t len = move_uci(m, buf);
+#else
+        move_t *m = move_make(it->first[0], it->first[1], it->first[2], it->first[3], it->first[4], it->first[5]);
+        const size_t len = move_uci(m, buf);
+        move_free(m);
+#endif
+        EXPECT_EQ(len, strlen(buf));
+        actual.push_back(buf);
+    }
+    std::sort(expected.begin(), expected.end());
+    std::sort(actual.begin(), actual.end());
+    EXPECT_EQ(actual, expected);
+}
+
 TEST(MoveTest, LessThan) {
 #ifdef CHESSLIB_QWORD_MOVE
     move_t m1 = move_make_algnot("Ke1e2");
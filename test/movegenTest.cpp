@@ -40,7 +40,12 @@ static map <string, vector<bool>> endgameCases =
    {{"rnbqkbnr/pp3ppp/2p1p3/3p4/4P3/2N3P1/PPPPQP1P/R1B1KBNR b KQkq -", {false, false}},  // not check
     {"1rbqkbnr/p2Q1ppp/3p4/2p1p3/2P1P3/3P1N2/PP3PPP/RNB1KB1R b KQk -", {false, false}},  // check, not mate
     {"rnb1kbnr/pppp1ppp/8/4p3/6Pq/5P2/PPPPP2P/RNBQKBNR w KQkq -", {true, false}},  // fastest mate
-    {"5bnr/4p1pq/4Qpkr/7p/7P/4P3/PPPP1PP1/RNB1KBNR b KQ -", {false, true}}};  // fastest stalemate
+    {"5bnr/4p1pq/4Qpkr/7p/7P/4P3/PPPP1PP1/RNB1KBNR b KQ -", {false, true}},  // fastest stalemate
+    {"8/8/3k4/8/8/4K3/8/8 w - -", {false, true}},  // king versus king
+    {"8/8/3k4/8/8/4K3/5N2/8 b - -", {false, true}},  // king and knight versus king
+    {"2b5/8/3k4/8/8/4K3/8/5B2 w - -", {false, true}},  // bishops on the same color
+    {"3b4/8/3k4/8/8/4K3/8/5B2 w - -", {false, false}},  // bishops on different colors
+    {"8/8/3k4/8/8/4K3/5R2/8 w - -", {false, false}}};  // king and rook versus king
 
 static map<string, map<uint8_t, vector<bool>>> hitCases =
    {{"2kr1b1r/pppqppp1/2n1bn1p/3P4/3P1B2/2NB1N2/PPP2PPP/R2Q1RK1 b - -",
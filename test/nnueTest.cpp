@@ -0,0 +1,229 @@
+extern "C" {
+#include "defs.h"
+#include "board.h"
+#include "move.h"
+#include "nnue.h"
+}
+#include "testutil.h"
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+static const int HIDDEN = 64;
+static const int L2 = 16;
+
+// a network of random weights, small enough that no sum overflows
+struct Net {
+    vector<int16_t> ft_weights, ft_biases;
+    vector<int8_t> l1_weights, out_weights;
+    vector<int32_t> l1_biases;
+    int32_t out_bias;
+
+    explicit Net(unsigned seed) {
+        std::mt19937 gen(seed);
+        std::uniform_int_distribution<int> w16(-40, 40), b16(-20, 120), w8(-128, 127), b32(-20000, 20000);
+        for (int i = 0; i < NNUE_INPUTS * HIDDEN; ++i) ft_weights.push_back(w16(gen));
+        for (int i = 0; i < HIDDEN; ++i) ft_biases.push_back(b16(gen));
+        for (int i = 0; i < L2 * 2 * HIDDEN; ++i) l1_weights.push_back(w8(gen));
+        for (int i = 0; i < L2; ++i) l1_biases.push_back(b32(gen));
+        for (int i = 0; i < L2; ++i) out_weights.push_back(w8(gen));
+        out_bias = b32(gen);
+    }
+
+    string bytes(int version = NNUE_VERSION) const {
+        string ret = "CLNN";
+        put32(ret, version);
+        put32(ret, HIDDEN);
+        put32(ret, L2);
+        for (int16_t w : ft_weights) put16(ret, w);
+        for (int16_t b : ft_biases) put16(ret, b);
+        ret.append((const char *) l1_weights.data(), l1_weights.size());
+        for (int32_t b : l1_biases) put32(ret, b);
+        ret.append((const char *) out_weights.data(), out_weights.size());
+        put32(ret, out_bias);
+        return ret;
+    }
+
+    // the evaluation of the board, computed from scratch and without the library
+    int evaluate(const board_t *b) const {
+        int acc[2][HIDDEN];
+        for (int p = 0; p < 2; ++p) {
+            std::copy(ft_biases.begin(), ft_biases.end(), acc[p]);
+        }
+        for (int pos = 0; pos < 64; ++pos) {
+            const int pc = (b->ranks[pos / 8] >> (pos % 8 * 4)) & 0xf;
+            if (pc == NOPC) continue;
+            const int black = pc < BPAWN ? pc + 6 : pc - 6;
+            for (int i = 0; i < HIDDEN; ++i) {
+                acc[0][i] += ft_weights[(64 * pc + pos) * HIDDEN + i];
+                acc[1][i] += ft_weights[(64 * black + (pos ^ 56)) * HIDDEN + i];
+            }
+        }
+        const int us = FLAGS_WPLAYER(b->flags) ? 0 : 1;
+        int in[2 * HIDDEN];
+        for (int i = 0; i < HIDDEN; ++i) {
+            in[i] = std::min(std::max(acc[us][i], 0), NNUE_QA);
+            in[HIDDEN + i] = std::min(std::max(acc[!us][i], 0), NNUE_QA);
+        }
+        int out = out_bias;
+        for (int j = 0; j < L2; ++j) {
+            int sum = l1_biases[j];
+            for (int i = 0; i < 2 * HIDDEN; ++i) sum += in[i] * l1_weights[j * 2 * HIDDEN + i];
+            out += std::min(std::max(sum >> NNUE_SHIFT, 0), NNUE_QA) * out_weights[j];
+        }
+        return out / NNUE_SCALE;
+    }
+
+    static void put16(string &s, int v) {
+        s += (char) (v & 0xff);
+        s += (char) ((v >> 8) & 0xff);
+    }
+
+    static void put32(string &s, int v) {
+        put16(s, v & 0xffff);
+        put16(s, (v >> 16) & 0xffff);
+    }
+};
+
+static bool same(const nnue_acc_t &a, const nnue_acc_t &b) {
+    return !memcmp(a.v[0], b.v[0], HIDDEN * 2) && !memcmp(a.v[1], b.v[1], HIDDEN * 2);
+}
+
+class NnueTest : public ::testing::Test {
+    protected:
+        void SetUp() override {
+            file = temp_file("nnue");
+        }
+
+        void TearDown() override {
+            unlink(file.c_str());
+            nnue_set_simd(1);
+        }
+
+        void write(const string &bytes) {
+            FILE *f = fopen(file.c_str(), "wb");
+            ASSERT_TRUE(f);
+            fwrite(bytes.data(), 1, bytes.size(), f);
+            fclose(f);
+        }
+
+        string file;
+};
+
+TEST_F(NnueTest, Load) {
+    const Net net(1);
+    EXPECT_EQ(nnue_load("/nonexistent/net.bin"), nullptr);
+    write(net.bytes(NNUE_VERSION + 1));
+    EXPECT_EQ(nnue_load(file.c_str()), nullptr);
+    write(net.bytes().substr(0, 1000));
+    EXPECT_EQ(nnue_load(file.c_str()), nullptr);
+    write(net.bytes() + "x");
+    EXPECT_EQ(nnue_load(file.c_str()), nullptr);
+    string bytes = net.bytes();
+    bytes[8] = 48;  // not a multiple of 32
+    write(bytes);
+    EXPECT_EQ(nnue_load(file.c_str()), nullptr);
+
+    write(net.bytes());
+    nnue_t *n = nnue_load(file.c_str());
+    ASSERT_NE(n, nullptr);
+    EXPECT_EQ(n->hidden, HIDDEN);
+    EXPECT_EQ(n->l2, L2);
+    EXPECT_EQ(n->ft_weights[5], net.ft_weights[5]);
+    EXPECT_EQ(n->ft_biases[HIDDEN - 1], net.ft_biases[HIDDEN - 1]);
+    EXPECT_EQ(n->out_bias, net.out_bias);
+    nnue_free(n);
+}
+
+TEST_F(NnueTest, Evaluate) {
+    const Net net(2);
+    write(net.bytes());
+    nnue_t *n = nnue_load(file.c_str());
+    ASSERT_NE(n, nullptr);
+    const vector<string> fens = {STARTING_BOARD, "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -",
+                                 "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - -", "4k3/8/8/8/8/8/8/4K3 b - -"};
+    const int simd = nnue_set_simd(1);
+    for (const string &fen : fens) {
+        board_t *b = board_make(fen.c_str());
+        nnue_acc_t acc;
+        nnue_refresh(n, b, &acc);
+        const int expected = net.evaluate(b);
+        EXPECT_EQ(nnue_evaluate(n, b, &acc), expected) << fen;
+        nnue_set_simd(0);
+        nnue_acc_t scalar;
+        nnue_refresh(n, b, &scalar);
+        EXPECT_TRUE(same(acc, scalar)) << fen;
+        EXPECT_EQ(nnue_evaluate(n, b, &scalar), expected) << fen;
+        nnue_set_simd(simd);
+        board_free(b);
+    }
+
+    // the same position with colors swapped and ranks mirrored evaluates the same
+    board_t *w = board_make("4k3/8/8/8/8/2n5/PP6/4K2R w K -");
+    board_t *b = board_make("4k2r/pp6/2N5/8/8/8/8/4K3 b k -");
+    nnue_acc_t wacc, bacc;
+    nnue_refresh(n, w, &wacc);
+    nnue_refresh(n, b, &bacc);
+    EXPECT_EQ(nnue_evaluate(n, w, &wacc), nnue_evaluate(n, b, &bacc));
+    board_free(w);
+    board_free(b);
+    nnue_free(n);
+}
+
+TEST_F(NnueTest, Update) {
+    const Net net(3);
+    write(net.bytes());
+    nnue_t *n = nnue_load(file.c_str());
+    ASSERT_NE(n, nullptr);
+    // castles, captures, en passant and promotions
+    const vector<string> fens = {STARTING_BOARD, "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -",
+                                 "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq -",
+                                 "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ -"};
+    std::mt19937 gen(4);
+    for (int simd = 0; simd < 2; ++simd) {
+        nnue_set_simd(simd);
+        for (const string &fen : fens) {
+            for (int game = 0; game < 20; ++game) {
+                board_t *b = board_make(fen.c_str());
+                nnue_acc_t stack[2];
+                nnue_refresh(n, b, &stack[0]);
+                for (int ply = 0; ply < 40; ++ply) {
+                    move_t moves[BOARD_MOVES_MAX];
+                    const size_t len = board_get_moves_buf(b, moves);
+                    if (!len) break;
+                    const move_t move = moves[gen() % len];
+                    nnue_update(n, &stack[ply & 1], &stack[~ply & 1], move);
+                    board_apply_move(b, move);
+                    nnue_acc_t fresh;
+                    nnue_refresh(n, b, &fresh);
+                    ASSERT_TRUE(same(stack[~ply & 1], fresh)) << fen << " ply " << ply;
+                    ASSERT_EQ(nnue_evaluate(n, b, &stack[~ply & 1]), net.evaluate(b)) << fen << " ply " << ply;
+                }
+                board_free(b);
+            }
+        }
+    }
+
+    // in place
+    board_t *b = board_make(STARTING_BOARD);
+    nnue_acc_t acc, fresh;
+    nnue_refresh(n, b, &acc);
+    move_t moves[BOARD_MOVES_MAX];
+    board_get_moves_buf(b, moves);
+    nnue_update(n, &acc, &acc, moves[0]);
+    board_apply_move(b, moves[0]);
+    nnue_refresh(n, b, &fresh);
+    EXPECT_TRUE(same(acc, fresh));
+    board_free(b);
+    nnue_free(n);
+}
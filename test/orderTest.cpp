@@ -0,0 +1,91 @@
+extern "C" {
+#include "defs.h"
+#include "move.h"
+#include "move16.h"
+#include "order.h"
+}
+
+#include <gtest/gtest.h>
+#include <vector>
+
+using std::vector;
+
+#define QUIET(from, to, pc) MVMAKE(POS(from[0], from[1] - '0'), POS(to[0], to[1] - '0'), NOPOS, pc, pc, NOPC)
+#define CAPTURE(from, to, pc, kill) \
+    MVMAKE(POS(from[0], from[1] - '0'), POS(to[0], to[1] - '0'), POS(to[0], to[1] - '0'), pc, pc, kill)
+
+static const move_t E2E4 = QUIET("e2", "e4", WPAWN);
+static const move_t G1F3 = QUIET("g1", "f3", WKNIGHT);
+static const move_t B1C3 = QUIET("b1", "c3", WKNIGHT);
+static const move_t D1H5 = QUIET("d1", "h5", WQUEEN);
+static const move_t A2A3 = QUIET("a2", "a3", WPAWN);
+static const move_t PXQ = CAPTURE("e4", "d5", WPAWN, BQUEEN);
+static const move_t QXP = CAPTURE("d1", "d5", WQUEEN, BPAWN);
+static const move_t NXP = CAPTURE("c3", "d5", WKNIGHT, BPAWN);
+static const move_t PROMO = MVMAKE(POS('b', 7), POS('b', 8), NOPOS, WPAWN, WQUEEN, NOPC);
+static const move_t E7E5 = QUIET("e7", "e5", BPAWN);
+
+static vector<move_t> ordered(const order_t *order, vector<move_t> moves, move_t pvmove, move_t hashmove, int ply,
+                              move_t prev) {
+    order_moves(order, moves.data(), moves.size(), pvmove, hashmove, ply, prev);
+    return moves;
+}
+
+TEST(OrderTest, Bands) {
+    static order_t order;
+    order_clear(&order);
+    order_update(&order, G1F3, NULL, 0, 3, 2, 0);  // killer at ply 2
+    order_update(&order, B1C3, NULL, 0, 3, 5, E7E5);  // countermove to e7e5, and killer at ply 5
+    order.history[0][POS('a', 2)][POS('a', 3)] = 100;
+
+    const vector<move_t> moves = {E2E4, A2A3, B1C3, QXP, G1F3, NXP, PROMO, PXQ, D1H5};
+    const vector<move_t> expected = {D1H5, E2E4, PXQ, PROMO, NXP, QXP, G1F3, B1C3, A2A3};
+    EXPECT_EQ(ordered(&order, moves, D1H5, E2E4, 2, E7E5), expected);
+
+    // without a pv, hash or countermove, and no killers at the ply, quiet moves go by history, then in order
+    const vector<move_t> plain = {PXQ, PROMO, NXP, QXP, A2A3, B1C3, G1F3, E2E4, D1H5};
+    EXPECT_EQ(ordered(&order, moves, 0, 0, 3, 0), plain);
+}
+
+TEST(OrderTest, Update) {
+    static order_t order;
+    order_clear(&order);
+
+    // killers keep the last two distinct cutoff moves, most recent first
+    order_update(&order, G1F3, NULL, 0, 1, 0, 0);
+    order_update(&order, G1F3, NULL, 0, 1, 0, 0);
+    EXPECT_EQ(order.killers[0][0], move16_make(G1F3));
+    EXPECT_EQ(order.killers[0][1], 0);
+    order_update(&order, B1C3, NULL, 0, 1, 0, 0);
+    EXPECT_EQ(order.killers[0][0], move16_make(B1C3));
+    EXPECT_EQ(order.killers[0][1], move16_make(G1F3));
+
+    // history rewards the cutoff move and penalizes the quiet moves tried before it
+    order_clear(&order);
+    const move_t tried[] = {A2A3, E2E4, G1F3};
+    order_update(&order, G1F3, tried, 3, 4, 1, E7E5);
+    EXPECT_EQ(order.history[0][POS('g', 1)][POS('f', 3)], 16);
+    EXPECT_EQ(order.history[0][POS('a', 2)][POS('a', 3)], -16);
+    EXPECT_EQ(order.history[0][POS('e', 2)][POS('e', 4)], -16);
+    EXPECT_EQ(order.counters[BPAWN][POS('e', 5)], move16_make(G1F3));
+
+    // history saturates below its bound
+    for (int i = 0; i < 10000; ++i) {
+        order_update(&order, G1F3, NULL, 0, 60, 1, 0);
+    }
+    EXPECT_GT(order.history[0][POS('g', 1)][POS('f', 3)], ORDER_HISTORY_MAX / 2);
+    EXPECT_LE(order.history[0][POS('g', 1)][POS('f', 3)], ORDER_HISTORY_MAX);
+
+    // captures and promotions are ordered by value already, and are not recorded
+    order_clear(&order);
+    order_update(&order, NXP, NULL, 0, 4, 1, E7E5);
+    order_update(&order, PROMO, NULL, 0, 4, 1, E7E5);
+    EXPECT_EQ(order.killers[1][0], 0);
+    EXPECT_EQ(order.counters[BPAWN][POS('e', 5)], 0);
+
+    // aging halves history and forgets killers
+    order_update(&order, G1F3, NULL, 0, 4, 1, 0);
+    order_age(&order);
+    EXPECT_EQ(order.history[0][POS('g', 1)][POS('f', 3)], 8);
+    EXPECT_EQ(order.killers[1][0], 0);
+}
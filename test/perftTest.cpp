@@ -1,6 +1,7 @@
 extern "C" {
 #include "defs.h"
 #include "board.h"
+#include "perft.h"
 }
 
 #include <gtest/gtest.h>
@@ -104,6 +105,40 @@ TEST(PerftTest, CorrectnessPerft6) {
     verify_perft_n("r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - -");
 }
 
+TEST(PerftTest, EpdParse) {
+    perft_epd_t epd;
+    EXPECT_EQ(perft_epd_parse("8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - ;D1 14 ;D2 191 ;D3 2812", &epd), 0);
+    EXPECT_STREQ(epd.fen, "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - -");
+    EXPECT_EQ(epd.maxdepth, 3);
+    EXPECT_EQ(epd.counts[0], 0);
+    EXPECT_EQ(epd.counts[1], 14);
+    EXPECT_EQ(epd.counts[2], 191);
+    EXPECT_EQ(epd.counts[3], 2812);
+
+    // halfmove / fullmove fields and non-perft operations are ignored; depths may be sparse
+    EXPECT_EQ(perft_epd_parse(STARTING_BOARD " 0 1 ;id \"start\";D5 4865609 ;D2 400\n", &epd), 0);
+    EXPECT_STREQ(epd.fen, STARTING_BOARD);
+    EXPECT_EQ(epd.maxdepth, 5);
+    EXPECT_EQ(epd.counts[1], 0);
+    EXPECT_EQ(epd.counts[2], 400);
+    EXPECT_EQ(epd.counts[5], 4865609);
+
+    // malformed lines
+    EXPECT_NE(perft_epd_parse("", &epd), 0);
+    EXPECT_NE(perft_epd_parse("8/8/8/8/8/8/8/8 w ;D1 0", &epd), 0);
+    EXPECT_NE(perft_epd_parse(STARTING_BOARD " ;D1", &epd), 0);
+    EXPECT_NE(perft_epd_parse(STARTING_BOARD " ;D99 1", &epd), 0);
+}
+
+TEST(PerftTest, CorrectnessPerftCount) {
+    const uint64_t expected_counts[] = {1, 48, 2039, 97862, 4085603};
+    board_t *board = board_make("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -");
+    for (size_t i = 0; i < (sizeof(expected_counts) / sizeof(expected_counts[0])); ++i) {
+        EXPECT_EQ(perft_count(board, i), expected_counts[i]);
+    }
+    board_free(board);
+}
+
 TEST(PerftTest, SpeedPerft2) {
     const char *fen = "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -";
     board_t *board = board_make(fen);
@@ -0,0 +1,359 @@
+extern "C" {
+#include "defs.h"
+#include "board.h"
+#include "move.h"
+#include "pgn.h"
+}
+#include "testutil.h"
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using std::map;
+using std::string;
+using std::vector;
+
+static string move_uci(move_t move) {
+    static const char promos[] = "pnbrqkpnbrqk";
+    string ret;
+    ret += 'a' + MVFROMPOS(move) % 8;
+    ret += '1' + MVFROMPOS(move) / 8;
+    ret += 'a' + MVTOPOS(move) % 8;
+    ret += '1' + MVTOPOS(move) / 8;
+    if (MVTOPC(move) != MVFROMPC(move)) {
+        ret += promos[MVTOPC(move)];
+    }
+    return ret;
+}
+
+static string san_uci(const char *fen, const char *san) {
+    board_t *b = board_make(fen);
+    const move_t move = pgn_parse_san(b, san, strlen(san));
+    board_free(b);
+    return move ? move_uci(move) : "";
+}
+
+// a game as read, copied out of the callback
+struct Game {
+    size_t offset;
+    map<string, string> tags;
+    string fen;
+    vector<string> moves;
+    int result;
+    int error;
+};
+
+static void collect(void *ctx, const pgn_game_t *game) {
+    static std::mutex lock;
+    Game g;
+    g.offset = game->offset;
+    for (size_t i = 0; i < game->ntags; ++i) {
+        g.tags[game->tags[i].name] = game->tags[i].value;
+    }
+    for (size_t i = 0; i < game->len; ++i) {
+        g.moves.push_back(move_uci(game->moves[i]));
+    }
+    g.result = game->result;
+    g.error = game->error;
+    std::lock_guard<std::mutex> guard(lock);
+    g.fen = board_to_fen(&game->start);  // into a static buffer
+    ((vector<Game> *) ctx)->push_back(g);
+}
+
+static vector<Game> read(const string &text, int threads, pgn_stats_t *stats = NULL) {
+    vector<Game> ret;
+    pgn_read_buf(text.data(), text.size(), threads, collect, &ret, stats);
+    std::sort(ret.begin(), ret.end(), [](const Game &a, const Game &b) { return a.offset < b.offset; });
+    return ret;
+}
+
+TEST(PgnTest, San) {
+    EXPECT_EQ(san_uci(STARTING_BOARD, "e4"), "e2e4");
+    EXPECT_EQ(san_uci(STARTING_BOARD, "Nf3"), "g1f3");
+    EXPECT_EQ(san_uci(STARTING_BOARD, "Ng1-f3"), "g1f3");
+    EXPECT_EQ(san_uci(STARTING_BOARD, "e2e4"), "e2e4");
+    EXPECT_EQ(san_uci(STARTING_BOARD, "e5"), "");
+    EXPECT_EQ(san_uci(STARTING_BOARD, "Nd2"), "");
+    EXPECT_EQ(san_uci(STARTING_BOARD, "Ke2"), "");
+    EXPECT_EQ(san_uci(STARTING_BOARD, ""), "");
+    EXPECT_EQ(san_uci(STARTING_BOARD, "Zz9"), "");
+
+    // disambiguation by file, rank, and both
+    const char *rooks = "4k3/8/8/8/R6R/8/8/R3K3 w - -";
+    EXPECT_EQ(san_uci(rooks, "Rd4"), "");
+    EXPECT_EQ(san_uci(rooks, "Rhd4"), "h4d4");
+    EXPECT_EQ(san_uci(rooks, "Rad4"), "a4d4");
+    EXPECT_EQ(san_uci(rooks, "Ra2"), "");
+    EXPECT_EQ(san_uci(rooks, "R1a2"), "a1a2");
+    EXPECT_EQ(san_uci(rooks, "R4a2"), "a4a2");
+    const char *queens = "4k3/8/8/8/Q1Q5/8/Q7/4K3 w - -";
+    EXPECT_EQ(san_uci(queens, "Qa4b3"), "a4b3");
+    EXPECT_EQ(san_uci(queens, "Qab3"), "");
+    EXPECT_EQ(san_uci(queens, "Q4b3"), "");
+    // a pinned knight needs no disambiguation
+    EXPECT_EQ(san_uci("4k3/4r3/8/8/8/8/2N1N3/4K3 w - -", "Nd4"), "c2d4");
+
+    // castles, promotions, captures and en passant, suffixes
+    const char *castles = "r3k2r/8/8/8/8/8/8/R3K2R w KQkq -";
+    EXPECT_EQ(san_uci(castles, "O-O"), "e1g1");
+    EXPECT_EQ(san_uci(castles, "O-O-O"), "e1c1");
+    EXPECT_EQ(san_uci(castles, "0-0+"), "e1g1");
+    EXPECT_EQ(san_uci(castles, "O-0"), "");
+    EXPECT_EQ(san_uci("r3k2r/8/8/8/8/8/8/R3K2R b KQkq -", "O-O-O"), "e8c8");
+    const char *promos = "1n2k3/P7/8/8/8/8/8/4K3 w - -";
+    EXPECT_EQ(san_uci(promos, "a8=Q"), "a7a8q");
+    EXPECT_EQ(san_uci(promos, "a8N"), "a7a8n");
+    EXPECT_EQ(san_uci(promos, "axb8=r+"), "a7b8r");
+    EXPECT_EQ(san_uci(promos, "a8"), "");
+    EXPECT_EQ(san_uci("4k3/8/8/3pP3/8/8/8/4K3 w - d6", "exd6"), "e5d6");
+    EXPECT_EQ(san_uci("4k3/8/8/3pP3/8/8/8/4K3 w - d6", "exd6e.p."), "");
+    EXPECT_EQ(san_uci(STARTING_BOARD, "Nf3!?"), "g1f3");
+    EXPECT_EQ(san_uci("4k3/8/8/8/8/8/8/R3K3 w - -", "Ra8#"), "a1a8");
+}
+
+TEST(PgnTest, Games) {
+    const string text =
+        "[Event \"Casual \\\"blitz\\\"\"]\n"
+        "[Site \"?\"]\n"
+        "[Result \"1-0\"]\n"
+        "\n"
+        "1. e4 e5 2. Nf3 {a comment (with parens)} Nc6 (2... d6 3. d4 (3. Bc4) exd4) 3. Bb5 $1 a6?!\n"
+        "; a line comment\n"
+        "%escaped line\n"
+        "4.Bxc6 dxc6 5. O-O 1-0\n"
+        "\n"
+        "[Event \"From a position\"]\n"
+        "[FEN \"4k3/P7/8/8/8/8/8/4K3 w - - 0 40\"]\n"
+        "[SetUp \"1\"]\n"
+        "\n"
+        "40. a8=Q+ Kd7 41. Qb7+ *\n"
+        "\n"
+        "[Event \"Result from the tag\"]\n"
+        "[Result \"1/2-1/2\"]\n"
+        "\n"
+        "1. d4 d5\n"
+        "\n"
+        "[Event \"Illegal\"]\n"
+        "\n"
+        "1. e4 e5 2. Ke3 Nc6 0-1\n"
+        "[Event \"Tags only\"]\n";
+    pgn_stats_t stats;
+    const vector<Game> games = read(text, 2, &stats);
+    ASSERT_EQ(games.size(), 5u);
+    EXPECT_EQ(stats.games, 5u);
+    EXPECT_EQ(stats.errors, 1u);
+
+    EXPECT_EQ(games[0].offset, 0u);
+    EXPECT_EQ(games[0].tags.at("Event"), "Casual \"blitz\"");
+    EXPECT_EQ(games[0].tags.at("Site"), "?");
+    EXPECT_EQ(games[0].moves, vector<string>({"e2e4", "e7e5", "g1f3", "b8c6", "f1b5", "a7a6", "b5c6", "d7c6", "e1g1"}));
+    EXPECT_EQ(games[0].result, RESULT_WHITE_WINS);
+    EXPECT_FALSE(games[0].error);
+
+    EXPECT_EQ(text.substr(games[1].offset, 7), "[Event ");
+    EXPECT_EQ(games[1].fen, "4k3/P7/8/8/8/8/8/4K3 w - -");
+    EXPECT_EQ(games[1].moves, vector<string>({"a7a8q", "e8d7", "a8b7"}));
+    EXPECT_EQ(games[1].result, RESULT_UNFINISHED);
+
+    EXPECT_EQ(games[2].moves.size(), 2u);
+    EXPECT_EQ(games[2].result, RESULT_DRAW);
+
+    EXPECT_EQ(games[3].moves, vector<string>({"e2e4", "e7e5"}));
+    EXPECT_TRUE(games[3].error);
+    EXPECT_EQ(games[3].result, RESULT_BLACK_WINS);
+
+    EXPECT_EQ(games[4].tags.at("Event"), "Tags only");
+    EXPECT_TRUE(games[4].moves.empty());
+    EXPECT_EQ(games[4].result, RESULT_UNFINISHED);
+    EXPECT_EQ(stats.moves, 9u + 3 + 2 + 2);
+
+    // movetext alone
+    const vector<Game> bare = read("  1. f3 e5 2. g4 Qh4# 0-1\n", 1);
+    ASSERT_EQ(bare.size(), 1u);
+    EXPECT_EQ(bare[0].moves.size(), 4u);
+    EXPECT_EQ(bare[0].result, RESULT_BLACK_WINS);
+    EXPECT_TRUE(read("", 1).empty());
+    EXPECT_TRUE(read("\n\n{ nothing }\n", 1).empty());
+}
+
+TEST(PgnTest, BadFen) {
+    // FEN tags that are not positions set errors, and leave the games that follow them alone
+    const char *fens[] = {
+        "8/8 w - -",
+        "8/8/8/8/8/8/8/8 w - -",
+        "4k3/8/8/8/8/8/8/4K3 x - -",
+        "4k3/8/8/8/8/8/8/4K3 w -- 0 1",
+        "4k3/4R3/8/8/8/8/8/4K3 w - -",  // the king of the player not to move can be taken
+        "4k3/8/8/8/8/8/8/4K3/8/8/8/8/8/8/8/8/8/8/8/8/8/8/8/8/8/8/8/8/8/8/8/8/8/8/8/8/8/8/8/8/8/8/8/8/8/8 w - -",
+        "",
+    };
+    string text;
+    for (const char *fen : fens) {
+        text += string("[FEN \"") + fen + "\"]\n\n1. e4 *\n\n";
+    }
+    text += "[Event \"Valid\"]\n\n1. d4 *\n";
+    pgn_stats_t stats;
+    const vector<Game> games = read(text, 1, &stats);
+    const size_t n = sizeof fens / sizeof *fens;
+    ASSERT_EQ(games.size(), n + 1);
+    EXPECT_EQ(stats.errors, n);
+    for (size_t i = 0; i < n; ++i) {
+        EXPECT_TRUE(games[i].error) << fens[i];
+        EXPECT_TRUE(games[i].moves.empty()) << fens[i];
+        EXPECT_EQ(games[i].fen, STARTING_BOARD) << fens[i];
+    }
+    EXPECT_FALSE(games[n].error);
+    EXPECT_EQ(games[n].moves, vector<string>({"d2d4"}));
+}
+
+TEST(PgnTest, Chunks) {
+    // games across chunk boundaries, read by one thread and by several
+    const string game =
+        "[Event \"Game\"]\n[Round \"%d\"]\n\n"
+        "1. d4 Nf6 2. c4 e6 3. Nc3 Bb4 4. e3 O-O 5. Bd3 d5 6. Nf3 c5 7. O-O Nc6 8. a3 Bxc3 9. bxc3 dxc4 "
+        "10. Bxc4 Qc7 1/2-1/2\n\n";
+    string text;
+    const int n = 3 * PGN_CHUNK / game.size();
+    char buf[512];
+    for (int i = 0; i < n; ++i) {
+        snprintf(buf, sizeof buf, game.c_str(), i);
+        text += buf;
+    }
+    pgn_stats_t one, many;
+    const vector<Game> a = read(text, 1, &one);
+    const vector<Game> b = read(text, 4, &many);
+    ASSERT_EQ(a.size(), (size_t) n);
+    ASSERT_EQ(b.size(), (size_t) n);
+    EXPECT_EQ(one.moves, 20ULL * n);
+    EXPECT_EQ(many.moves, one.moves);
+    EXPECT_EQ(many.errors, 0u);
+    for (int i = 0; i < n; ++i) {
+        EXPECT_EQ(a[i].offset, b[i].offset);
+        EXPECT_EQ(b[i].tags.at("Round"), std::to_string(i));
+        EXPECT_EQ(b[i].moves.size(), 20u);
+    }
+
+    // from a file
+    const string path = temp_file("pgn", text);
+    vector<Game> c;
+    pgn_stats_t stats;
+    ASSERT_EQ(pgn_read(path.c_str(), 2, collect, &c, &stats), 0);
+    EXPECT_EQ(stats.games, (uint64_t) n);
+    EXPECT_EQ(c.size(), (size_t) n);
+    unlink(path.c_str());
+    EXPECT_NE(pgn_read("/nonexistent/games.pgn", 1, collect, &c, NULL), 0);
+}
+
+static string san(const char *fen, const char *uci) {
+    board_t *b = board_make(fen);
+    move_t moves[BOARD_MOVES_MAX];
+    const size_t len = board_get_moves_buf(b, moves);
+    string ret;
+    for (size_t i = 0; i < len; ++i) {
+        if (move_uci(moves[i]) == uci) {
+            char buf[PGN_SAN_CHARS];
+            const size_t n = pgn_san(b, moves[i], buf);
+            EXPECT_EQ(n, strlen(buf));
+            ret = buf;
+        }
+    }
+    board_free(b);
+    return ret;
+}
+
+TEST(PgnTest, WriteSan) {
+    EXPECT_EQ(san(STARTING_BOARD, "e2e4"), "e4");
+    EXPECT_EQ(san(STARTING_BOARD, "g1f3"), "Nf3");
+    const char *rooks = "4k3/8/8/8/R6R/8/8/R3K3 w - -";
+    EXPECT_EQ(san(rooks, "h4d4"), "Rhd4");
+    EXPECT_EQ(san(rooks, "a1a2"), "R1a2");
+    EXPECT_EQ(san(rooks, "a4a2"), "R4a2");
+    EXPECT_EQ(san(rooks, "h4h8"), "Rh8+");
+    EXPECT_EQ(san("4k3/8/8/8/Q1Q5/8/Q7/4K3 w - -", "a4b3"), "Qa4b3");
+    EXPECT_EQ(san("4k3/4r3/8/8/8/8/2N1N3/4K3 w - -", "c2d4"), "Nd4");
+    EXPECT_EQ(san("4k3/8/8/8/8/8/2N1N3/4K3 w - -", "c2d4"), "Ncd4");
+    EXPECT_EQ(san("r3k2r/8/8/8/8/8/8/R3K2R w KQkq -", "e1g1"), "O-O");
+    EXPECT_EQ(san("r3k2r/8/8/8/8/8/8/R3K2R b KQkq -", "e8c8"), "O-O-O");
+    EXPECT_EQ(san("1n2k3/P7/8/8/8/8/8/4K3 w - -", "a7b8q"), "axb8=Q+");
+    EXPECT_EQ(san("1n2k3/P7/8/8/8/8/8/4K3 w - -", "a7a8n"), "a8=N");
+    EXPECT_EQ(san("4k3/8/8/3pP3/8/8/8/4K3 w - d6", "e5d6"), "exd6");
+    EXPECT_EQ(san("4k3/8/8/8/8/8/8/R3K3 w - -", "a1a8"), "Ra8+");
+    EXPECT_EQ(san("6k1/5ppp/8/8/8/8/8/R3K3 w - -", "a1a8"), "Ra8#");
+    EXPECT_EQ(san("6k1/5pp1/8/8/8/8/8/R3K3 w - -", "a1a8"), "Ra8+");
+
+    // random games: SAN reads back as the same move, with the minimal disambiguation and the right suffix
+    const vector<string> fens = {STARTING_BOARD, "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -",
+                                 "4k3/8/3Q1Q2/8/3Q1Q2/8/8/4K3 w - -", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - -"};
+    uint64_t rng = 1;
+    for (const string &fen : fens) {
+        for (int game = 0; game < 20; ++game) {
+            board_t *b = board_make(fen.c_str());
+            vector<move_t> played;
+            for (int ply = 0; ply < 60; ++ply) {
+                move_t moves[BOARD_MOVES_MAX];
+                const size_t len = board_get_moves_buf(b, moves);
+                if (!len) break;
+                const move_t move = random_move(moves, len, rng);
+                char buf[PGN_SAN_CHARS];
+                const size_t n = pgn_san(b, move, buf);
+                ASSERT_EQ(pgn_parse_san(b, buf, n), move) << buf;
+                int same = 0, file = 0, rank = 0;
+                for (size_t i = 0; i < len; ++i) {
+                    if (moves[i] != move && MVFROMPC(moves[i]) == MVFROMPC(move) && MVTOPOS(moves[i]) == MVTOPOS(move)
+                        && MVTOPC(moves[i]) == MVTOPC(move) && MVFROMPC(move) % BPAWN != WPAWN) {
+                        ++same;
+                        file |= MVFROMPOS(moves[i]) % 8 == MVFROMPOS(move) % 8;
+                        rank |= MVFROMPOS(moves[i]) / 8 == MVFROMPOS(move) / 8;
+                    }
+                }
+                const size_t disambiguation = !same ? 0 : file && rank ? 2 : 1;
+                const string s = buf;
+                const size_t core = (s.find('x') != string::npos) + 3 + (s.back() == '+' || s.back() == '#');
+                if (!move_is_castle(move) && MVFROMPC(move) % BPAWN != WPAWN) {
+                    EXPECT_EQ(n, core + disambiguation) << buf;
+                }
+                board_apply_move(b, move);
+                EXPECT_EQ(s.back() == '#', board_is_mate(b) != 0) << buf;
+                played.push_back(move);
+            }
+            board_free(b);
+
+            // the movetext reads back as the same game
+            b = board_make(fen.c_str());
+            vector<char> text(played.size() * PGN_MOVE_CHARS + 1);
+            const size_t n = pgn_write_moves(b, played.data(), played.size(), text.data());
+            EXPECT_EQ(n, strlen(text.data()));
+            const vector<Game> games = read("[FEN \"" + fen + "\"]\n\n" + text.data(), 1);
+            ASSERT_EQ(games.size(), 1u);
+            EXPECT_EQ(games[0].moves.size(), played.size()) << text.data();
+            board_free(b);
+        }
+    }
+}
+
+TEST(PgnTest, WriteMoves) {
+    board_t *b = board_make(STARTING_BOARD);
+    const char *sans[] = {"e4", "e5", "Nf3"};
+    move_t moves[3];
+    board_t cur = *b;
+    for (int i = 0; i < 3; ++i) {
+        moves[i] = pgn_parse_san(&cur, sans[i], strlen(sans[i]));
+        board_apply_move(&cur, moves[i]);
+    }
+    char buf[3 * PGN_MOVE_CHARS + 1];
+    pgn_write_moves(b, moves, 3, buf);
+    EXPECT_STREQ(buf, "1. e4 e5 2. Nf3");
+    board_apply_move(b, moves[0]);
+    pgn_write_moves(b, &moves[1], 2, buf);
+    EXPECT_STREQ(buf, "1... e5 2. Nf3");
+    pgn_write_moves(b, moves, 0, buf);
+    EXPECT_STREQ(buf, "");
+    board_free(b);
+}
@@ -0,0 +1,112 @@
+extern "C" {
+#include "defs.h"
+#include "board.h"
+#include "move.h"
+#include "playout.h"
+}
+
+#include <gtest/gtest.h>
+#include <map>
+#include <string>
+#include <vector>
+
+using std::map;
+using std::string;
+using std::vector;
+
+TEST(PlayoutTest, Move) {
+    // pinned pieces and a king in check leave many pseudo-legal moves illegal
+    const vector<string> fens = {STARTING_BOARD, "4k3/8/8/8/1b6/8/3N4/4K3 w - -", "4k3/8/8/8/8/8/3N4/r3K2R w K -",
+                                 "4k3/8/8/8/4r3/8/3NB3/R3K2R w KQ -"};
+    uint64_t rng = 1;
+    for (const string &fen : fens) {
+        board_t *b = board_make(fen.c_str());
+        move_t moves[BOARD_MOVES_MAX];
+        const size_t len = board_get_moves_buf(b, moves);
+        map<move_t, int> counts;
+        const int draws = 2000 * len;
+        for (int i = 0; i < draws; ++i) {
+            ++counts[playout_move(b, &rng, NULL)];
+        }
+        EXPECT_EQ(counts.size(), len) << fen;
+        for (size_t i = 0; i < len; ++i) {  // uniform: 2000 each, within 5 standard deviations
+            EXPECT_NEAR(counts[moves[i]], 2000, 5 * 44.7) << fen;
+        }
+        board_free(b);
+    }
+
+    board_t *b = board_make("k7/8/1K6/8/8/8/8/6Q1 b - -");
+    int incheck = 1;
+    EXPECT_NE(playout_move(b, &rng, &incheck), 0u);
+    board_free(b);
+    b = board_make("k5Q1/8/1K6/8/8/8/8/8 b - -");
+    EXPECT_EQ(playout_move(b, &rng, &incheck), 0u);
+    EXPECT_TRUE(incheck);
+    board_free(b);
+    b = board_make("k7/2Q5/1K6/8/8/8/8/8 b - -");
+    EXPECT_EQ(playout_move(b, &rng, &incheck), 0u);
+    EXPECT_FALSE(incheck);
+    board_free(b);
+}
+
+TEST(PlayoutTest, Playout) {
+    board_t *b = board_make(STARTING_BOARD);
+    uint64_t rng = 7;
+    int counts[4] = {0, 0, 0, 0};
+    for (int i = 0; i < 500; ++i) {
+        int plies = -1;
+        const int result = playout(b, 1000, &rng, &plies);
+        ASSERT_GE(result, RESULT_DRAW);
+        ASSERT_LE(result, RESULT_UNFINISHED);
+        EXPECT_GT(plies, 0);
+        EXPECT_LE(plies, 1000);
+        ++counts[result];
+    }
+    EXPECT_GT(counts[RESULT_DRAW], 0);
+    EXPECT_GT(counts[RESULT_WHITE_WINS], 0);
+    EXPECT_GT(counts[RESULT_BLACK_WINS], 0);
+
+    // the same state plays the same game
+    uint64_t a = 99, c = 99;
+    int pa, pc;
+    EXPECT_EQ(playout(b, 1000, &a, &pa), playout(b, 1000, &c, &pc));
+    EXPECT_EQ(pa, pc);
+    EXPECT_EQ(a, c);
+
+    int plies = -1;
+    EXPECT_EQ(playout(b, 10, &rng, &plies), RESULT_UNFINISHED);
+    EXPECT_EQ(plies, 10);
+    EXPECT_EQ(playout(b, 0, &rng, &plies), RESULT_UNFINISHED);
+    EXPECT_EQ(plies, 0);
+    board_free(b);
+
+    // ends: mate, stalemate, insufficient material, and the fifty-move rule
+    b = board_make("k5Q1/8/1K6/8/8/8/8/8 b - -");
+    EXPECT_EQ(playout(b, 100, &rng, &plies), RESULT_WHITE_WINS);
+    EXPECT_EQ(plies, 0);
+    board_free(b);
+    b = board_make("k7/2Q5/1K6/8/8/8/8/8 b - -");
+    EXPECT_EQ(playout(b, 100, &rng, &plies), RESULT_DRAW);
+    EXPECT_EQ(plies, 0);
+    board_free(b);
+    b = board_make("k7/8/8/8/8/8/5B2/K1b5 w - -");  // bishops on the same color
+    EXPECT_EQ(playout(b, 100, &rng, NULL), RESULT_DRAW);
+    board_free(b);
+    b = board_make("k7/8/8/8/8/8/8/K6n w - -");
+    EXPECT_EQ(playout(b, 100, &rng, &plies), RESULT_DRAW);
+    EXPECT_EQ(plies, 0);
+    board_free(b);
+    b = board_make("k7/8/8/8/8/8/1q6/K7 w - -");  // the queen is taken
+    EXPECT_EQ(playout(b, 100, &rng, &plies), RESULT_DRAW);
+    EXPECT_EQ(plies, 1);
+    board_free(b);
+    b = board_make("7k/8/8/8/8/8/R7/K7 w - -");  // a rook: mated, taken, or the fifty-move rule
+    int fifty = 0;
+    for (int i = 0; i < 100; ++i) {
+        const int result = playout(b, 1000, &rng, &plies);
+        EXPECT_LE(plies, 100);
+        fifty += result == RESULT_DRAW && plies == 100;
+    }
+    EXPECT_GT(fifty, 0);
+    board_free(b);
+}
@@ -0,0 +1,297 @@
+extern "C" {
+#include "defs.h"
+#include "board.h"
+#include "move.h"
+#include "alloc.h"
+#include "search.h"
+}
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <thread>
+
+#define FEN_KIWIPETE "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -"
+#define FEN_BACK_RANK "6k1/5ppp/8/8/8/8/5PPP/R5K1 w - -"
+#define FEN_HANGING_QUEEN "4k3/8/8/3q4/8/8/3R4/4K3 w - -"
+#define FEN_MATED "rnb1kbnr/pppp1ppp/8/4p3/5PPq/8/PPPPP2P/RNBQKBNR w KQkq -"
+#define FEN_STALEMATED "7k/5Q2/6K1/8/8/8/8/8 b - -"
+#define FEN_DEFENDED_ROOK "4k3/8/4p3/3q4/8/8/3R4/4K3 w - -"
+#define FEN_POISONED_PAWN "4k3/8/4p3/3p4/8/8/3Q4/4K3 w - -"
+#define FEN_XRAY "3rk3/8/8/3p4/8/8/3R4/3RK3 w - -"
+
+static search_limits_t makeLimits(int depth, uint64_t nodes, uint64_t movetime_ms, tt_t *tt = NULL, int threads = 1) {
+    search_limits_t limits = {depth, nodes, movetime_ms, tt, threads, NULL, 0};
+    return limits;
+}
+
+static int isLegal(const board_t *board, move_t move) {
+    move_t moves[BOARD_MOVES_MAX];
+    size_t len = board_get_moves_buf(board, moves);
+    for (size_t i = 0; i < len; ++i) {
+        if (moves[i] == move) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+TEST(SearchTest, MateInOne) {
+    board_t *b = board_make(FEN_BACK_RANK);
+    search_limits_t limits = makeLimits(4, 0, 0);
+    search_result_t result;
+    ASSERT_EQ(search(b, &limits, &result), 0);
+    EXPECT_EQ(result.best, move_make_algnot("Ra1a8"));
+    EXPECT_EQ(result.score, SEARCH_MATE - 1);
+    EXPECT_EQ(result.depth, 1);  // the quiescence search sees the mate, and the search stops once it is found
+    board_free(b);
+}
+
+TEST(SearchTest, WinsMaterial) {
+    board_t *b = board_make(FEN_HANGING_QUEEN);
+    search_limits_t limits = makeLimits(3, 0, 0);
+    search_result_t result;
+    ASSERT_EQ(search(b, &limits, &result), 0);
+    EXPECT_EQ(result.best, move_make_algnot("Rd2xqd5"));
+    EXPECT_GT(result.score, 300);  // up a rook
+    EXPECT_EQ(result.depth, 3);
+    board_free(b);
+}
+
+TEST(SearchTest, NoMoves) {
+    search_limits_t limits = makeLimits(3, 0, 0);
+    search_result_t result;
+    board_t *b = board_make(FEN_MATED);
+    EXPECT_NE(search(b, &limits, &result), 0);
+    EXPECT_EQ(result.score, -SEARCH_MATE);
+    board_free(b);
+    b = board_make(FEN_STALEMATED);
+    EXPECT_NE(search(b, &limits, &result), 0);
+    EXPECT_EQ(result.score, 0);
+    board_free(b);
+}
+
+TEST(SearchTest, PrincipalVariation) {
+    board_t *b = board_make(FEN_KIWIPETE);
+    search_limits_t limits = makeLimits(4, 0, 0);
+    search_result_t result;
+    ASSERT_EQ(search(b, &limits, &result), 0);
+    EXPECT_EQ(result.depth, 4);
+    ASSERT_EQ(result.pvlen, 4);
+    EXPECT_EQ(result.pv[0], result.best);
+    board_t cur = *b;
+    for (int i = 0; i < result.pvlen; ++i) {
+        ASSERT_TRUE(isLegal(&cur, result.pv[i]));
+        board_apply_move(&cur, result.pv[i]);
+    }
+    board_free(b);
+}
+
+TEST(SearchTest, NodeLimit) {
+    board_t *b = board_make(FEN_KIWIPETE);
+    search_limits_t limits = makeLimits(0, 5000, 0);
+    search_result_t result;
+    ASSERT_EQ(search(b, &limits, &result), 0);
+    EXPECT_GE(result.depth, 1);
+    EXPECT_EQ(result.nodes, 5000u);
+    EXPECT_TRUE(isLegal(b, result.best));
+
+    limits.nodes = 1;  // the first iteration still completes
+    ASSERT_EQ(search(b, &limits, &result), 0);
+    EXPECT_EQ(result.depth, 1);
+    EXPECT_GE(result.nodes, 49u);  // root, its 48 children, and their captures
+    EXPECT_TRUE(isLegal(b, result.best));
+    board_free(b);
+}
+
+TEST(SearchTest, TimeLimit) {
+    board_t *b = board_make(FEN_KIWIPETE);
+    search_limits_t limits = makeLimits(0, 0, 50);
+    search_result_t result;
+    ASSERT_EQ(search(b, &limits, &result), 0);
+    EXPECT_GE(result.depth, 1);
+    EXPECT_LT(result.time_ms, 500u);
+    EXPECT_TRUE(isLegal(b, result.best));
+    board_free(b);
+}
+
+TEST(SearchTest, Deadline) {
+    // the hard limit is kept to within a poll interval, wherever it falls
+    board_t *b = board_make(FEN_KIWIPETE);
+    tt_t *tt = tt_make(16, 0);
+    for (uint64_t ms = 5; ms <= 45; ms += 10) {
+        search_limits_t limits = makeLimits(0, 0, ms, tt);
+        search_result_t result;
+        ASSERT_EQ(search(b, &limits, &result), 0);
+        EXPECT_LE(result.time_ms, ms + 5);
+    }
+
+    // no iteration starts after the soft limit, and those under way stop at the hard limit
+    search_limits_t limits = makeLimits(0, 0, 200, tt);
+    limits.softtime_ms = 10;
+    search_result_t result;
+    ASSERT_EQ(search(b, &limits, &result), 0);
+    EXPECT_LE(result.time_ms, 205u);
+    EXPECT_GE(result.depth, 1);
+    tt_free(tt);
+    board_free(b);
+}
+
+TEST(SearchTest, Clock) {
+    search_limits_t limits = makeLimits(0, 0, 0);
+    search_limits_clock(&limits, 60000, 0, 0, 50);  // sudden death: a share of the time left
+    EXPECT_EQ(limits.softtime_ms, 59950u / 30);
+    EXPECT_EQ(limits.movetime_ms, 59950u / 30 * 4);
+
+    search_limits_clock(&limits, 60000, 0, 10, 50);  // ten moves to go
+    EXPECT_EQ(limits.softtime_ms, 5995u);
+    EXPECT_EQ(limits.movetime_ms, 5995u * 4);
+
+    search_limits_clock(&limits, 1000, 0, 1, 50);  // the last move before the time control
+    EXPECT_EQ(limits.softtime_ms, 950u);
+    EXPECT_EQ(limits.movetime_ms, 950u);
+
+    search_limits_clock(&limits, 1000, 2000, 0, 50);  // the increment does not overdraw the clock
+    EXPECT_EQ(limits.movetime_ms, 950u * 4 / 5);
+    EXPECT_EQ(limits.softtime_ms, limits.movetime_ms);
+
+    search_limits_clock(&limits, 10, 0, 0, 50);  // flagging anyway
+    EXPECT_EQ(limits.softtime_ms, 1u);
+    EXPECT_EQ(limits.movetime_ms, 1u);
+}
+
+TEST(SearchTest, NoAllocations) {
+    board_t *b = board_make(FEN_KIWIPETE);
+    search_limits_t limits = makeLimits(3, 0, 0);
+    search_result_t result;
+    alloc_forbid(1);
+    EXPECT_EQ(search(b, &limits, &result), 0);
+    alloc_forbid(0);
+    board_free(b);
+}
+
+TEST(SearchTest, TranspositionTable) {
+    board_t *b = board_make(FEN_KIWIPETE);
+    tt_t *tt = tt_make(16, 0);
+    search_limits_t limits = makeLimits(5, 0, 0, tt);
+    search_result_t first, second, plain;
+    ASSERT_EQ(search(b, &limits, &first), 0);
+    EXPECT_TRUE(isLegal(b, first.best));
+    EXPECT_GT(tt_hashfull(tt), 0);
+
+    // a repeated search is answered mostly from the table
+    ASSERT_EQ(search(b, &limits, &second), 0);
+    EXPECT_LT(second.nodes, first.nodes / 2);
+    EXPECT_EQ(second.best, first.best);
+
+    limits.tt = NULL;
+    ASSERT_EQ(search(b, &limits, &plain), 0);
+    EXPECT_LT(first.nodes, plain.nodes);
+    tt_free(tt);
+    board_free(b);
+
+    // mate scores are relative to the root, wherever they are found
+    b = board_make(FEN_BACK_RANK);
+    tt = tt_make(1, 0);
+    limits = makeLimits(4, 0, 0, tt);
+    ASSERT_EQ(search(b, &limits, &first), 0);
+    ASSERT_EQ(search(b, &limits, &second), 0);
+    EXPECT_EQ(second.score, SEARCH_MATE - 1);
+    EXPECT_EQ(second.best, move_make_algnot("Ra1a8"));
+    tt_free(tt);
+    board_free(b);
+}
+
+TEST(SearchTest, Threads) {
+    board_t *b = board_make(FEN_KIWIPETE);
+    tt_t *tt = tt_make(16, 0);
+    search_limits_t limits = makeLimits(5, 0, 0, tt, 4);
+    search_result_t result;
+    ASSERT_EQ(search(b, &limits, &result), 0);
+    EXPECT_GE(result.depth, 5);
+    EXPECT_TRUE(isLegal(b, result.best));
+    board_t cur = *b;
+    for (int i = 0; i < result.pvlen; ++i) {
+        ASSERT_TRUE(isLegal(&cur, result.pv[i]));
+        board_apply_move(&cur, result.pv[i]);
+    }
+
+    // nodes of all threads count towards the limit, which they reach exactly
+    tt_clear(tt);
+    limits = makeLimits(0, 100000, 0, tt, 4);
+    ASSERT_EQ(search(b, &limits, &result), 0);
+    EXPECT_EQ(result.nodes, 100000u);
+    tt_free(tt);
+    board_free(b);
+}
+
+TEST(SearchTest, StopFlag) {
+    board_t *b = board_make(FEN_KIWIPETE);
+    tt_t *tt = tt_make(16, 0);
+    int stop = 0;
+    search_limits_t limits = makeLimits(0, 0, 0, tt, 2);
+    limits.stop = &stop;
+    std::thread stopper([&stop]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        search_signal(&stop);
+    });
+    search_result_t result;
+    ASSERT_EQ(search(b, &limits, &result), 0);
+    stopper.join();
+    EXPECT_LT(result.time_ms, 1000u);
+    EXPECT_GE(result.depth, 1);
+    EXPECT_TRUE(isLegal(b, result.best));
+    tt_free(tt);
+    board_free(b);
+}
+
+TEST(SearchTest, StaticExchange) {
+    const struct {
+        const char *fen;
+        const char *move;
+        int see;
+    } cases[] = {{FEN_HANGING_QUEEN, "Rd2xqd5", 900},
+                 {FEN_DEFENDED_ROOK, "Rd2xqd5", 900 - 500},
+                 {FEN_POISONED_PAWN, "Qd2xpd5", 100 - 900},
+                 {FEN_XRAY, "Rd2xpd5", 100},  // the rook behind joins in
+                 {"4k3/1P6/8/8/8/8/8/4K3 w - -", "Pb7b8Q", 900 - 100},
+                 {"4k3/8/8/3p4/8/8/4P3/4K3 w - -", "Pe2e4", -100},  // takes nothing, then is taken
+                 {"4k3/8/8/8/8/8/4P3/4K3 w - -", "Pe2e4", 0}};
+    for (auto &c : cases) {
+        board_t *b = board_make(c.fen);
+        EXPECT_EQ(search_see(b, move_make_algnot(c.move)), c.see) << c.fen << " " << c.move;
+        board_free(b);
+    }
+}
+
+TEST(SearchTest, Quiesce) {
+    uint64_t nodes;
+    board_t *b = board_make(STARTING_BOARD);  // quiet
+    EXPECT_EQ(search_quiesce(b, -SEARCH_INF, SEARCH_INF, &nodes), eval_board(b));
+    EXPECT_EQ(nodes, 1u);
+    board_free(b);
+
+    b = board_make(FEN_HANGING_QUEEN);
+    const int standpat = eval_board(b);
+    EXPECT_GT(search_quiesce(b, -SEARCH_INF, SEARCH_INF, &nodes), standpat + 800);
+    EXPECT_GT(nodes, 1u);
+    board_free(b);
+
+    b = board_make(FEN_POISONED_PAWN);  // the only capture loses the queen, and is pruned
+    EXPECT_EQ(search_quiesce(b, -SEARCH_INF, SEARCH_INF, &nodes), eval_board(b));
+    EXPECT_EQ(nodes, 1u);
+    board_free(b);
+
+    b = board_make(FEN_MATED);
+    EXPECT_EQ(search_quiesce(b, -SEARCH_INF, SEARCH_INF, NULL), -SEARCH_MATE);
+    board_free(b);
+}
+
+TEST(SearchTest, Horizon) {
+    // a one ply search sees the recapture
+    board_t *b = board_make(FEN_POISONED_PAWN);
+    search_limits_t limits = makeLimits(1, 0, 0);
+    search_result_t result;
+    ASSERT_EQ(search(b, &limits, &result), 0);
+    EXPECT_NE(result.best, move_make_algnot("Qd2xpd5"));
+    board_free(b);
+}
@@ -0,0 +1,122 @@
+extern "C" {
+#include "defs.h"
+#include "board.h"
+#include "stats.h"
+}
+
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <thread>
+
+// unit test objects are built with CHESSLIB_STATS
+
+static void freeMoves(alst_t *moves) {
+#ifdef CHESSLIB_QWORD_MOVE
+    alst_free(moves, NULL);
+#else
+    alst_free(moves, (void (*) (void *)) move_free);
+#endif
+}
+
+TEST(StatsTest, Reset) {
+    board_t *b = board_make(STARTING_BOARD);
+    freeMoves(board_get_moves(b));
+    board_free(b);
+
+    stats_t stats;
+    stats_reset();
+    stats_snapshot(&stats);
+    EXPECT_EQ(stats.get_moves, 0u);
+    EXPECT_EQ(stats.pseudo, 0u);
+    EXPECT_EQ(stats.rejected, 0u);
+    EXPECT_EQ(stats.hit, 0u);
+    EXPECT_EQ(stats.copy, 0u);
+    EXPECT_EQ(stats.apply, 0u);
+    EXPECT_EQ(stats.gen_cycles, 0u);
+    EXPECT_EQ(stats.filter_cycles, 0u);
+    for (int i = 0; i < 6; ++i) {
+        EXPECT_EQ(stats.gen[i], 0u);
+    }
+}
+
+TEST(StatsTest, GeneratorCalls) {
+    board_t *b = board_make(STARTING_BOARD);
+    stats_reset();
+    freeMoves(board_get_moves(b));
+    board_free(b);
+
+    stats_t stats;
+    stats_snapshot(&stats);
+    EXPECT_EQ(stats.get_moves, 1u);
+    EXPECT_EQ(stats.gen[WPAWN], 8u);
+    EXPECT_EQ(stats.gen[WKNIGHT], 2u);
+    EXPECT_EQ(stats.gen[WBISHOP], 2u);
+    EXPECT_EQ(stats.gen[WROOK], 2u);
+    EXPECT_EQ(stats.gen[WQUEEN], 1u);
+    EXPECT_EQ(stats.gen[WKING], 1u);
+    EXPECT_EQ(stats.pseudo, 20u);
+    EXPECT_EQ(stats.rejected, 0u);
+    EXPECT_GE(stats.hit, 20u);  // at least one legality check per pseudo-legal move
+    EXPECT_GT(stats.gen_cycles, 0u);
+    EXPECT_GT(stats.filter_cycles, 0u);
+}
+
+TEST(StatsTest, Rejected) {
+    // white king on e1 in check from the rook on e8; only the king moves off the e file are legal
+    board_t *b = board_make("4r2k/8/8/8/8/8/8/R3K3 w - -");
+    stats_reset();
+    alst_t *moves = board_get_moves(b);
+    size_t legal = moves->len;
+    freeMoves(moves);
+    board_free(b);
+
+    stats_t stats;
+    stats_snapshot(&stats);
+    EXPECT_EQ(legal, 4u);
+    EXPECT_EQ(stats.gen[WPAWN], 0u);
+    EXPECT_EQ(stats.gen[WROOK], 1u);
+    EXPECT_EQ(stats.gen[WKING], 1u);
+    EXPECT_EQ(stats.pseudo - stats.rejected, legal);
+    EXPECT_GT(stats.rejected, 0u);
+}
+
+TEST(StatsTest, CopyAndApply) {
+    board_t *b = board_make(STARTING_BOARD);
+    stats_reset();
+    board_t *c1 = board_copy(b);
+    board_t *c2 = board_copy(b);
+#ifdef CHESSLIB_QWORD_MOVE
+    board_apply_move(c1, move_make(POS('e', 2), POS('e', 4), NOPOS, WPAWN, WPAWN, NOPC));
+#else
+    move_t *move = move_make(POS('e', 2), POS('e', 4), NOPOS, WPAWN, WPAWN, NOPC);
+    board_apply_move(c1, move);
+    move_free(move);
+#endif
+
+    stats_t stats;
+    stats_snapshot(&stats);
+    EXPECT_EQ(stats.copy, 2u);
+    EXPECT_EQ(stats.apply, 1u);
+    EXPECT_EQ(stats.get_moves, 0u);
+    board_free(b);
+    board_free(c1);
+    board_free(c2);
+}
+
+TEST(StatsTest, PerThread) {
+    stats_reset();
+    std::thread other([]() {
+        board_t *b = board_make(STARTING_BOARD);
+        freeMoves(board_get_moves(b));
+        board_free(b);
+        stats_t stats;
+        stats_snapshot(&stats);
+        EXPECT_EQ(stats.get_moves, 1u);
+    });
+    other.join();
+
+    stats_t stats;
+    stats_snapshot(&stats);
+    EXPECT_EQ(stats.get_moves, 0u);
+    EXPECT_EQ(stats.pseudo, 0u);
+}
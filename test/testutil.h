@@ -0,0 +1,81 @@
+#pragma once
+
+// helpers shared by the tests
+
+extern "C" {
+#include "defs.h"
+#include "board.h"
+#include "move.h"
+}
+
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+// whether two boards hold the same position, with the same hash and evaluation
+static inline bool same_board(const board_t &a, const board_t &b) {
+    return !memcmp(a.ranks, b.ranks, sizeof(a.ranks)) && a.flags == b.flags && a.hash == b.hash && a.mg == b.mg
+        && a.eg == b.eg && a.phase == b.phase;
+}
+
+// advances the LCG state (state) and returns its high bits
+static inline uint64_t test_rand(uint64_t &state) {
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return state >> 33;
+}
+
+// one of the (len) moves of (moves), drawn from (state)
+static inline move_t random_move(const move_t *moves, size_t len, uint64_t &state) {
+    return moves[test_rand(state) % len];
+}
+
+// the moves of a random game from (start), of at most (plies) plies, drawn from (state)
+static inline std::vector<move_t> random_game(const board_t &start, size_t plies, uint64_t &state) {
+    std::vector<move_t> ret;
+    board_t board = start;
+    while (ret.size() < plies) {
+        move_t moves[BOARD_MOVES_MAX];
+        const size_t len = board_get_moves_buf(&board, moves);
+        if (!len) {
+            break;
+        }
+        ret.push_back(random_move(moves, len, state));
+        board_apply_move(&board, ret.back());
+    }
+    return ret;
+}
+
+// the boards along the game of (moves) from (start), from (start) to the last
+static inline std::vector<board_t> game_boards(const board_t &start, const std::vector<move_t> &moves) {
+    std::vector<board_t> ret = {start};
+    for (move_t move : moves) {
+        ret.push_back(ret.back());
+        board_apply_move(&ret.back(), move);
+    }
+    return ret;
+}
+
+// the board of a FEN
+static inline board_t fen_board(const char *fen) {
+    board_t *b = board_make(fen);
+    const board_t ret = *b;
+    board_free(b);
+    return ret;
+}
+
+// creates a temporary file holding (contents), of a name starting with (name), and returns its path
+static inline std::string temp_file(const char *name, const std::string &contents = "") {
+    std::string path = std::string("/tmp/chesslib_") + name + "XXXXXX";
+    const int fd = mkstemp(&path[0]);
+    if (fd < 0) {
+        ADD_FAILURE() << "cannot create " << path;
+        return path;
+    }
+    EXPECT_EQ(write(fd, contents.data(), contents.size()), (ssize_t) contents.size()) << path;
+    close(fd);
+    return path;
+}
@@ -0,0 +1,201 @@
+extern "C" {
+#include "defs.h"
+#include "board.h"
+#include "trace.h"
+}
+
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+// unit test objects are built with CHESSLIB_TRACE
+
+#define FEN_CHECK "rnb1kbnr/pppp1ppp/8/4p3/5PPq/8/PPPPP2P/RNBQKBNR w KQkq -"
+
+static std::string tracePath() {
+    return ::testing::TempDir() + "chesslib_trace.bin";
+}
+
+static std::string readTrace() {
+    std::ifstream in(tracePath(), std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+static uint32_t read32(const std::string &trace, size_t i) {
+    const unsigned char *p = (const unsigned char *) trace.data() + i;
+    return (uint32_t) p[0] | (uint32_t) p[1] << 8 | (uint32_t) p[2] << 16 | (uint32_t) p[3] << 24;
+}
+
+// returns the (op, board id) of every record in the trace, or an empty list if it is malformed
+static std::vector<std::pair<int, uint32_t>> parseTrace(const std::string &trace) {
+    std::vector<std::pair<int, uint32_t>> ret;
+    if (trace.compare(0, 8, TRACE_MAGIC) || read32(trace, 8) != TRACE_BOARD) {
+        return ret;
+    }
+    size_t i = TRACE_HEADER;
+    auto id = [&]() {
+        uint32_t id = read32(trace, i);
+        i += sizeof id;
+        if (!id) {
+            i += TRACE_BOARD;
+        }
+        return id;
+    };
+    while (i < trace.size()) {
+        int op = trace[i++];
+        if (op == TRACE_MAKE) {
+            uint32_t made = read32(trace, i);
+            i += sizeof made + 1 + (unsigned char) trace[i + sizeof made];
+            ret.push_back({op, made});
+            continue;
+        }
+        if (op == TRACE_COPY) {
+            uint32_t made = read32(trace, i);
+            i += sizeof made;
+            id();
+            ret.push_back({op, made});
+            continue;
+        }
+        ret.push_back({op, id()});
+        if (op == TRACE_APPLY) {
+            i += sizeof(uint64_t);
+        }
+    }
+    if (i != trace.size()) {
+        ret.clear();
+    }
+    return ret;
+}
+
+static void freeMoves(alst_t *moves) {
+#ifdef CHESSLIB_QWORD_MOVE
+    alst_free(moves, NULL);
+#else
+    alst_free(moves, (void (*) (void *)) move_free);
+#endif
+}
+
+// makes every traced call once
+static void workload() {
+    board_t *b = board_make(STARTING_BOARD);
+    board_t *c = board_copy(b);
+    freeMoves(board_get_moves(b));  // board_get_moves_buf underneath is not recorded
+    move_t moves[BOARD_MOVES_MAX];
+    board_get_moves_buf(c, moves);
+#ifdef CHESSLIB_QWORD_MOVE
+    board_apply_move(c, moves[0]);
+#else
+    board_apply_move(c, &moves[0]);
+#endif
+    board_t s = *c;  // held by value
+    board_is_mate(&s);
+    board_is_stalemate(c);
+    board_to_fen(c);
+    board_free(b);
+    board_free(c);
+}
+
+TEST(TraceTest, RecordsClientCalls) {
+    ASSERT_EQ(trace_start(tracePath().c_str()), 0);
+    workload();
+    trace_stop();
+
+    std::vector<std::pair<int, uint32_t>> expected = {
+        {TRACE_MAKE, 1}, {TRACE_COPY, 2}, {TRACE_GET_MOVES, 1}, {TRACE_GET_MOVES_BUF, 2}, {TRACE_APPLY, 2},
+        {TRACE_IS_MATE, 0}, {TRACE_IS_STALEMATE, 2}, {TRACE_TO_FEN, 2}, {TRACE_FREE, 1}, {TRACE_FREE, 2}
+    };
+    EXPECT_EQ(parseTrace(readTrace()), expected);
+}
+
+TEST(TraceTest, NestedCallsNotRecorded) {
+    board_t *b = board_make(FEN_CHECK);  // board_is_mate generates moves when in check
+    ASSERT_EQ(trace_start(tracePath().c_str()), 0);
+    EXPECT_TRUE(board_is_mate(b));
+    trace_stop();
+    board_free(b);
+
+    std::vector<std::pair<int, uint32_t>> expected = {{TRACE_IS_MATE, 0}};  // made before the trace started
+    EXPECT_EQ(parseTrace(readTrace()), expected);
+}
+
+TEST(TraceTest, IdsRecycled) {
+    ASSERT_EQ(trace_start(tracePath().c_str()), 0);
+    board_t *a = board_make(STARTING_BOARD);
+    board_t *b = board_make(STARTING_BOARD);
+    board_free(a);
+    board_t *c = board_make(STARTING_BOARD);
+    board_free(b);
+    board_free(c);
+    trace_stop();
+
+    std::vector<std::pair<int, uint32_t>> expected = {
+        {TRACE_MAKE, 1}, {TRACE_MAKE, 2}, {TRACE_FREE, 1}, {TRACE_MAKE, 1}, {TRACE_FREE, 2}, {TRACE_FREE, 1}
+    };
+    EXPECT_EQ(parseTrace(readTrace()), expected);
+}
+
+TEST(TraceTest, StartWhileRecording) {
+    ASSERT_EQ(trace_start(tracePath().c_str()), 0);
+    EXPECT_NE(trace_start(tracePath().c_str()), 0);
+    trace_stop();
+    trace_stop();  // no-op
+    EXPECT_EQ(readTrace(), std::string(TRACE_MAGIC "\x24\0\0\0", TRACE_HEADER));
+}
+
+TEST(TraceTest, BoardsByValue) {
+    board_t *b = board_make(FEN_CHECK);
+    board_t s = *b;
+    ASSERT_EQ(trace_start(tracePath().c_str()), 0);
+    board_is_mate(&s);
+    trace_stop();
+    board_free(b);
+
+    // the ranks and flags of the board, whatever the layout of board_t
+    std::string trace = readTrace();
+    ASSERT_EQ(trace.size(), (size_t) TRACE_HEADER + 1 + 4 + TRACE_BOARD);
+    EXPECT_EQ(trace[TRACE_HEADER], TRACE_IS_MATE);
+    EXPECT_EQ(read32(trace, TRACE_HEADER + 1), 0u);
+    for (int rk = 0; rk < 8; ++rk) {
+        EXPECT_EQ(read32(trace, TRACE_HEADER + 5 + 4 * rk), s.ranks[rk]);
+    }
+    EXPECT_EQ(read32(trace, TRACE_HEADER + 5 + 32), s.flags);
+
+    uint64_t counts[TRACE_NOPS];
+    EXPECT_EQ(trace_replay(trace.data(), trace.size(), counts), 0);
+    EXPECT_EQ(counts[TRACE_IS_MATE], 1u);
+
+    // boards of another size are not replayed
+    trace[8] = 48;
+    EXPECT_NE(trace_replay(trace.data(), trace.size(), counts), 0);
+    EXPECT_EQ(counts[TRACE_IS_MATE], 0u);
+}
+
+TEST(TraceTest, Replay) {
+    ASSERT_EQ(trace_start(tracePath().c_str()), 0);
+    workload();
+    trace_stop();
+    std::string trace = readTrace();
+
+    uint64_t counts[TRACE_NOPS];
+    ASSERT_EQ(trace_replay(trace.data(), trace.size(), counts), 0);
+    EXPECT_EQ(counts[TRACE_MAKE], 1u);
+    EXPECT_EQ(counts[TRACE_COPY], 1u);
+    EXPECT_EQ(counts[TRACE_FREE], 2u);
+    EXPECT_EQ(counts[TRACE_APPLY], 1u);
+    EXPECT_EQ(counts[TRACE_GET_MOVES], 1u);
+    EXPECT_EQ(counts[TRACE_GET_MOVES_BUF], 1u);
+    EXPECT_EQ(counts[TRACE_IS_MATE], 1u);
+    EXPECT_EQ(counts[TRACE_IS_STALEMATE], 1u);
+    EXPECT_EQ(counts[TRACE_TO_FEN], 1u);
+
+    // truncated mid-record
+    EXPECT_NE(trace_replay(trace.data(), trace.size() - 1, counts), 0);
+    EXPECT_EQ(counts[TRACE_FREE], 1u);
+    // not a trace
+    EXPECT_NE(trace_replay("CHSTRC00", 8, counts), 0);
+    EXPECT_NE(trace_replay("CHSTRC01\x24\0\0\0", TRACE_HEADER, counts), 0);
+}
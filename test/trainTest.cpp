@@ -0,0 +1,168 @@
+extern "C" {
+#include "defs.h"
+#include "board.h"
+#include "move.h"
+#include "move16.h"
+#include "farm.h"
+#include "train.h"
+}
+#include "testutil.h"
+
+#include <gtest/gtest.h>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+TEST(TrainTest, Layout) {
+    // the layout of files, which readers such as NumPy rely on
+    EXPECT_EQ(sizeof(train_record_t), 48u);
+    EXPECT_EQ(offsetof(train_record_t, flags), 32u);
+    EXPECT_EQ(offsetof(train_record_t, score), 36u);
+    EXPECT_EQ(offsetof(train_record_t, move), 38u);
+    EXPECT_EQ(offsetof(train_record_t, player), 40u);
+    EXPECT_EQ(offsetof(train_record_t, result), 41u);
+    EXPECT_EQ(offsetof(train_record_t, ply), 42u);
+    EXPECT_EQ(offsetof(train_record_t, game), 44u);
+}
+
+TEST(TrainTest, RoundTrip) {
+    board_t *start = board_make("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -");
+    uint64_t state = 5;
+    const vector<move_t> moves = random_game(*start, 80, state);
+    const vector<board_t> boards = game_boards(*start, moves);
+    vector<int> scores;
+    for (int ply = 0; ply < (int) moves.size(); ++ply) {
+        scores.push_back(ply % 3 ? ply * 7 - 100 : TRAIN_NO_SCORE);
+    }
+    scores[1] = 100000;
+    scores[2] = -100000;
+
+    const string path = temp_file("train");
+    train_writer_t *writer = train_create(path.c_str());
+    ASSERT_NE(writer, nullptr);
+    EXPECT_EQ(train_write_game(writer, start, moves.data(), scores.data(), moves.size(), RESULT_BLACK_WINS, 9), 0);
+    EXPECT_EQ(train_write_game(writer, start, NULL, NULL, 0, RESULT_DRAW, 10), 0);
+    EXPECT_EQ(train_close(writer), 0);
+
+    train_file_t *file = train_open(path.c_str());
+    ASSERT_NE(file, nullptr);
+    ASSERT_EQ(file->len, moves.size() + 2);
+    for (size_t i = 0; i <= moves.size(); ++i) {
+        const train_record_t *record = &file->records[i];
+        board_t b;
+        move_t move;
+        ASSERT_EQ(train_board(record, &b, &move), 0);
+        EXPECT_EQ(move, i < moves.size() ? moves[i] : 0);
+        EXPECT_TRUE(same_board(b, boards[i])) << i;
+        EXPECT_EQ(record->player, FLAGS_BPLAYER(boards[i].flags) ? 1 : 0);
+        EXPECT_EQ(record->result, RESULT_BLACK_WINS);
+        EXPECT_EQ(record->ply, i);
+        EXPECT_EQ(record->game, 9u);
+        if (i == 1 || i == 2) {
+            EXPECT_EQ(record->score, i == 1 ? INT16_MAX : INT16_MIN + 1);
+        } else {
+            EXPECT_EQ(record->score, i < moves.size() ? scores[i] : TRAIN_NO_SCORE);
+        }
+    }
+    const train_record_t *last = &file->records[moves.size() + 1];
+    board_t b;
+    move_t move;
+    ASSERT_EQ(train_board(last, &b, &move), 0);
+    EXPECT_EQ(move, 0u);
+    EXPECT_TRUE(same_board(b, *start));
+
+    // a record of a board that is not valid is not restored: a piece beyond NOPC, or a king away from its flags
+    train_record_t bad = *last;
+    bad.ranks[4] = 0xcccccccd;
+    EXPECT_EQ(train_board(&bad, &b, &move), -1);
+    bad = *last;
+    bad.flags ^= 1 << 16;
+    EXPECT_EQ(train_board(&bad, &b, &move), -1);
+    EXPECT_EQ(last->game, 10u);
+    EXPECT_EQ(last->result, RESULT_DRAW);
+    train_free(file);
+
+    // a record cut short is not read
+    ASSERT_EQ(truncate(path.c_str(), 16 + 48 * 3 + 20), 0);
+    file = train_open(path.c_str());
+    ASSERT_NE(file, nullptr);
+    EXPECT_EQ(file->len, 3u);
+    train_free(file);
+
+    board_free(start);
+    unlink(path.c_str());
+}
+
+TEST(TrainTest, Errors) {
+    EXPECT_EQ(train_create("/nonexistent/records.bin"), nullptr);
+    EXPECT_EQ(train_open("/nonexistent/records.bin"), nullptr);
+    const string path = temp_file("train");
+    FILE *f = fopen(path.c_str(), "wb");
+    fputs("CLGA not records", f);
+    fclose(f);
+    EXPECT_EQ(train_open(path.c_str()), nullptr);
+    f = fopen(path.c_str(), "wb");
+    fputs("CLTR", f);
+    fclose(f);
+    EXPECT_EQ(train_open(path.c_str()), nullptr);
+    unlink(path.c_str());
+    train_free(NULL);
+}
+
+TEST(TrainTest, Farm) {
+    const string games = temp_file("train");
+    const string records = temp_file("train");
+    farm_config_t config = {8, 2, NULL, FARM_SEARCH, 40, 6, 0, 1, 0, 0, 11, 0, records.c_str()};
+    farm_stats_t stats;
+    ASSERT_EQ(farm_run(&config, games.c_str(), &stats), 0);
+
+    train_file_t *file = train_open(records.c_str());
+    ASSERT_NE(file, nullptr);
+    ASSERT_EQ(file->len, stats.plies + stats.games);
+    vector<int> seen(config.games);
+    uint64_t results[4] = {0};
+    board_t *start = board_make(STARTING_BOARD);
+    for (size_t i = 0; i < file->len;) {
+        // the records of a game are written together, from its starting position
+        const train_record_t *record = &file->records[i];
+        ASSERT_LT(record->game, config.games);
+        seen[record->game]++;
+        ++results[record->result];
+        board_t b;
+        move_t move;
+        ASSERT_EQ(train_board(record, &b, &move), 0);
+        EXPECT_TRUE(same_board(b, *start));
+        for (int ply = 0;; ++ply, ++i) {
+            record = &file->records[i];
+            ASSERT_EQ(record->ply, ply);
+            board_t cur;
+            ASSERT_EQ(train_board(record, &cur, &move), 0);
+            EXPECT_TRUE(same_board(cur, b));
+            EXPECT_EQ(record->score != TRAIN_NO_SCORE, move && ply >= config.openingplies);
+            if (!move) {
+                ++i;
+                break;
+            }
+            board_apply_move(&b, move);
+        }
+    }
+    for (uint64_t game = 0; game < config.games; ++game) {
+        EXPECT_EQ(seen[game], 1);
+    }
+    for (int result = 0; result < 4; ++result) {
+        EXPECT_EQ(results[result], stats.results[result]);
+    }
+    train_free(file);
+    board_free(start);
+
+    config.train = "/nonexistent/records.bin";
+    EXPECT_NE(farm_run(&config, games.c_str(), NULL), 0);
+    unlink(games.c_str());
+    unlink(records.c_str());
+}
@@ -0,0 +1,130 @@
+extern "C" {
+#include "defs.h"
+#include "move.h"
+#include "tt.h"
+}
+
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#define MOVE_E2E4 MVMAKE(POS('e', 2), POS('e', 4), NOPOS, WPAWN, WPAWN, NOPC)
+#define MOVE_G1F3 MVMAKE(POS('g', 1), POS('f', 3), NOPOS, WKNIGHT, WKNIGHT, NOPC)
+
+// hashes of distinct positions in the same bucket of a table with (mask)
+static uint64_t bucketHash(const tt_t *tt, uint64_t bucket, uint64_t n) {
+    return bucket | ((n + 1) << 40 & ~tt->mask);
+}
+
+TEST(TtTest, Make) {
+    tt_t *tt = tt_make(1, 0);
+    EXPECT_EQ(tt->bytes, 1u << 20);
+    EXPECT_EQ(tt->mask + 1, (1 << 20) / sizeof(tt_bucket_t));
+    EXPECT_EQ((uintptr_t) tt->buckets % 64, 0u);
+    EXPECT_EQ(tt_hashfull(tt), 0);
+    tt_free(tt);
+
+    tt = tt_make(3, 0);  // rounded down to a power of two
+    EXPECT_EQ(tt->bytes, 2u << 20);
+    tt_free(tt);
+
+    tt = tt_make(4, 1);  // huge pages are used if reserved, but the table works either way
+    tt_store(tt, 42, MOVE_E2E4, 10, 1, TT_EXACT);
+    tt_hit_t hit;
+    EXPECT_TRUE(tt_probe(tt, 42, &hit));
+    tt_free(tt);
+}
+
+TEST(TtTest, StoreProbe) {
+    tt_t *tt = tt_make(1, 0);
+    tt_hit_t hit;
+    EXPECT_FALSE(tt_probe(tt, 0x1234, &hit));
+    EXPECT_FALSE(tt_probe(tt, 0, &hit));  // cleared entries do not match hash 0
+
+    tt_store(tt, 0x1234, MOVE_E2E4, -150, 7, TT_LOWER);
+    ASSERT_TRUE(tt_probe(tt, 0x1234, &hit));
+    EXPECT_EQ(hit.move, TT_MOVE(MOVE_E2E4));
+    EXPECT_EQ(hit.score, -150);
+    EXPECT_EQ(hit.depth, 7);
+    EXPECT_EQ(hit.bound, TT_LOWER);
+    EXPECT_FALSE(tt_probe(tt, 0x1234 + tt->mask + 1, &hit));  // same bucket, other position
+
+    // moveless stores keep the stored move
+    tt_store(tt, 0x1234, 0, 40000, 300, TT_UPPER);
+    ASSERT_TRUE(tt_probe(tt, 0x1234, &hit));
+    EXPECT_EQ(hit.move, TT_MOVE(MOVE_E2E4));
+    EXPECT_EQ(hit.score, INT16_MAX);  // clamped
+    EXPECT_EQ(hit.depth, 255);
+    EXPECT_EQ(hit.bound, TT_UPPER);
+
+    tt_clear(tt);
+    EXPECT_FALSE(tt_probe(tt, 0x1234, &hit));
+    tt_free(tt);
+}
+
+TEST(TtTest, Replacement) {
+    tt_t *tt = tt_make(1, 0);
+    tt_hit_t hit;
+    for (uint64_t i = 0; i < TT_BUCKET; ++i) {  // fill a bucket, deepest last
+        tt_store(tt, bucketHash(tt, 5, i), MOVE_E2E4, 0, 10 + i, TT_EXACT);
+    }
+    for (uint64_t i = 0; i < TT_BUCKET; ++i) {
+        EXPECT_TRUE(tt_probe(tt, bucketHash(tt, 5, i), &hit));
+    }
+
+    // the shallowest entry makes room
+    tt_store(tt, bucketHash(tt, 5, TT_BUCKET), MOVE_G1F3, 0, 1, TT_EXACT);
+    EXPECT_FALSE(tt_probe(tt, bucketHash(tt, 5, 0), &hit));
+    EXPECT_TRUE(tt_probe(tt, bucketHash(tt, 5, TT_BUCKET), &hit));
+
+    // entries of older searches make room before deeper ones of the current search
+    tt_new_search(tt);
+    tt_store(tt, bucketHash(tt, 5, TT_BUCKET + 1), MOVE_G1F3, 0, 5, TT_EXACT);
+    tt_store(tt, bucketHash(tt, 5, TT_BUCKET + 2), MOVE_G1F3, 0, 5, TT_EXACT);
+    EXPECT_TRUE(tt_probe(tt, bucketHash(tt, 5, TT_BUCKET + 1), &hit));
+    EXPECT_TRUE(tt_probe(tt, bucketHash(tt, 5, TT_BUCKET + 2), &hit));
+    EXPECT_TRUE(tt_probe(tt, bucketHash(tt, 5, TT_BUCKET - 1), &hit));  // deepest of the old entries
+    tt_free(tt);
+}
+
+TEST(TtTest, Hashfull) {
+    tt_t *tt = tt_make(1, 0);
+    for (uint64_t b = 0; b < 250; ++b) {  // the sampled buckets
+        for (uint64_t i = 0; i < TT_BUCKET / 2; ++i) {
+            tt_store(tt, bucketHash(tt, b, i), MOVE_E2E4, 0, 1, TT_EXACT);
+        }
+    }
+    EXPECT_EQ(tt_hashfull(tt), 500);
+    tt_new_search(tt);
+    EXPECT_EQ(tt_hashfull(tt), 0);
+    tt_free(tt);
+}
+
+TEST(TtTest, Concurrent) {
+    // writers race on a handful of buckets; every hit must carry the data stored for its hash
+    tt_t *tt = tt_make(1, 0);
+    std::vector<std::thread> threads;
+    std::vector<int> bad(4, 0);
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([tt, t, &bad]() {
+            tt_hit_t hit;
+            for (uint64_t i = 0; i < 200000; ++i) {
+                uint64_t hash = bucketHash(tt, i % 4, (i * 7 + t) % 64);
+                int score = (int) (hash >> 40) % 1000;
+                tt_store(tt, hash, MOVE_E2E4, score, score % 200, TT_EXACT);
+                uint64_t other = bucketHash(tt, (i + 1) % 4, (i * 13 + t) % 64);
+                if (tt_probe(tt, other, &hit)) {
+                    bad[t] += hit.score != (int) (other >> 40) % 1000 || hit.depth != hit.score % 200;
+                }
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    for (int t = 0; t < 4; ++t) {
+        EXPECT_EQ(bad[t], 0);
+    }
+    tt_free(tt);
+}
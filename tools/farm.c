@@ -0,0 +1,96 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "farm.h"
+#include "epd.h"
+
+/**
+* Farms self-play games (see include/farm.h) into a file, one game per line, and reports the results and the
+* number of games per second.
+*
+* usage: farm [-n games] [-j threads] [-p random|weighted|search] [-d depth] [-N nodes] [-H ttmb] [-o openingplies]
+*             [-m maxplies] [-t temperature] [-s seed] [-f fen] [-g] [-r records] games.txt
+*
+* -g writes the games in PGN, and -r also writes their positions as training records (see include/train.h).
+*/
+
+#define USAGE "usage: %s [-n games] [-j threads] [-p random|weighted|search] [-d depth] [-N nodes] [-H ttmb] " \
+              "[-o openingplies] [-m maxplies] [-t temperature] [-s seed] [-f fen] [-g] [-r records] games.txt\n"
+
+static double _now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv) {
+    farm_config_t config;
+    memset(&config, 0, sizeof config);
+    config.games = 1000;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:j:p:d:N:H:o:m:t:s:f:gr:")) != -1) {
+        switch (opt) {
+            case 'n': config.games = strtoull(optarg, NULL, 10); break;
+            case 'j': config.threads = atoi(optarg); break;
+            case 'p':
+                if (!strcmp(optarg, "random")) {
+                    config.policy = FARM_RANDOM;
+                } else if (!strcmp(optarg, "weighted")) {
+                    config.policy = FARM_WEIGHTED;
+                } else if (!strcmp(optarg, "search")) {
+                    config.policy = FARM_SEARCH;
+                } else {
+                    fprintf(stderr, USAGE, argv[0]);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'd': config.depth = atoi(optarg); break;
+            case 'N': config.nodes = strtoull(optarg, NULL, 10); break;
+            case 'H': config.ttmb = strtoull(optarg, NULL, 10); break;
+            case 'o': config.openingplies = atoi(optarg); break;
+            case 'm': config.maxplies = atoi(optarg); break;
+            case 't': config.temperature = atoi(optarg); break;
+            case 's': config.seed = strtoull(optarg, NULL, 10); break;
+            case 'f': config.fen = optarg; break;
+            case 'g': config.pgn = 1; break;
+            case 'r': config.train = optarg; break;
+            default:
+                fprintf(stderr, USAGE, argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+    if (optind != argc - 1) {
+        fprintf(stderr, USAGE, argv[0]);
+        return EXIT_FAILURE;
+    }
+    board_t board;
+    if (config.fen && !epd_parse(config.fen, strlen(config.fen), &board)) {
+        fprintf(stderr, "invalid fen %s\n", config.fen);
+        return EXIT_FAILURE;
+    }
+
+    farm_stats_t stats;
+    const double start = _now();
+    if (farm_run(&config, argv[optind], &stats)) {
+        if (config.train) {
+            fprintf(stderr, "cannot write %s or %s\n", argv[optind], config.train);
+        } else {
+            fprintf(stderr, "cannot write %s\n", argv[optind]);
+        }
+        return EXIT_FAILURE;
+    }
+    const double elapsed = _now() - start;
+
+    printf("%llu games, %llu plies in %.2fs: %.0f games/s, %.0f plies/s\n", (unsigned long long) stats.games,
+           (unsigned long long) stats.plies, elapsed, stats.games / elapsed, stats.plies / elapsed);
+    for (int i = 0; i < 4; ++i) {
+        printf("%-8s %10llu\n", farm_result_str(i), (unsigned long long) stats.results[i]);
+    }
+    for (int i = 0; i < FARM_NREASONS; ++i) {
+        printf("%-11s %7llu\n", farm_reason_str(i), (unsigned long long) stats.reasons[i]);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,235 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "board.h"
+#include "perft.h"
+#include "epd.h"
+
+/**
+* Measures the per-call latency of move generation primitives over a corpus of positions (FEN or EPD, one per line),
+* and reports latency percentiles for every primitive, bucketed by the piece count of the position and whether the
+* player to move is in check.
+*
+* usage: latbench [-r reps] [-w warmup] corpus.epd
+*/
+
+#define USAGE "usage: %s [-r reps] [-w warmup] corpus.epd\n"
+
+// log-linear histogram: exact below 32ns, then 16 sub-buckets per power of two (at most 1/16 relative error)
+#define HIST_SUB 16
+#define HIST_LINEAR 32
+#define HIST_LEN (HIST_LINEAR + (64 - 5) * HIST_SUB)
+
+typedef struct {
+    uint64_t counts[HIST_LEN];
+    uint64_t n;
+    uint64_t max;
+} _hist_t;
+
+static int _hist_index(uint64_t v) {
+    if (v < HIST_LINEAR) {
+        return (int) v;
+    }
+    const int e = 63 - __builtin_clzll(v);  // >= 5
+    return HIST_LINEAR + (e - 5) * HIST_SUB + (int) ((v >> (e - 4)) & (HIST_SUB - 1));
+}
+
+// upper bound of the values recorded in a bucket
+static uint64_t _hist_value(int i) {
+    if (i < HIST_LINEAR) {
+        return i;
+    }
+    const int e = (i - HIST_LINEAR) / HIST_SUB + 5;
+    const uint64_t sub = (i - HIST_LINEAR) % HIST_SUB;
+    return ((HIST_SUB + sub + 1) << (e - 4)) - 1;
+}
+
+static void _hist_record(_hist_t *hist, uint64_t v) {
+    ++hist->counts[_hist_index(v)];
+    ++hist->n;
+    if (v > hist->max) {
+        hist->max = v;
+    }
+}
+
+static uint64_t _hist_percentile(const _hist_t *hist, double pct) {
+    uint64_t rank = (uint64_t) (hist->n * pct / 100.0);
+    if (rank >= hist->n) {
+        rank = hist->n - 1;
+    }
+    uint64_t seen = 0;
+    for (int i = 0; i < HIST_LEN; ++i) {
+        seen += hist->counts[i];
+        if (seen > rank) {
+            uint64_t v = _hist_value(i);
+            return v < hist->max ? v : hist->max;
+        }
+    }
+    return hist->max;
+}
+
+// position feature buckets
+#define NPIECE_BUCKETS 4
+#define NBUCKETS (NPIECE_BUCKETS * 2)
+static const char *_piece_bucket_names[NPIECE_BUCKETS] = {"2-8", "9-16", "17-24", "25-32"};
+
+typedef struct {
+    board_t board;
+    int bucket;
+} _bench_pos_t;
+
+// primitives under measurement
+#define NPRIMS 3
+static const char *_prim_names[NPRIMS] = {"board_get_moves", "board_get_moves_buf", "board_is_mate"};
+
+static inline uint64_t _now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static volatile size_t _sink;  // keeps the measured calls from being optimized away
+
+static uint64_t _bench_call(int prim, const board_t *board) {
+    move_t moves[BOARD_MOVES_MAX];
+    uint64_t start = _now_ns();
+    switch (prim) {
+        case 0: {
+            alst_t *list = board_get_moves(board);
+            _sink = list->len;
+#ifdef CHESSLIB_QWORD_MOVE
+            alst_free(list, NULL);
+#else
+            alst_free(list, (void (*) (void *)) move_free);
+#endif
+            break;
+        }
+        case 1:
+            _sink = board_get_moves_buf(board, moves);
+            break;
+        case 2:
+            _sink = board_is_mate(board);
+            break;
+    }
+    return _now_ns() - start;
+}
+
+static int _bench_bucket(const board_t *board) {
+    int pieces = board_count_pieces(board);
+    int incheck = !!board_in_check(board);
+    int pbucket = (pieces - 1) / 8;
+    if (pbucket < 0) {
+        pbucket = 0;
+    } else if (pbucket >= NPIECE_BUCKETS) {
+        pbucket = NPIECE_BUCKETS - 1;
+    }
+    return pbucket * 2 + incheck;
+}
+
+static void _bench_report_row(const char *label, const _hist_t *hist) {
+    if (!hist->n) {
+        return;
+    }
+    printf("  %-22s %10llu %8llu %8llu %8llu %8llu %8llu\n", label, (unsigned long long) hist->n,
+        (unsigned long long) _hist_percentile(hist, 50.0), (unsigned long long) _hist_percentile(hist, 90.0),
+        (unsigned long long) _hist_percentile(hist, 99.0), (unsigned long long) _hist_percentile(hist, 99.9),
+        (unsigned long long) hist->max);
+}
+
+int main(int argc, char **argv) {
+    int reps = 5;
+    int warmup = 1;
+    int opt;
+    while ((opt = getopt(argc, argv, "r:w:")) != -1) {
+        switch (opt) {
+            case 'r': reps = atoi(optarg); break;
+            case 'w': warmup = atoi(optarg); break;
+            default:
+                fprintf(stderr, USAGE, argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+    if (optind != argc - 1) {
+        fprintf(stderr, USAGE, argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    FILE *file = fopen(argv[optind], "r");
+    if (!file) {
+        fprintf(stderr, "cannot open %s\n", argv[optind]);
+        return EXIT_FAILURE;
+    }
+    size_t npos = 0;
+    size_t cap = 1024;
+    _bench_pos_t *pos = (_bench_pos_t *) malloc(cap * sizeof(_bench_pos_t));
+    if (!pos) {
+        fprintf(stderr, "malloc error in main\n");
+        exit(EXIT_FAILURE);
+    }
+    char buf[1024];
+    perft_epd_t epd;
+    size_t line = 0;
+    while (fgets(buf, sizeof buf, file)) {
+        ++line;
+        if (buf[0] == '\n' || buf[0] == '#' || buf[0] == '\0') {
+            continue;
+        }
+        board_t board;  // the position part of any epd line
+        if (perft_epd_parse(buf, &epd) || !epd_parse(epd.fen, strlen(epd.fen), &board)) {
+            fprintf(stderr, "malformed position on line %zu: %s", line, buf);
+            continue;
+        }
+        if (npos == cap) {
+            cap *= 2;
+            _bench_pos_t *grown = (_bench_pos_t *) realloc(pos, cap * sizeof(_bench_pos_t));
+            if (!grown) {
+                fprintf(stderr, "realloc error in main\n");
+                exit(EXIT_FAILURE);
+            }
+            pos = grown;
+        }
+        pos[npos].board = board;
+        pos[npos].bucket = _bench_bucket(&board);
+        ++npos;
+    }
+    fclose(file);
+    if (!npos) {
+        fprintf(stderr, "no positions in %s\n", argv[optind]);
+        free(pos);
+        return EXIT_FAILURE;
+    }
+
+    _hist_t *hists = (_hist_t *) calloc(NPRIMS * (NBUCKETS + 1), sizeof(_hist_t));  // per primitive: buckets, then all
+    if (!hists) {
+        fprintf(stderr, "calloc error in main\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int r = -warmup; r < reps; ++r) {
+        for (size_t i = 0; i < npos; ++i) {
+            for (int prim = 0; prim < NPRIMS; ++prim) {
+                uint64_t ns = _bench_call(prim, &pos[i].board);
+                if (r >= 0) {  // not warming up
+                    _hist_record(&hists[prim * (NBUCKETS + 1) + pos[i].bucket], ns);
+                    _hist_record(&hists[prim * (NBUCKETS + 1) + NBUCKETS], ns);
+                }
+            }
+        }
+    }
+
+    printf("%zu positions, %d reps; latencies in ns\n", npos, reps);
+    char label[64];
+    for (int prim = 0; prim < NPRIMS; ++prim) {
+        printf("\n%s\n  %-22s %10s %8s %8s %8s %8s %8s\n", _prim_names[prim], "pieces / check", "calls", "p50", "p90", "p99", "p99.9", "max");
+        for (int b = 0; b < NBUCKETS; ++b) {
+            snprintf(label, sizeof label, "%s %s", _piece_bucket_names[b / 2], (b % 2) ? "in check" : "quiet");
+            _bench_report_row(label, &hists[prim * (NBUCKETS + 1) + b]);
+        }
+        _bench_report_row("all", &hists[prim * (NBUCKETS + 1) + NBUCKETS]);
+    }
+    free(hists);
+    free(pos);
+    return EXIT_SUCCESS;
+}
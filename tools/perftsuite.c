@@ -0,0 +1,207 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "board.h"
+#include "perft.h"
+#include "epd.h"
+
+/**
+* Runs a perft EPD suite (one position per line, annotated ';D1 n ;D2 n ...') across a pool of threads,
+* verifying every annotated count up to a depth / node budget, and reports per-position timing and
+* aggregate nodes per second.
+*
+* usage: perftsuite [-j threads] [-d maxdepth] [-n maxnodes] [-q] file.epd
+*/
+
+#define USAGE "usage: %s [-j threads] [-d maxdepth] [-n maxnodes] [-q] file.epd\n"
+
+typedef struct {
+    perft_epd_t epd;
+    board_t board;  // the position of (epd)
+    size_t line;  // 1-indexed line in the suite file
+    int depth;  // deepest depth verified
+    int failed;  // depth of the first mismatched count, 0 if all matched
+    uint64_t got;  // the mismatched count, if failed
+    uint64_t nodes;  // leaves counted over all verified depths
+    double secs;
+} _suite_pos_t;
+
+typedef struct {
+    _suite_pos_t *pos;
+    size_t npos;
+    size_t next;  // next unclaimed position
+    size_t done;
+    int maxdepth;
+    uint64_t maxnodes;
+    int quiet;
+    pthread_mutex_t lock;
+} _suite_t;
+
+static double _now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void _suite_run_pos(const _suite_t *suite, _suite_pos_t *pos) {
+    const board_t *board = &pos->board;
+    double start = _now();
+    for (int d = 1; d <= pos->epd.maxdepth && d <= suite->maxdepth; ++d) {
+        if (!pos->epd.counts[d] || pos->epd.counts[d] > suite->maxnodes) {
+            continue;  // unannotated, or over budget
+        }
+        uint64_t ct = perft_count(board, d);
+        pos->nodes += ct;
+        pos->depth = d;
+        if (ct != pos->epd.counts[d]) {
+            pos->failed = d;
+            pos->got = ct;
+            break;
+        }
+    }
+    pos->secs = _now() - start;
+}
+
+static void *_suite_worker(void *arg) {
+    _suite_t *suite = (_suite_t *) arg;
+    for (;;) {
+        pthread_mutex_lock(&suite->lock);
+        size_t i = suite->next++;
+        pthread_mutex_unlock(&suite->lock);
+        if (i >= suite->npos) {
+            break;
+        }
+        _suite_pos_t *pos = &suite->pos[i];
+        _suite_run_pos(suite, pos);
+
+        pthread_mutex_lock(&suite->lock);
+        ++suite->done;
+        if (pos->failed) {
+            printf("[%zu/%zu] FAIL line %zu D%d expected %llu got %llu: %s\n", suite->done, suite->npos, pos->line, pos->failed,
+                (unsigned long long) pos->epd.counts[pos->failed], (unsigned long long) pos->got, pos->epd.fen);
+        } else if (!suite->quiet) {
+            printf("[%zu/%zu] ok   line %zu D%d %llu nodes %.3fs %.0f nps: %s\n", suite->done, suite->npos, pos->line, pos->depth,
+                (unsigned long long) pos->nodes, pos->secs, pos->secs > 0 ? pos->nodes / pos->secs : 0.0, pos->epd.fen);
+        }
+        fflush(stdout);
+        pthread_mutex_unlock(&suite->lock);
+    }
+    return NULL;
+}
+
+static int _suite_load(_suite_t *suite, FILE *file) {
+    size_t cap = 1024;
+    suite->pos = (_suite_pos_t *) malloc(cap * sizeof(_suite_pos_t));
+    if (!suite->pos) {
+        fprintf(stderr, "malloc error in _suite_load\n");
+        exit(EXIT_FAILURE);
+    }
+    char buf[1024];
+    size_t line = 0;
+    while (fgets(buf, sizeof buf, file)) {
+        ++line;
+        const char *p = buf;
+        while (*p == ' ' || *p == '\t') {
+            ++p;
+        }
+        if (*p == '\0' || *p == '\n' || *p == '\r' || *p == '#') {  // blank or comment
+            continue;
+        }
+        if (suite->npos == cap) {
+            cap *= 2;
+            _suite_pos_t *grown = (_suite_pos_t *) realloc(suite->pos, cap * sizeof(_suite_pos_t));
+            if (!grown) {
+                fprintf(stderr, "realloc error in _suite_load\n");
+                exit(EXIT_FAILURE);
+            }
+            suite->pos = grown;
+        }
+        _suite_pos_t *pos = &suite->pos[suite->npos];
+        memset(pos, 0, sizeof(_suite_pos_t));
+        pos->line = line;
+        if (perft_epd_parse(buf, &pos->epd) || !epd_parse(pos->epd.fen, strlen(pos->epd.fen), &pos->board)) {
+            fprintf(stderr, "malformed epd on line %zu: %s", line, buf);
+            return 1;
+        }
+        ++suite->npos;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    long nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+    _suite_t suite;
+    memset(&suite, 0, sizeof suite);
+    suite.maxdepth = PERFT_MAX_DEPTH;
+    suite.maxnodes = UINT64_MAX;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "j:d:n:q")) != -1) {
+        switch (opt) {
+            case 'j': nthreads = atol(optarg); break;
+            case 'd': suite.maxdepth = atoi(optarg); break;
+            case 'n': suite.maxnodes = strtoull(optarg, NULL, 10); break;
+            case 'q': suite.quiet = 1; break;
+            default:
+                fprintf(stderr, USAGE, argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+    if (optind != argc - 1) {
+        fprintf(stderr, USAGE, argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (nthreads < 1) {
+        nthreads = 1;
+    }
+
+    FILE *file = fopen(argv[optind], "r");
+    if (!file) {
+        fprintf(stderr, "cannot open %s\n", argv[optind]);
+        return EXIT_FAILURE;
+    }
+    int bad = _suite_load(&suite, file);
+    fclose(file);
+    if (bad) {
+        free(suite.pos);
+        return EXIT_FAILURE;
+    }
+
+    pthread_mutex_init(&suite.lock, NULL);
+    pthread_t *threads = (pthread_t *) malloc(nthreads * sizeof(pthread_t));
+    if (!threads) {
+        fprintf(stderr, "malloc error in main\n");
+        exit(EXIT_FAILURE);
+    }
+    double start = _now();
+    for (long i = 0; i < nthreads; ++i) {
+        if (pthread_create(&threads[i], NULL, _suite_worker, &suite)) {
+            fprintf(stderr, "pthread_create error in main\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    for (long i = 0; i < nthreads; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+    double wall = _now() - start;
+    pthread_mutex_destroy(&suite.lock);
+    free(threads);
+
+    size_t nfailed = 0;
+    uint64_t nodes = 0;
+    double cpu = 0.0;
+    for (size_t i = 0; i < suite.npos; ++i) {
+        nfailed += !!suite.pos[i].failed;
+        nodes += suite.pos[i].nodes;
+        cpu += suite.pos[i].secs;
+    }
+    printf("%zu positions, %zu failed, %llu nodes in %.3fs on %ld threads; %.0f nps (%.0f nps per thread)\n",
+        suite.npos, nfailed, (unsigned long long) nodes, wall, nthreads,
+        wall > 0 ? nodes / wall : 0.0, cpu > 0 ? nodes / cpu : 0.0);
+    free(suite.pos);
+    return nfailed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
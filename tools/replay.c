@@ -0,0 +1,92 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "trace.h"
+
+/**
+* Re-executes a library call trace (see include/trace.h) and reports the throughput of the replayed calls.
+* The trace is read into memory up front, so only the library calls are timed.
+*
+* usage: replay [-r reps] trace.bin
+*/
+
+#define USAGE "usage: %s [-r reps] trace.bin\n"
+
+static const char *_op_names[TRACE_NOPS] = {
+    "board_make", "board_copy", "board_free", "board_apply_move", "board_get_moves", "board_get_moves_buf",
+    "board_is_mate", "board_is_stalemate", "board_to_fen"
+};
+
+static double _now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv) {
+    int reps = 1;
+    int opt;
+    while ((opt = getopt(argc, argv, "r:")) != -1) {
+        switch (opt) {
+            case 'r': reps = atoi(optarg); break;
+            default:
+                fprintf(stderr, USAGE, argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+    if (optind != argc - 1 || reps < 1) {
+        fprintf(stderr, USAGE, argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    FILE *file = fopen(argv[optind], "rb");
+    if (!file) {
+        fprintf(stderr, "cannot open %s\n", argv[optind]);
+        return EXIT_FAILURE;
+    }
+    fseek(file, 0, SEEK_END);
+    long len = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char *trace = (char *) malloc(len > 0 ? len : 1);
+    if (!trace) {
+        fprintf(stderr, "malloc error in main\n");
+        exit(EXIT_FAILURE);
+    }
+    if (len < 0 || fread(trace, 1, len, file) != (size_t) len) {
+        fprintf(stderr, "cannot read %s\n", argv[optind]);
+        fclose(file);
+        free(trace);
+        return EXIT_FAILURE;
+    }
+    fclose(file);
+
+    uint64_t counts[TRACE_NOPS];
+    double best = 0;
+    for (int r = 0; r < reps; ++r) {
+        double start = _now();
+        int malformed = trace_replay(trace, len, counts);
+        double elapsed = _now() - start;
+        if (malformed) {
+            fprintf(stderr, "malformed trace %s, replayed up to the first bad record\n", argv[optind]);
+            free(trace);
+            return EXIT_FAILURE;
+        }
+        if (!r || elapsed < best) {
+            best = elapsed;
+        }
+    }
+    free(trace);
+
+    uint64_t total = 0;
+    for (int op = 0; op < TRACE_NOPS; ++op) {
+        if (counts[op]) {
+            printf("%-20s %12llu\n", _op_names[op], (unsigned long long) counts[op]);
+        }
+        total += counts[op];
+    }
+    printf("%llu calls in %.3fs (best of %d), %.0f calls/s\n", (unsigned long long) total, best, reps,
+        best > 0 ? total / best : 0.0);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,295 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <stdarg.h>
+#include <pthread.h>
+
+#include "board.h"
+#include "move.h"
+#include "search.h"
+#include "tt.h"
+#include "epd.h"
+
+/**
+* A UCI engine on the library's search (see include/search.h), for tournament managers and GUIs.
+* Commands are read on the main thread while a search runs on another, so "isready" and "stop" are answered at
+* once during a search; a stopped search reports its best move within SEARCH_CHECK_NODES nodes.
+* Draws by repetition are not detected, as boards do not track their history. A "position" command with an invalid
+* FEN or an illegal move is reported and leaves the position as it was.
+*
+* usage: uci
+*/
+
+#define NAME "chesslib"
+#define AUTHOR "chesslib authors"
+
+#define HASH_DEFAULT 16
+#define HASH_MAX 65536
+#define THREADS_MAX 256
+#define OVERHEAD_DEFAULT 30
+#define OVERHEAD_MAX 5000
+
+typedef struct {
+    board_t board;  // position to search
+    search_limits_t limits;
+    int infinite;  // report the best move only once stopped
+    int stop;
+    int searching;  // a search thread is to be joined
+    pthread_t thread;
+    pthread_mutex_t lock;  // guards stop and output
+    pthread_cond_t stopped;
+} _engine_t;
+
+static tt_t *_tt;
+static int _threads = 1;
+static uint64_t _overhead_ms = OVERHEAD_DEFAULT;
+
+// writes a line of output, which the search thread and the main thread share
+__attribute__((format(printf, 2, 3))) static void _send(_engine_t *engine, const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    pthread_mutex_lock(&engine->lock);
+    vprintf(fmt, args);
+    putchar('\n');
+    fflush(stdout);
+    pthread_mutex_unlock(&engine->lock);
+    va_end(args);
+}
+
+// returns the legal move of the board in UCI notation (str), 0 if there is none
+static move_t _move_parse(const board_t *board, const char *str) {
+    move_t moves[BOARD_MOVES_MAX];
+    const size_t len = board_get_moves_buf(board, moves);
+    char buf[6];
+    for (size_t i = 0; i < len; ++i) {
+        move_uci(moves[i], buf);
+        if (!strcmp(buf, str)) {
+            return moves[i];
+        }
+    }
+    return 0;
+}
+
+static void _send_result(_engine_t *engine, const search_result_t *result) {
+    char score[32];
+    if (result->score > SEARCH_MATE_BOUND) {
+        snprintf(score, sizeof score, "mate %d", (SEARCH_MATE - result->score + 1) / 2);
+    } else if (result->score < -SEARCH_MATE_BOUND) {
+        snprintf(score, sizeof score, "mate %d", -(SEARCH_MATE + result->score) / 2);
+    } else {
+        snprintf(score, sizeof score, "cp %d", result->score);
+    }
+    char pv[SEARCH_MAX_PLY * 6 + 1] = "";
+    char buf[6];
+    for (int i = 0; i < result->pvlen; ++i) {
+        move_uci(result->pv[i], buf);
+        strcat(pv, " ");
+        strcat(pv, buf);
+    }
+    const uint64_t nps = result->time_ms ? result->nodes * 1000 / result->time_ms : 0;
+    _send(engine, "info depth %d score %s nodes %llu nps %llu time %llu pv%s", result->depth, score,
+          (unsigned long long) result->nodes, (unsigned long long) nps, (unsigned long long) result->time_ms, pv);
+}
+
+static void *_search_thread(void *arg) {
+    _engine_t *engine = (_engine_t *) arg;
+    search_result_t result;
+    memset(&result, 0, sizeof result);
+    search(&engine->board, &engine->limits, &result);
+    if (result.best) {
+        _send_result(engine, &result);
+    }
+
+    // under "go infinite", the best move waits for "stop"
+    pthread_mutex_lock(&engine->lock);
+    while (engine->infinite && !engine->stop) {
+        pthread_cond_wait(&engine->stopped, &engine->lock);
+    }
+    pthread_mutex_unlock(&engine->lock);
+    char buf[6] = "0000";
+    if (result.best) {
+        move_uci(result.best, buf);
+    }
+    _send(engine, "bestmove %s", buf);
+    return NULL;
+}
+
+static void _stop(_engine_t *engine) {
+    if (!engine->searching) {
+        return;
+    }
+    pthread_mutex_lock(&engine->lock);
+    search_signal(&engine->stop);
+    pthread_cond_signal(&engine->stopped);
+    pthread_mutex_unlock(&engine->lock);
+    pthread_join(engine->thread, NULL);
+    engine->searching = 0;
+}
+
+static void _go(_engine_t *engine, char *args) {
+    _stop(engine);
+    uint64_t time[2] = {0, 0};
+    uint64_t inc[2] = {0, 0};
+    int movestogo = 0;
+    memset(&engine->limits, 0, sizeof engine->limits);
+    engine->infinite = 0;
+    for (char *tok = strtok(args, " \t\n"); tok; tok = strtok(NULL, " \t\n")) {
+        if (!strcmp(tok, "infinite") || !strcmp(tok, "ponder")) {
+            engine->infinite = 1;
+            continue;
+        }
+        char *val = strtok(NULL, " \t\n");
+        if (!val) {
+            break;
+        }
+        const uint64_t n = atoll(val) > 0 ? (uint64_t) atoll(val) : 0;
+        if (!strcmp(tok, "wtime")) time[0] = n;
+        else if (!strcmp(tok, "btime")) time[1] = n;
+        else if (!strcmp(tok, "winc")) inc[0] = n;
+        else if (!strcmp(tok, "binc")) inc[1] = n;
+        else if (!strcmp(tok, "movestogo")) movestogo = n;
+        else if (!strcmp(tok, "depth")) engine->limits.depth = n < SEARCH_MAX_PLY ? n : SEARCH_MAX_PLY - 1;
+        else if (!strcmp(tok, "nodes")) engine->limits.nodes = n;
+        else if (!strcmp(tok, "movetime")) engine->limits.movetime_ms = n > _overhead_ms ? n - _overhead_ms : 1;
+    }
+    const int player = FLAGS_BPLAYER(engine->board.flags);
+    if (time[player] && !engine->infinite) {
+        search_limits_clock(&engine->limits, time[player], inc[player], movestogo, _overhead_ms);
+    }
+    engine->limits.tt = _tt;
+    engine->limits.threads = _threads;
+    engine->limits.stop = &engine->stop;
+    engine->stop = 0;
+    if (pthread_create(&engine->thread, NULL, _search_thread, engine)) {
+        fprintf(stderr, "pthread_create error in _go\n");
+        exit(EXIT_FAILURE);
+    }
+    engine->searching = 1;
+}
+
+static void _position(_engine_t *engine, char *args) {
+    _stop(engine);
+    args[strcspn(args, "\r\n")] = '\0';
+    char *moves = strstr(args, " moves");
+    if (moves) {
+        *moves = '\0';
+        moves += strlen(" moves");
+    }
+    // the FEN is validated, as board_make does not; a position that cannot be set keeps the previous one
+    board_t board;
+    char *tok = strtok(args, " \t");
+    const char *fen = STARTING_BOARD;
+    if (tok && !strcmp(tok, "fen")) {
+        fen = strtok(NULL, "");
+        fen = fen ? fen : "";
+    } else if (!tok || strcmp(tok, "startpos")) {
+        fprintf(stderr, "invalid position\n");
+        return;
+    }
+    while (*fen == ' ' || *fen == '\t') {
+        ++fen;
+    }
+    if (!epd_parse(fen, strlen(fen), &board)) {
+        fprintf(stderr, "invalid fen %s\n", fen);
+        return;
+    }
+    if (moves) {
+        for (tok = strtok(moves, " \t"); tok; tok = strtok(NULL, " \t")) {
+            const move_t move = _move_parse(&board, tok);
+            if (!move) {
+                fprintf(stderr, "illegal move %s\n", tok);
+                return;
+            }
+            board_apply_move(&board, move);
+        }
+    }
+    engine->board = board;
+}
+
+static void _setoption(_engine_t *engine, char *args) {
+    _stop(engine);
+    char *name = strstr(args, "name ");
+    if (!name) {
+        return;
+    }
+    name += strlen("name ");
+    char *value = strstr(name, " value ");
+    if (value) {
+        *value = '\0';
+        value += strlen(" value ");
+        value[strcspn(value, "\r\n")] = '\0';
+    }
+    name[strcspn(name, "\r\n")] = '\0';
+    if (!strcasecmp(name, "Hash") && value) {
+        const long mb = atol(value);
+        tt_free(_tt);
+        _tt = tt_make(mb < 1 ? 1 : mb > HASH_MAX ? HASH_MAX : mb, 1);
+    } else if (!strcasecmp(name, "Threads") && value) {
+        const int n = atoi(value);
+        _threads = n < 1 ? 1 : n > THREADS_MAX ? THREADS_MAX : n;
+    } else if (!strcasecmp(name, "Move Overhead") && value) {
+        const long ms = atol(value);
+        _overhead_ms = ms < 0 ? 0 : ms > OVERHEAD_MAX ? OVERHEAD_MAX : ms;
+    } else if (!strcasecmp(name, "Clear Hash")) {
+        tt_clear(_tt);
+    }
+}
+
+int main(void) {
+    _engine_t engine;
+    memset(&engine, 0, sizeof engine);
+    pthread_mutex_init(&engine.lock, NULL);
+    pthread_cond_init(&engine.stopped, NULL);
+    board_t *board = board_make(STARTING_BOARD);
+    engine.board = *board;
+    board_free(board);
+    _tt = tt_make(HASH_DEFAULT, 1);
+
+    char *line = NULL;
+    size_t cap = 0;
+    while (getline(&line, &cap, stdin) != -1) {
+        char *cmd = line + strspn(line, " \t\r\n");
+        char *args = cmd + strcspn(cmd, " \t\r\n");
+        if (*args) {
+            *args++ = '\0';
+        }
+        if (!strcmp(cmd, "uci")) {
+            _send(&engine, "id name " NAME "\nid author " AUTHOR);
+            _send(&engine, "option name Hash type spin default %d min 1 max %d", HASH_DEFAULT, HASH_MAX);
+            _send(&engine, "option name Clear Hash type button");
+            _send(&engine, "option name Threads type spin default 1 min 1 max %d", THREADS_MAX);
+            _send(&engine, "option name Move Overhead type spin default %d min 0 max %d", OVERHEAD_DEFAULT,
+                  OVERHEAD_MAX);
+            _send(&engine, "uciok");
+        } else if (!strcmp(cmd, "isready")) {
+            _send(&engine, "readyok");
+        } else if (!strcmp(cmd, "ucinewgame")) {
+            _stop(&engine);
+            tt_clear(_tt);
+        } else if (!strcmp(cmd, "position")) {
+            _position(&engine, args);
+        } else if (!strcmp(cmd, "go")) {
+            _go(&engine, args);
+        } else if (!strcmp(cmd, "stop")) {
+            _stop(&engine);
+        } else if (!strcmp(cmd, "ponderhit")) {
+            // searches under "go ponder" run without time limits, so the move pondered is played at once
+            pthread_mutex_lock(&engine.lock);
+            engine.infinite = 0;
+            search_signal(&engine.stop);
+            pthread_cond_signal(&engine.stopped);
+            pthread_mutex_unlock(&engine.lock);
+        } else if (!strcmp(cmd, "setoption")) {
+            _setoption(&engine, args);
+        } else if (!strcmp(cmd, "quit")) {
+            break;
+        }
+    }
+    _stop(&engine);
+    free(line);
+    tt_free(_tt);
+    pthread_cond_destroy(&engine.stopped);
+    pthread_mutex_destroy(&engine.lock);
+    return EXIT_SUCCESS;
+}